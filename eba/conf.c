@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <os.h>
 #include <xalloc.h>
 #include <io_lib/Read.h>
@@ -305,23 +306,79 @@ void rescale_scores(Read *r, int table) {
  * by other max area
  */
 
-float get_area(TRACE *trace, int startp, int endp, int offset)
-{
+/*
+ * Work buffer management. Returns 0 for success, -1 for failure.
+ */
+static int scratch_points(EBA_SCRATCH *s, int npoints) {
+    if (npoints > s->npoints) {
+	int n = MAX(npoints, 2 * s->npoints);
+	xfree(s->cum);
+	xfree(s->filt);
+	s->cum  = (double *)xmalloc(4 * (n+1) * sizeof(double));
+	s->filt = (int *)xmalloc(n * sizeof(int));
+	if (!s->cum || !s->filt) {
+	    xfree(s->cum);
+	    xfree(s->filt);
+	    s->cum = NULL;
+	    s->filt = NULL;
+	    s->npoints = 0;
+	    return -1;
+	}
+	s->npoints = n;
+    }
+    return 0;
+}
+
+static int scratch_bases(EBA_SCRATCH *s, int nbases) {
+    if (nbases > s->nbases) {
+	int n = MAX(nbases, 2 * s->nbases);
+	xfree(s->conf);
+	if (NULL == (s->conf = (char *)xmalloc(n))) {
+	    s->nbases = 0;
+	    return -1;
+	}
+	s->nbases = n;
+    }
+    return 0;
+}
+
+void free_eba_scratch(EBA_SCRATCH *s) {
+    xfree(s->cum);
+    xfree(s->filt);
+    xfree(s->conf);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Fills cum[0..npoints] with the running total of trace, so that the area
+ * of samples startp to endp-1 is cum[endp]-cum[startp].
+ */
+static void cumulate_trace(double *cum, TRACE *trace, int npoints) {
     int i;
+    double sum = 0;
+
+    cum[0] = 0;
+    for (i = 0; i < npoints; i++)
+	cum[i+1] = (sum += trace[i]);
+}
+
+float get_area(double *cum, int startp, int endp, int offset)
+{
     float sum=1.0e-10;
-    
-    for (i=startp; i<endp; i++)
-	sum += trace[i];
+
+    if (endp > startp)
+	sum += (float)(cum[endp] - cum[startp]);
   
     return(sum + offset);
 }
 
-float max_area(TRACE *tx, TRACE *ty, TRACE *tz , int stp, int endp, int offset)
+float max_area(double *cx, double *cy, double *cz, int stp, int endp,
+	       int offset)
 {
     float x,y,z;
-    x = get_area(tx,stp,endp,offset);
-    y = get_area(ty,stp,endp,offset);
-    z = get_area(tz,stp,endp,offset);
+    x = get_area(cx,stp,endp,offset);
+    y = get_area(cy,stp,endp,offset);
+    z = get_area(cz,stp,endp,offset);
     
     if (x > y) {
 	if (z > x) {
@@ -391,10 +448,12 @@ char probFromQual(float qual)
  * Equivalent to 1st-order differentiation followed by fitting a +-1 square
  * wave of width 11.
  */
-void filter_trace(Read *r) {
+int filter_trace(Read *r, EBA_SCRATCH *s) {
     int *tmp, i, j;
     
-    tmp = (int *)calloc(r->NPoints, sizeof(int));
+    if (scratch_points(s, r->NPoints))
+	return -1;
+    tmp = s->filt;
     for (j = 0; j < 4; j++) {
 	TRACE *t;
 	switch (j) {
@@ -417,7 +476,8 @@ void filter_trace(Read *r) {
 	for (i = 5; i < r->NPoints-5; i++)
 	    t[i] = tmp[i] > 0 ? tmp[i] : 0;
     }
-    xfree(tmp);
+
+    return 0;
 }
 
 
@@ -425,15 +485,15 @@ void filter_trace(Read *r) {
  * Averages the confidence arrays in r over a window of length
  * WINDOW_SIZE (#define at top).
  */
-int average_conf(Read *r) {
+int average_conf(Read *r, EBA_SCRATCH *s) {
     char val, *conf_buf;
     double total;
     int i;
     
     /* Create a temp. copy of the confidence values */
-    if (NULL == (conf_buf = (char *)xcalloc(r->NBases, 1))) {
+    if (scratch_bases(s, r->NBases))
 	return -1;
-    }
+    conf_buf = s->conf;
 
     for (i = 0; i < r->NBases; i++) {
 	switch((r->base)[i]) {
@@ -547,15 +607,32 @@ int average_conf(Read *r) {
 	}
     }
     
-    xfree(conf_buf);
-
     return 0;
 }
 
 
-void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
+int calc_conf_values(Read *r, int phred_scale, int cosa, int offset,
+		     EBA_SCRATCH *s) {
     int i;
     int pos,start_pos,end_pos;
+    double *cA = NULL, *cC = NULL, *cG = NULL, *cT = NULL;
+
+    /*
+     * Areas are taken from running totals of each trace, computed once,
+     * rather than by summing the samples around every base.
+     */
+    if (!cosa) {
+	if (scratch_points(s, r->NPoints))
+	    return -1;
+	cA = s->cum;
+	cC = cA + r->NPoints + 1;
+	cG = cC + r->NPoints + 1;
+	cT = cG + r->NPoints + 1;
+	cumulate_trace(cA, r->traceA, r->NPoints);
+	cumulate_trace(cC, r->traceC, r->NPoints);
+	cumulate_trace(cG, r->traceG, r->NPoints);
+	cumulate_trace(cT, r->traceT, r->NPoints);
+    }
 
     /*
      * Set confidence values for first and last bases to zero to simplify
@@ -581,6 +658,10 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 
 	start_pos = (r->basePos)[i]-((r->basePos)[i] - (r->basePos[i-1])) /2;
 	end_pos   = (r->basePos)[i]+((r->basePos)[i+1] - (r->basePos[i])) /2;
+	if (start_pos < 0)
+	    start_pos = 0;
+	if (end_pos > r->NPoints)
+	    end_pos = r->NPoints;
 
 	switch ((r->base)[i]) {
 	case 'A':
@@ -589,9 +670,9 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 		? probFromQual((max_cosa(r->traceC, r->traceG, r->traceT, pos,
 					 offset)/
 				get_cosa(r->traceA, pos, offset)))
-		: probFromQual((max_area(r->traceC, r->traceG, r->traceT,
+		: probFromQual((max_area(cC, cG, cT,
 					 start_pos, end_pos, offset) /
-				get_area(r->traceA, start_pos, end_pos,
+				get_area(cA, start_pos, end_pos,
 					 offset)));
 	    break;
 
@@ -601,9 +682,9 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 		? probFromQual((max_cosa(r->traceA, r->traceG, r->traceT, pos,
 					 offset)/
 				get_cosa(r->traceC, pos, offset)))
-		: probFromQual((max_area(r->traceA, r->traceG, r->traceT,
+		: probFromQual((max_area(cA, cG, cT,
 					 start_pos, end_pos, offset) /
-				get_area(r->traceC, start_pos, end_pos,
+				get_area(cC, start_pos, end_pos,
 					 offset)));
 	    break;
 	    
@@ -613,9 +694,9 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 		? probFromQual((max_cosa(r->traceC, r->traceA, r->traceT, pos,
 					 offset)/
 				get_cosa(r->traceG, pos, offset)))
-		: probFromQual((max_area(r->traceC, r->traceA, r->traceT,
+		: probFromQual((max_area(cC, cA, cT,
 					 start_pos, end_pos, offset) /
-				get_area(r->traceG, start_pos, end_pos,
+				get_area(cG, start_pos, end_pos,
 					 offset)));
 	    break;
 
@@ -625,9 +706,9 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 		? probFromQual((max_cosa(r->traceC, r->traceG, r->traceA, pos,
 					 offset)/
 				get_cosa(r->traceT, pos, offset)))
-		: probFromQual((max_area(r->traceC, r->traceG, r->traceA,
+		: probFromQual((max_area(cC, cG, cA,
 					 start_pos, end_pos, offset) /
-				get_area(r->traceT, start_pos, end_pos,
+				get_area(cT, start_pos, end_pos,
 					 offset)));
 	    break;
 
@@ -648,6 +729,6 @@ void calc_conf_values(Read *r, int phred_scale, int cosa, int offset) {
 	(r->prob_T)[r->NBases-1] = (r->prob_T)[r->NBases-2];
     }
 
-    return;
+    return 0;
 }
 
@@ -1,5 +1,21 @@
 #include <io_lib/scf.h>
 
+/*
+ * Work buffers for the routines below. These are kept from one trace to the
+ * next and only grown when a longer trace comes along, so that processing
+ * many traces in one run is not dominated by allocation.
+ * Zero before first use and release with free_eba_scratch().
+ */
+typedef struct {
+    double *cum;	/* cumulative trace totals, 4 * (npoints+1) */
+    int    *filt;	/* filter_trace() workspace, npoints */
+    char   *conf;	/* average_conf() workspace, nbases */
+    int     npoints;	/* allocated number of samples */
+    int     nbases;	/* allocated number of bases */
+} EBA_SCRATCH;
+
+void free_eba_scratch(EBA_SCRATCH *s);
+
 /*
  * MODULE    SeqQual12
  *
@@ -17,14 +33,17 @@
  *
  * cosarea indicates whether to use a raised cosine (width = +/- 5 samples)
  * instead of a square for computing the trace area.
+ *
+ * Returns 0 for success, -1 if the work buffers could not be allocated.
  */
-void calc_conf_values(Read *r, int phred_scale, int average_qual, int offset);
+int calc_conf_values(Read *r, int phred_scale, int average_qual, int offset,
+		     EBA_SCRATCH *s);
 
 /*
  * Averages the confidence arrays in r over a window of length
  * WINDOW_SIZE (#define at top of conf.c).
  */
-int average_conf(Read *r);
+int average_conf(Read *r, EBA_SCRATCH *s);
 
 /*
  * Rescales eba scores to phred-style scores.
@@ -35,6 +54,7 @@ void rescale_scores(Read *r, int table);
  * Applies a simple filter to the trace data, producing new traces.
  * Equivalent to 1st-order differentiation followed by fitting a +-1 square
  * wave of width 11.
+ * Returns 0 for success, -1 if the work buffers could not be allocated.
  */
-void filter_trace(Read *r);
+int filter_trace(Read *r, EBA_SCRATCH *s);
 
@@ -119,35 +119,37 @@ static int combined[] = {
 
 /*
  * infp and outfp maybe the same FILE *, so we need to fseek between reading
- * and writing.
+ * and writing. outfp is closed on return unless dumping to stdout.
  */
 static int do_it(mFILE *infp, mFILE *outfp, int in_f, int out_f, char *fn,
 		 int phred_scale, int avg_qual, int filtered,
-		 int non_filtered, int offset, int dump) {
-    Read *r, *rf;
+		 int non_filtered, int offset, int dump, EBA_SCRATCH *s) {
+    Read *r, *rf = NULL;
 
     if (NULL == (r = mfread_reading(infp, fn, in_f))) {
 	fprintf(stderr, "Couldn't read reading file\n");
+	if (!dump)
+	    mfclose(outfp);
 	return 1;
     }
 
     if (filtered) {
-	rf = read_dup(r, "?");
-	filter_trace(rf);
-	calc_conf_values(rf, phred_scale, 1, offset);
+	if (NULL == (rf = read_dup(r, "?")) ||
+	    filter_trace(rf, s) ||
+	    calc_conf_values(rf, phred_scale, 1, offset, s))
+	    goto nomem;
 
 	if (phred_scale) {
 	    rescale_scores(rf, 1);
 	}
-    } else {
-	rf = NULL; /* Keep gcc happy */
     }
     if (non_filtered) {
-	calc_conf_values(r, phred_scale, 0, offset);
+	if (calc_conf_values(r, phred_scale, 0, offset, s))
+	    goto nomem;
 
 	/* Average confidence values */
-	if (avg_qual)
-	    average_conf(r);
+	if (avg_qual && average_conf(r, s))
+	    goto nomem;
 
 	if (phred_scale) {
 	    rescale_scores(r, 0);
@@ -156,8 +158,10 @@ static int do_it(mFILE *infp, mFILE *outfp, int in_f, int out_f, char *fn,
 
     /* Merge filtered and non-filtered, or just copy filtered confidences */
     if (filtered) {
+	static char base[256];
+	static int base_init = 0;
 	int i;
-	char *nf_conf[4], *f_conf[4], base[256];
+	char *nf_conf[4], *f_conf[4];
 
 	nf_conf[0] = rf->prob_A;
 	nf_conf[1] = rf->prob_C;
@@ -168,38 +172,37 @@ static int do_it(mFILE *infp, mFILE *outfp, int in_f, int out_f, char *fn,
 	f_conf[2] = r->prob_G;
 	f_conf[3] = r->prob_T;
 
-	memset(base, 5, 256);
-	base['A'] = 0;
-	base['a'] = 0;
-	base['C'] = 1;
-	base['c'] = 1;
-	base['G'] = 2;
-	base['g'] = 2;
-	base['T'] = 3;
-	base['t'] = 3;
+	if (!base_init) {
+	    memset(base, 5, 256);
+	    base['A'] = 0;
+	    base['a'] = 0;
+	    base['C'] = 1;
+	    base['c'] = 1;
+	    base['G'] = 2;
+	    base['g'] = 2;
+	    base['T'] = 3;
+	    base['t'] = 3;
+	    base_init = 1;
+	}
 
 	for (i = 0; i < r->NBases; i++) {
-	    char c1, c2;
 	    int bind;
 
-	    bind = base[r->base[i]];
+	    bind = base[(unsigned char)r->base[i]];
 	    if (bind == 5) {
 		f_conf[0][i] = f_conf[1][i] = f_conf[2][i] = f_conf[3][i] = 0;
 		continue;
 	    }
 
-	    c1 = nf_conf[bind][i];
 	    if (non_filtered) {
-		double p1, p2, p;
-		c2 =  f_conf[bind][i];
-		/* Tried MIN(c1,c2) */
-		/* f_conf[bind][i] = (c1 * c2) / 100;*/
-		p1 = 1-pow(10,(double)c1/-10.0);
-		p2 = 1-pow(10,(double)c2/-10.0);
-		p = (p1*p2) / (p1*p2 + (1-p1)*(1-p2));
-		f_conf[bind][i] = combined[f_conf[bind][i]];
+		/*
+		 * Tried MIN(c1,c2), (c1 * c2) / 100 and a Bayesian
+		 * combination of the two error probabilities before
+		 * settling on this calibration table.
+		 */
+		f_conf[bind][i] = combined[(int)f_conf[bind][i]];
 	    } else {
-		f_conf[bind][i] = c1;
+		f_conf[bind][i] = nf_conf[bind][i];
 	    }
 	}
 
@@ -259,22 +262,66 @@ static int do_it(mFILE *infp, mFILE *outfp, int in_f, int out_f, char *fn,
     } else {
 	if (-1 == (mfwrite_reading(outfp, r, out_f))) {
 	    fprintf(stderr, "Couldn't write reading file\n");
+	    mfclose(outfp);
 	    read_deallocate(r);
 	    return 1;
 	}
 
 	mftruncate(outfp, -1);
+	mfclose(outfp);
     }
 
-    mfclose(outfp);
-
     read_deallocate(r);
 
     return 0;
+
+ nomem:
+    fprintf(stderr, "Out of memory processing %s\n", fn);
+    if (rf)
+	read_deallocate(rf);
+    read_deallocate(r);
+    if (!dump)
+	mfclose(outfp);
+    return 1;
+}
+
+/*
+ * Recomputes the confidence values for a single named trace, rewriting it
+ * in place (or dumping the values to stdout). The original is not kept,
+ * and a trace found only through the trace search path (for instance
+ * inside an archive) cannot be rewritten.
+ */
+static int do_file(char *fn, int in_f, int out_f, int phred_scale,
+		   int avg_qual, int filtered, int non_filtered, int offset,
+		   int dump, EBA_SCRATCH *s) {
+    mFILE *ifp, *ofp;
+    int err;
+
+    /*
+     * Read and write same file, but we open for update and truncate the
+     * file after writing a new trace incase it is shorter.
+     */
+    if (NULL == (ifp = open_trace_mfile(fn, NULL))) {
+	perror(fn);
+	return 1;
+    }
+    if (dump) {
+	ofp = mstdout();
+    } else if (NULL == (ofp = mfopen(fn, "r+"))) {
+	perror(fn);
+	mfclose(ifp);
+	return 1;
+    }
+
+    err = do_it(ifp, ofp, in_f, out_f, fn, phred_scale, avg_qual,
+		filtered, non_filtered, offset, dump, s);
+    mfclose(ifp);
+
+    return err;
 }
 
 static void usage(void) {
-    fprintf(stderr, "Usage: eba [options] [trace_file]\n");
+    fprintf(stderr, "Usage: eba [options] [trace_file ...]\n");
     fprintf(stderr, "   -phred_scale                Use phred log scale\n");
     fprintf(stderr, "   -old_scale                  Use S/N ratios\n");
     fprintf(stderr, "   -average 0/1                Whether to avg non-filtered results\n");
@@ -282,6 +329,9 @@ static void usage(void) {
     fprintf(stderr, "   -filtered 0/1               Compute S/N on filtered traces\n");
     fprintf(stderr, "   -offset value               Add value to denominator in S/N calc.\n");
     fprintf(stderr, "   -dump raw/fasta/caf         Output quality to stdout instead of new trace.\n");
+    fprintf(stderr, "   -fofn file                  Also process the traces listed in file.\n");
+    fprintf(stderr, "\n  Each trace is rewritten in place, unless -dump is used; no backup is kept.\n");
+    fprintf(stderr, "  Traces must be ordinary files that can be opened for update.\n");
     fprintf(stderr, "\n  eg. eba -phred_scale -non_filtered 1 -average 1 -filtered 1 -offset 50 a.scf\n");
 
     exit(1);
@@ -295,9 +345,9 @@ static void usage(void) {
  * to discriminate better for poor data and not so well on very good data.
  */
 int main(int argc, char **argv) {
-    mFILE *ifp = mstdin();
-    mFILE *ofp = mstdout();
-    char *fn;
+    char fn[1024], *cp;
+    char *fofn = NULL;
+    FILE *fp;
     int in_type = TT_ANY, out_type = TT_ANY;
     int phred_scale = 1;
     int a = 1;
@@ -306,6 +356,8 @@ int main(int argc, char **argv) {
     int non_filtered = 1;
     int offset = 20;
     int dump = 0;
+    int ret = 0;
+    EBA_SCRATCH scratch;
 
     while (a < argc) {
 	if (strcmp(argv[a], "-phred_scale") == 0)
@@ -333,6 +385,11 @@ int main(int argc, char **argv) {
 	    else
 		usage();
 	}
+	else if (strcmp(argv[a], "-fofn") == 0) {
+	    if (++a == argc)
+		usage();
+	    fofn = argv[a];
+	}
 	else if (strcmp(argv[a], "-h") == 0)
 	    usage();
 	else 
@@ -340,30 +397,45 @@ int main(int argc, char **argv) {
 	a++;
     }
 
-    switch (argc-a) {
-    case 0: {
-	fn = "(stdin)";
-	break;
+    memset(&scratch, 0, sizeof(scratch));
+
+    if (a == argc && !fofn) {
+	ret = do_it(mstdin(), mstdout(), in_type, out_type, "(stdin)",
+		    phred_scale, avg_qual, filtered, non_filtered, offset,
+		    dump, &scratch);
+	free_eba_scratch(&scratch);
+	return ret;
     }
-    case 1: {
-	/*
-	 * Read and write same file, but we open for update and truncate the
-	 * file after writing a new trace incase it is shorter.
-	 */
-	ofp = mfopen(argv[a], "r+");
-	ifp = open_trace_mfile(argv[a], NULL);
-	if (ifp == NULL) {
-	    perror(argv[a]);
-	    return 1;
-	}
-	fn = argv[a];
-	break;
+
+    /*
+     * Many traces may be processed in one run, either listed on the command
+     * line or in a file of filenames. The work buffers are shared between
+     * them, and a failure on one trace does not stop the rest.
+     */
+    for (; a < argc; a++) {
+	if (do_file(argv[a], in_type, out_type, phred_scale, avg_qual,
+		    filtered, non_filtered, offset, dump, &scratch))
+	    ret = 1;
     }
-    default:
-	usage();
-	return 1;
+
+    if (fofn) {
+	if (NULL == (fp = fopen(fofn, "r"))) {
+	    perror(fofn);
+	    ret = 1;
+	} else {
+	    while (fgets(fn, sizeof(fn), fp)) {
+		if ((cp = strchr(fn, '\n')))
+		    *cp = 0;
+		if (!*fn)
+		    continue;
+		if (do_file(fn, in_type, out_type, phred_scale, avg_qual,
+			    filtered, non_filtered, offset, dump, &scratch))
+		    ret = 1;
+	    }
+	    fclose(fp);
+	}
     }
 
-    return do_it(ifp, ofp, in_type, out_type, fn, phred_scale,
-		 avg_qual, filtered, non_filtered, offset, dump);
+    free_eba_scratch(&scratch);
+    return ret;
 }
@@ -0,0 +1,466 @@
+/*
+ * File: expdb.c
+ *
+ * Description: an indexed container holding many experiment file records.
+ *              See expdb.h for the file layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <tcl.h>
+#include <io_lib/expFileIO.h>
+#include <io_lib/mFILE.h>
+
+#include "expdb.h"
+#include "misc.h"
+#include "xalloc.h"
+
+#define EXPDB_NAMELEN 1024
+
+/* Header width excluding the name: "@" + " %10d %10d\n" */
+#define EXPDB_HDRLEN(name) (strlen(name) + 24)
+
+
+/*************************************************************
+ * Index handling
+ *************************************************************/
+
+static char *expdb_index_name(char *fn) {
+    char *ifn;
+
+    if (NULL == (ifn = (char *)xmalloc(strlen(fn) + 5)))
+	return NULL;
+    sprintf(ifn, "%s.idx", fn);
+    return ifn;
+}
+
+static int expdb_set_item(Exp_db *db, char *name, long offset, int length,
+			  int space) {
+    Tcl_HashEntry *hash;
+    expdb_item *it;
+    int new;
+
+    hash = Tcl_CreateHashEntry(&db->index, name, &new);
+    if (new) {
+	if (NULL == (it = (expdb_item *)xmalloc(sizeof(*it)))) {
+	    Tcl_DeleteHashEntry(hash);
+	    return -1;
+	}
+	Tcl_SetHashValue(hash, (ClientData)it);
+	db->nitems++;
+    } else {
+	it = (expdb_item *)Tcl_GetHashValue(hash);
+    }
+
+    it->offset = offset;
+    it->length = length;
+    it->space  = space;
+    return 0;
+}
+
+static void expdb_clear_index(Exp_db *db) {
+    Tcl_HashEntry *hash;
+    Tcl_HashSearch search;
+
+    for (hash = Tcl_FirstHashEntry(&db->index, &search); hash;
+	 hash = Tcl_NextHashEntry(&search)) {
+	xfree(Tcl_GetHashValue(hash));
+    }
+    Tcl_DeleteHashTable(&db->index);
+    Tcl_InitHashTable(&db->index, TCL_STRING_KEYS);
+    db->nitems = 0;
+}
+
+/*
+ * Loads an index file. Returns 0 for success, -1 for failure.
+ */
+static int expdb_load_index(Exp_db *db, char *ifn) {
+    FILE *fp;
+    char name[EXPDB_NAMELEN];
+    long offset;
+    int length, space, n;
+
+    if (NULL == (fp = fopen(ifn, "r")))
+	return -1;
+
+    while ((n = fscanf(fp, "%1023s %ld %d %d", name, &offset, &length,
+		       &space)) == 4) {
+	if (expdb_set_item(db, name, offset, length, space)) {
+	    fclose(fp);
+	    return -1;
+	}
+    }
+    fclose(fp);
+
+    return n == EOF ? 0 : -1;
+}
+
+/*
+ * Rebuilds the index by walking the record headers in the container.
+ * Later records of the same name supersede earlier ones.
+ * Returns 0 for success, -1 for failure.
+ */
+static int expdb_scan(Exp_db *db) {
+    char line[EXPDB_NAMELEN + 32];
+    char name[EXPDB_NAMELEN];
+    int length, space;
+
+    rewind(db->fp);
+    while (fgets(line, sizeof(line), db->fp)) {
+	if (line[0] != '@' ||
+	    sscanf(line + 1, "%1023s %d %d", name, &length, &space) != 3 ||
+	    length > space) {
+	    verror(ERR_WARN, "expdb_open", "corrupt record header in %s",
+		   db->fn);
+	    return -1;
+	}
+	if (expdb_set_item(db, name, ftell(db->fp), length, space))
+	    return -1;
+	if (fseek(db->fp, space, SEEK_CUR))
+	    return -1;
+    }
+
+    return 0;
+}
+
+static int expdb_save_index(Exp_db *db, char *ifn) {
+    FILE *fp;
+    Tcl_HashEntry *hash;
+    Tcl_HashSearch search;
+    expdb_item *it;
+
+    if (NULL == (fp = fopen(ifn, "w")))
+	return -1;
+
+    for (hash = Tcl_FirstHashEntry(&db->index, &search); hash;
+	 hash = Tcl_NextHashEntry(&search)) {
+	it = (expdb_item *)Tcl_GetHashValue(hash);
+	fprintf(fp, "%s %ld %d %d\n", (char *)Tcl_GetHashKey(&db->index, hash),
+		it->offset, it->length, it->space);
+    }
+
+    return fclose(fp) ? -1 : 0;
+}
+
+
+/*************************************************************
+ * Open and close
+ *************************************************************/
+
+Exp_db *expdb_open(char *fn, int mode) {
+    Exp_db *db;
+    char *ifn;
+    struct stat cst, ist;
+    int rebuild;
+
+    if (NULL == (db = (Exp_db *)xcalloc(1, sizeof(*db))))
+	return NULL;
+    Tcl_InitHashTable(&db->index, TCL_STRING_KEYS);
+    db->mode = mode;
+
+    if (NULL == (db->fn = strdup(fn))) {
+	expdb_close(db);
+	return NULL;
+    }
+
+    db->fp = fopen(fn, mode == EXPDB_WRITE ? "r+b" : "rb");
+    if (!db->fp && mode == EXPDB_WRITE)
+	db->fp = fopen(fn, "w+b");
+    if (!db->fp) {
+	verror(ERR_WARN, "expdb_open", "couldn't open '%s'", fn);
+	expdb_close(db);
+	return NULL;
+    }
+
+    if (NULL == (ifn = expdb_index_name(fn))) {
+	expdb_close(db);
+	return NULL;
+    }
+
+    /* Trust the index only if it is at least as new as the container */
+    rebuild = stat(fn, &cst) || stat(ifn, &ist) ||
+	ist.st_mtime < cst.st_mtime;
+    if (!rebuild && expdb_load_index(db, ifn))
+	rebuild = 1;
+
+    if (rebuild) {
+	expdb_clear_index(db);
+	if (expdb_scan(db)) {
+	    xfree(ifn);
+	    expdb_close(db);
+	    return NULL;
+	}
+	if (mode == EXPDB_WRITE && expdb_save_index(db, ifn))
+	    verror(ERR_WARN, "expdb_open", "couldn't write index '%s'", ifn);
+    }
+
+    if (mode == EXPDB_WRITE && NULL == (db->idx = fopen(ifn, "a"))) {
+	verror(ERR_WARN, "expdb_open", "couldn't open index '%s'", ifn);
+	xfree(ifn);
+	expdb_close(db);
+	return NULL;
+    }
+
+    xfree(ifn);
+    return db;
+}
+
+void expdb_close(Exp_db *db) {
+    if (!db)
+	return;
+
+    expdb_clear_index(db);
+    Tcl_DeleteHashTable(&db->index);
+    if (db->fp)
+	fclose(db->fp);
+    if (db->idx)
+	fclose(db->idx);
+    if (db->fn)
+	free(db->fn);
+    xfree(db);
+}
+
+
+/*************************************************************
+ * Reading and writing
+ *************************************************************/
+
+Exp_info *expdb_read(Exp_db *db, char *name) {
+    Tcl_HashEntry *hash;
+    expdb_item *it;
+    Exp_info *e;
+    mFILE *mf;
+    char *buf;
+    char hdr[EXPDB_NAMELEN + 32], hname[EXPDB_NAMELEN];
+    int length, space;
+
+    if (NULL == (hash = Tcl_FindHashEntry(&db->index, name)))
+	return NULL;
+    it = (expdb_item *)Tcl_GetHashValue(hash);
+
+    /*
+     * Take the length from the record header, as the record may have been
+     * rewritten in place since the index was read.
+     */
+    if (fseek(db->fp, it->offset - (long)EXPDB_HDRLEN(name), SEEK_SET) ||
+	!fgets(hdr, sizeof(hdr), db->fp) || hdr[0] != '@' ||
+	sscanf(hdr + 1, "%1023s %d %d", hname, &length, &space) != 3 ||
+	strcmp(hname, name) != 0 || length > space ||
+	ftell(db->fp) != it->offset) {
+	verror(ERR_WARN, "expdb_read", "corrupt record '%s' in '%s'",
+	       name, db->fn);
+	return NULL;
+    }
+
+    /* mfclose() frees the buffer, so it must come from malloc() */
+    if (NULL == (buf = (char *)malloc(length + 1)))
+	return NULL;
+
+    if (fread(buf, 1, length, db->fp) != (size_t)length) {
+	verror(ERR_WARN, "expdb_read", "couldn't read '%s' from '%s'",
+	       name, db->fn);
+	free(buf);
+	return NULL;
+    }
+    buf[length] = 0;
+
+    if (NULL == (mf = mfcreate(buf, length))) {
+	free(buf);
+	return NULL;
+    }
+    e = exp_mfread_info(mf);
+    mfclose(mf);
+    if (e)
+	exp_close(e);
+
+    return e;
+}
+
+int expdb_write(Exp_db *db, char *name, Exp_info *e) {
+    Tcl_HashEntry *hash;
+    expdb_item *it = NULL;
+    FILE *tmp;
+    char *buf, *p;
+    long offset;
+    int length, space, i;
+
+    if (db->mode != EXPDB_WRITE)
+	return -1;
+
+    for (p = name; *p; p++) {
+	if (isspace(*p)) {
+	    verror(ERR_WARN, "expdb_write", "invalid entry name '%s'", name);
+	    return -1;
+	}
+    }
+    if (!*name || strlen(name) >= EXPDB_NAMELEN)
+	return -1;
+
+    /* Format the record */
+    if (NULL == (tmp = tmpfile()))
+	return -1;
+    exp_print_file(tmp, e);
+    length = (int)ftell(tmp);
+    if (NULL == (buf = (char *)xmalloc(length + 1))) {
+	fclose(tmp);
+	return -1;
+    }
+    rewind(tmp);
+    if (fread(buf, 1, length, tmp) != (size_t)length) {
+	xfree(buf);
+	fclose(tmp);
+	return -1;
+    }
+    fclose(tmp);
+
+    /* Overwrite in place if it fits, otherwise append with some slack */
+    if ((hash = Tcl_FindHashEntry(&db->index, name)))
+	it = (expdb_item *)Tcl_GetHashValue(hash);
+
+    if (it && length <= it->space) {
+	offset = it->offset;
+	space  = it->space;
+	if (fseek(db->fp, offset - (long)EXPDB_HDRLEN(name), SEEK_SET))
+	    goto error;
+    } else {
+	space = length + length / 8 + 64;
+	if (fseek(db->fp, 0, SEEK_END))
+	    goto error;
+	offset = ftell(db->fp) + EXPDB_HDRLEN(name);
+    }
+
+    fprintf(db->fp, "@%s %10d %10d\n", name, length, space);
+    if (ftell(db->fp) != offset ||
+	fwrite(buf, 1, length, db->fp) != (size_t)length)
+	goto error;
+    if (!it || length > it->space) {
+	for (i = length; i < space; i++)
+	    putc('\n', db->fp);
+    }
+    if (fflush(db->fp))
+	goto error;
+
+    if (expdb_set_item(db, name, offset, length, space))
+	goto error;
+    fprintf(db->idx, "%s %ld %d %d\n", name, offset, length, space);
+    fflush(db->idx);
+
+    xfree(buf);
+    return 0;
+
+ error:
+    verror(ERR_WARN, "expdb_write", "couldn't write '%s' to '%s'",
+	   name, db->fn);
+    xfree(buf);
+    return -1;
+}
+
+int expdb_add_file(Exp_db *db, char *fn) {
+    Exp_info *e;
+    char *name;
+    int err;
+
+    if (NULL == (e = exp_read_info(fn))) {
+	verror(ERR_WARN, "expdb_add_file", "couldn't read '%s'", fn);
+	return -1;
+    }
+
+    if (exp_Nentries(e, EFLT_ID)) {
+	name = exp_get_entry(e, EFLT_ID);
+    } else {
+	if ((name = strrchr(fn, '/')))
+	    name++;
+	else
+	    name = fn;
+    }
+
+    err = expdb_write(db, name, e);
+    exp_destroy_info(e);
+
+    return err;
+}
+
+
+/*************************************************************
+ * "container::entry" paths
+ *************************************************************/
+
+/*
+ * Splits "container::entry" at the separator, returning the container file
+ * name in a new buffer (to be xfreed) and setting *entry. Returns NULL if
+ * path has no separator.
+ */
+static char *expdb_path_container(char *path, char **entry) {
+    char *sep, *fn;
+
+    if (NULL == (sep = strstr(path, EXPDB_SEP)))
+	return NULL;
+
+    if (NULL == (fn = (char *)xmalloc(sep - path + 1)))
+	return NULL;
+    strncpy(fn, path, sep - path);
+    fn[sep - path] = 0;
+
+    *entry = sep + strlen(EXPDB_SEP);
+    return fn;
+}
+
+int expdb_is_path(char *path) {
+    struct stat st;
+    char *fn, *entry;
+    int ret;
+
+    /* A file that happens to have the separator in its name */
+    if (0 == stat(path, &st))
+	return 0;
+
+    if (NULL == (fn = expdb_path_container(path, &entry)))
+	return 0;
+    ret = *entry && 0 == stat(fn, &st) && S_ISREG(st.st_mode);
+    xfree(fn);
+
+    return ret;
+}
+
+Exp_info *expdb_read_path(char *path) {
+    static Exp_db *last = NULL;
+    static time_t last_mtime;
+    static off_t last_size;
+    struct stat st;
+    char *fn, *entry;
+    Exp_info *e;
+
+    if (NULL == (fn = expdb_path_container(path, &entry)))
+	return NULL;
+
+    if (stat(fn, &st)) {
+	verror(ERR_WARN, "expdb_read_path", "couldn't open '%s'", fn);
+	xfree(fn);
+	return NULL;
+    }
+
+    /* Reopen on switching containers, or if this one has been updated */
+    if (!last || strcmp(last->fn, fn) != 0 ||
+	st.st_mtime != last_mtime || st.st_size != last_size) {
+	if (last)
+	    expdb_close(last);
+	last = expdb_open(fn, EXPDB_READ);
+	last_mtime = st.st_mtime;
+	last_size = st.st_size;
+    }
+    xfree(fn);
+
+    if (!last)
+	return NULL;
+
+    e = expdb_read(last, entry);
+    if (!e)
+	verror(ERR_WARN, "expdb_read_path", "no entry '%s'", path);
+
+    return e;
+}
@@ -0,0 +1,94 @@
+/*
+ * File: expdb.h
+ *
+ * Description: an indexed container holding many experiment file records.
+ *
+ * A container "name" is a single file of records, each preceded by a
+ * fixed width header line:
+ *
+ *     @<entry-name> <length> <space>
+ *
+ * followed by <space> bytes of which the first <length> are the text of
+ * a normal experiment file. The spare bytes allow a record to be updated
+ * in place when it grows a little (eg QL/QR or tags added by pregap4).
+ *
+ * The index "name.idx" holds one "<entry-name> <offset> <length> <space>"
+ * line per write; later lines supersede earlier ones. If the index is
+ * missing or older than the container it is rebuilt from the headers.
+ *
+ * Individual records are addressed as "container::entry-name", which is
+ * accepted anywhere read_sequence_details() takes a file name.
+ *
+ * Containers are created and updated with the expdb_pack program.
+ */
+
+#ifndef _EXPDB_H_
+#define _EXPDB_H_
+
+#include <stdio.h>
+#include <tcl.h>
+#include <io_lib/expFileIO.h>
+
+#define EXPDB_READ  0
+#define EXPDB_WRITE 1
+
+/* Separates the container file name from the entry name in a path */
+#define EXPDB_SEP "::"
+
+typedef struct {
+    long offset;		/* file offset of the record text */
+    int length;			/* length of the record text */
+    int space;			/* bytes available for the record */
+} expdb_item;
+
+typedef struct {
+    char *fn;			/* container file name */
+    FILE *fp;			/* container */
+    FILE *idx;			/* index, open for appending when writable */
+    int mode;			/* EXPDB_READ or EXPDB_WRITE */
+    int nitems;			/* number of distinct entries */
+    Tcl_HashTable index;	/* entry name -> expdb_item */
+} Exp_db;
+
+/*
+ * Opens a container. With EXPDB_WRITE the container is created if it
+ * does not exist. Returns NULL on failure.
+ */
+Exp_db *expdb_open(char *fn, int mode);
+
+void expdb_close(Exp_db *db);
+
+/*
+ * Reads entry 'name', returning a new Exp_info or NULL if it is absent
+ * or cannot be parsed. The caller frees it with exp_destroy_info().
+ */
+Exp_info *expdb_read(Exp_db *db, char *name);
+
+/*
+ * Stores 'e' as entry 'name', replacing any existing entry. The record
+ * is rewritten in place when it fits, otherwise appended.
+ * Returns 0 for success, -1 for failure.
+ */
+int expdb_write(Exp_db *db, char *name, Exp_info *e);
+
+/*
+ * Adds the experiment file 'fn' to the container under its ID name.
+ * Returns 0 for success, -1 for failure.
+ */
+int expdb_add_file(Exp_db *db, char *fn);
+
+/*
+ * Returns 1 if 'path' is of the form "container::entry-name" and the
+ * container exists, else 0.
+ */
+int expdb_is_path(char *path);
+
+/*
+ * Reads the entry addressed by "container::entry-name". The most recently
+ * used container is kept open, so reading a run of entries from one
+ * container costs one seek and one parse per entry. It is reopened if
+ * the container has been modified since.
+ */
+Exp_info *expdb_read_path(char *path);
+
+#endif /* _EXPDB_H_ */
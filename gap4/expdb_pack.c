@@ -0,0 +1,111 @@
+/*
+ * File: expdb_pack.c
+ *
+ * Description: adds experiment files to an experiment file container (see
+ *              expdb.h), or updates the entries already there. Entries that
+ *              still fit their space are rewritten in place.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "expdb.h"
+#include "misc.h"
+
+#ifdef _MSC_VER
+#  define DLL_IMPORT __declspec(dllimport)
+#else
+#  define DLL_IMPORT
+#endif
+
+extern DLL_IMPORT char *optarg;
+extern DLL_IMPORT int optind;
+
+static void usage(void) {
+    fprintf(stderr, "expdb_pack [-v] [-f fofn] container [file ...]\n");
+    fprintf(stderr, "    -v       verbose\n");
+    fprintf(stderr, "    -f fofn  also add the files listed in fofn "
+	    "(\"-\" for stdin)\n");
+    exit(1);
+}
+
+static int pack_file(Exp_db *db, char *fn, int verbose) {
+    if (verbose)
+	printf("Adding %s\n", fn);
+
+    if (expdb_add_file(db, fn)) {
+	fprintf(stderr, "expdb_pack: failed to add '%s'\n", fn);
+	return 1;
+    }
+
+    return 0;
+}
+
+static int pack_fofn(Exp_db *db, char *fofn, int verbose) {
+    FILE *fp;
+    char line[1024], *cp;
+    int err = 0;
+
+    if (strcmp(fofn, "-") == 0) {
+	fp = stdin;
+    } else if (NULL == (fp = fopen(fofn, "r"))) {
+	fprintf(stderr, "expdb_pack: couldn't open '%s'\n", fofn);
+	return 1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+	if ((cp = strchr(line, '\n')))
+	    *cp = 0;
+	if ((cp = strchr(line, '\r')))
+	    *cp = 0;
+	if (*line)
+	    err |= pack_file(db, line, verbose);
+    }
+
+    if (fp != stdin)
+	fclose(fp);
+
+    return err;
+}
+
+int main(int argc, char **argv) {
+    Exp_db *db;
+    char *fofn = NULL;
+    int c, err = 0, verbose = 0;
+
+    while ((c = getopt(argc, argv, "vf:")) != -1) {
+	switch (c) {
+	case 'v':
+	    verbose = 1;
+	    break;
+
+	case 'f':
+	    fofn = optarg;
+	    break;
+
+	default:
+	    usage();
+	}
+    }
+
+    if (optind >= argc || (optind == argc-1 && !fofn))
+	usage();
+
+    if (NULL == (db = expdb_open(argv[optind], EXPDB_WRITE))) {
+	fprintf(stderr, "expdb_pack: couldn't open container '%s'\n",
+		argv[optind]);
+	return 2;
+    }
+
+    for (optind++; optind < argc; optind++)
+	err |= pack_file(db, argv[optind], verbose);
+
+    if (fofn)
+	err |= pack_fofn(db, fofn, verbose);
+
+    expdb_close(db);
+
+    return err;
+}
@@ -23,6 +23,7 @@
 #include <io_lib/traceType.h>
 
 #include "seqInfo.h"
+#include "expdb.h"
 #include "array.h"
 #include <io_lib/scf_extras.h>
 
@@ -593,40 +594,46 @@ SeqInfo *read_sequence_details(char *filename, int ignore_vec)
     /*
      * read sequence details into experiment file format
      */
-    if (NULL == (fp = open_exp_mfile(filename, NULL)))
-	return NULL;
-
-    format = fdetermine_trace_type(fp);
-    mrewind(fp);
-    switch(format) {
-    case TT_PLN:
-	e = exp_read_staden_info(fp, filename);
-	mfclose(fp);
-	break;
-    case TT_EXP:
-	e = exp_mfread_info(fp);
-	mfclose(fp);
-	if (e)
-	    exp_close(e);
-	break;
+    if (expdb_is_path(filename)) {
+	/* An entry in an experiment file container: "container::name" */
+	e = expdb_read_path(filename);
+    } else {
+	if (NULL == (fp = open_exp_mfile(filename, NULL)))
+	    return NULL;
+	format = fdetermine_trace_type(fp);
+	mrewind(fp);
+
+	switch(format) {
+	case TT_PLN:
+	    e = exp_read_staden_info(fp, filename);
+	    mfclose(fp);
+	    break;
+	case TT_EXP:
+	    e = exp_mfread_info(fp);
+	    mfclose(fp);
+	    if (e)
+		exp_close(e);
+	    break;
 #ifdef USE_BIOLIMS
-    case TT_BIO:
-        e = spBiolims2exp(filename);
-	mfclose(fp);
-	break;
+	case TT_BIO:
+	    e = spBiolims2exp(filename);
+	    mfclose(fp);
+	    break;
 #endif
-    case TT_ERR:
-	verror(ERR_WARN, "read_sequence_details",
-	       "Failed to read file %s", filename);
-	e = NULL;
-	mfclose(fp);
-	break;
-    default:
-	verror(ERR_WARN, "read_sequence_details",
-	       "File %s is not in plain or Experiment File format", filename);
-	e = NULL;
-	mfclose(fp);
-	break;
+	case TT_ERR:
+	    verror(ERR_WARN, "read_sequence_details",
+		   "Failed to read file %s", filename);
+	    e = NULL;
+	    mfclose(fp);
+	    break;
+	default:
+	    verror(ERR_WARN, "read_sequence_details",
+		   "File %s is not in plain or Experiment File format",
+		   filename);
+	    e = NULL;
+	    mfclose(fp);
+	    break;
+	}
     }
 
     if ( e != NULL ) {
@@ -2281,19 +2281,219 @@ int consensus_unclipped_range(GapIO *io, tg_rec contig, int *start, int *end) {
     return 0;
 }
 
+/*
+ * An index of the pad columns in a contig consensus, so padded and
+ * unpadded coordinates can be converted without recomputing and counting
+ * the consensus each time.
+ *
+ * Each superblock of PAD_SB_COLS columns holds the number of pads before
+ * it followed by one bit per column, set for pads. The consensus changes
+ * with almost any edit to the contig, so rather than being updated on
+ * every edit the index is discarded when the contig timestamp moves on
+ * and then rebuilt, a chunk of columns at a time, as far as is queried.
+ */
+#define PAD_SB_COLS  512
+#define PAD_SB_WORDS (1 + PAD_SB_COLS/64)
+#define PAD_CHUNK    (128 * PAD_SB_COLS)
+
+typedef struct pad_index {
+    int start;		/* first column, the clipped start of the contig */
+    int ncols;		/* columns which may hold pads, up to the contig end */
+    int len;		/* columns indexed so far */
+    int nbases;		/* non-pad columns amongst those */
+    int nsb;		/* superblocks allocated */
+    uint64_t sb[1];	/* nsb * PAD_SB_WORDS words */
+} pad_index_t;
+
+#define PAD_INDEX_SIZE(nsb) \
+    (sizeof(pad_index_t) + ((nsb) * PAD_SB_WORDS - 1) * sizeof(uint64_t))
+
+static int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+
+/*
+ * Returns the pad index for contig c, starting at clipped_start, creating
+ * a new empty one if the existing one is out of date.
+ * Returns NULL on failure.
+ */
+static pad_index_t *pad_index_get(contig_t *c, int clipped_start) {
+    pad_index_t *pi = c->pad_index;
+
+    if (pi && c->timestamp <= c->pad_timestamp && pi->start == clipped_start)
+	return pi;
+
+    if (pi)
+	free(pi);
+
+    if (NULL == (pi = calloc(1, PAD_INDEX_SIZE(1)))) {
+	c->pad_index = NULL;
+	return NULL;
+    }
+
+    pi->start = clipped_start;
+    pi->ncols = MAX(0, c->end - clipped_start + 1);
+    pi->nsb = 1;
+
+    c->pad_index = pi;
+    c->pad_timestamp = c->timestamp;
+
+    return pi;
+}
+
+/*
+ * Indexes at least the first ncols columns of c->pad_index, or all of
+ * them if fewer.
+ * Returns 0 for success
+ *        -1 for failure
+ */
+static int pad_index_extend(GapIO *io, contig_t *c, int ncols) {
+    pad_index_t *pi = c->pad_index;
+    char *cons;
+    int i, n, col, sb, k;
+
+    if (ncols > pi->ncols)
+	ncols = pi->ncols;
+    if (pi->len >= ncols)
+	return 0;
+
+    if (NULL == (cons = malloc(PAD_CHUNK)))
+	return -1;
+
+    /* len is a multiple of PAD_SB_COLS until the last chunk */
+    while (pi->len < ncols) {
+	n = MIN(PAD_CHUNK, pi->ncols - pi->len);
+
+	sb = (pi->len + n) / PAD_SB_COLS + 1;
+	if (sb > pi->nsb) {
+	    pad_index_t *pn;
+
+	    sb = MAX(sb, pi->nsb * 2);
+	    if (NULL == (pn = realloc(pi, PAD_INDEX_SIZE(sb)))) {
+		free(cons);
+		return -1;
+	    }
+	    memset(&pn->sb[pn->nsb * PAD_SB_WORDS], 0,
+		   (sb - pn->nsb) * PAD_SB_WORDS * sizeof(uint64_t));
+	    pn->nsb = sb;
+	    pi = c->pad_index = pn;
+	}
+
+	if (-1 == calculate_consensus_simple(io, c->rec, pi->start + pi->len,
+					     pi->start + pi->len + n - 1,
+					     cons, NULL)) {
+	    free(cons);
+	    return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+	    if (cons[i] == '*') {
+		col = pi->len + i;
+		pi->sb[(col / PAD_SB_COLS) * PAD_SB_WORDS + 1
+		       + (col % PAD_SB_COLS) / 64] |= (uint64_t)1 << (col % 64);
+	    } else {
+		pi->nbases++;
+	    }
+	}
+
+	/* Pads before each superblock started or reached by this chunk */
+	for (sb = pi->len / PAD_SB_COLS + 1;
+	     sb <= (pi->len + n) / PAD_SB_COLS; sb++) {
+	    uint64_t *w = &pi->sb[(sb-1) * PAD_SB_WORDS];
+	    uint64_t np = w[0];
+
+	    for (k = 1; k < PAD_SB_WORDS; k++)
+		np += popcount64(w[k]);
+	    pi->sb[sb * PAD_SB_WORDS] = np;
+	}
+
+	pi->len += n;
+    }
+
+    free(cons);
+    return 0;
+}
+
+/*
+ * Returns the number of pads in the columns from the index start up to,
+ * but not including, pos. Columns up to pos must already be indexed.
+ */
+static int pad_index_rank(pad_index_t *pi, int pos) {
+    int i = pos - pi->start, off, k, np;
+    uint64_t *w;
+
+    if (i <= 0)
+	return 0;
+    if (i > pi->len)
+	i = pi->len;
+
+    w = &pi->sb[(i / PAD_SB_COLS) * PAD_SB_WORDS];
+    off = i % PAD_SB_COLS;
+    np = (int)w[0];
+    for (k = 1; k <= off / 64; k++)
+	np += popcount64(w[k]);
+    if (off % 64)
+	np += popcount64(w[k] & (((uint64_t)1 << (off % 64)) - 1));
+
+    return np;
+}
+
+/*
+ * Returns the column holding the upos-th (from 1) non-pad of the index.
+ * Either that many non-pads or all columns must already be indexed.
+ */
+static int pad_index_select(pad_index_t *pi, int upos) {
+    int lo, hi, mid, k, nb, col;
+    uint64_t *w, pads;
+
+    /* There are no pads beyond the contig end */
+    if (upos > pi->nbases)
+	return pi->start + pi->len - 1 + upos - pi->nbases;
+
+    /* The last superblock with fewer than upos non-pads before it */
+    lo = 0;
+    hi = pi->len / PAD_SB_COLS;
+    while (lo < hi) {
+	mid = (lo + hi + 1) / 2;
+	if (mid * PAD_SB_COLS - (int)pi->sb[mid * PAD_SB_WORDS] < upos)
+	    lo = mid;
+	else
+	    hi = mid - 1;
+    }
+
+    w = &pi->sb[lo * PAD_SB_WORDS];
+    nb = lo * PAD_SB_COLS - (int)w[0];
+    col = lo * PAD_SB_COLS;
+    for (k = 1; k < PAD_SB_WORDS - 1; k++, col += 64) {
+	int n = 64 - popcount64(w[k]);
+	if (nb + n >= upos)
+	    break;
+	nb += n;
+    }
+
+    for (pads = w[k]; ; col++, pads >>= 1) {
+	if (!(pads & 1) && ++nb == upos)
+	    break;
+    }
+
+    return pi->start + col;
+}
+
 /*
  * Converts a padded position into an unpadded position.
  * Returns 0 for success and writes to upos
  *        -1 for error
  */
 int consensus_unpadded_pos(GapIO *io, tg_rec contig, int pos, int *upos) {
-    int np, i, i_end, clipped_start;
-    char *cons;
+    int np, clipped_start;
+    pad_index_t *pi;
     contig_t *c;
 
     consensus_valid_range(io, contig, &clipped_start, NULL);
 
-    /* For now it's the slow route: compute consensus and count '*'s */
     if (NULL == (c = cache_search(io, GT_Contig, contig)))
 	return TCL_ERROR;
     if (pos <= c->start) {
@@ -2301,23 +2501,16 @@ int consensus_unpadded_pos(GapIO *io, tg_rec contig, int pos, int *upos) {
 	return 0;
     }
 
-    if (NULL == (cons = malloc(pos - c->start + 1)))
-	return -1;
-
-    if (-1 == calculate_consensus_simple(io, contig, clipped_start,
-					 pos, cons, NULL)) {
-	free(cons);
+    cache_incr(io, c);
+    if (NULL == (pi = pad_index_get(c, clipped_start)) ||
+	-1 == pad_index_extend(io, c, pos - clipped_start)) {
+	cache_decr(io, c);
 	return -1;
     }
-
-    i_end = pos - clipped_start;
-    for (np = 0, i = 0; i < i_end; i++) {
-	if (cons[i] == '*')
-	    np++;
-    }
+    np = pad_index_rank(c->pad_index, pos);
+    cache_decr(io, c);
 
     *upos = pos - np - clipped_start + 1;
-    free(cons);
 
     return 0;
 }
@@ -2328,13 +2521,12 @@ int consensus_unpadded_pos(GapIO *io, tg_rec contig, int pos, int *upos) {
  *        -1 for error
  */
 int consensus_padded_pos(GapIO *io, tg_rec contig, int upos, int *pos) {
-    int np, i, i_end, offset, clipped_start;
-    char *cons;
+    int clipped_start;
+    pad_index_t *pi;
     contig_t *c;
 
     consensus_valid_range(io, contig, &clipped_start, NULL);
 
-    /* For now it's the slow route: compute consensus and count '*'s */
     if (NULL == (c = cache_search(io, GT_Contig, contig)))
 	return TCL_ERROR;
     if (upos <= 0) {
@@ -2342,50 +2534,23 @@ int consensus_padded_pos(GapIO *io, tg_rec contig, int upos, int *pos) {
 	return 0;
     }
 
-    /* First guess at 8k more */
-    if (NULL == (cons = malloc(upos + 1 + 8192)))
-	return -1;
-
-    if (-1 == calculate_consensus_simple(io, contig,
-					 clipped_start,
-					 clipped_start + upos + 8192,
-					 cons, NULL)) {
-	free(cons);
+    cache_incr(io, c);
+    if (NULL == (pi = pad_index_get(c, clipped_start))) {
+	cache_decr(io, c);
 	return -1;
     }
 
-    i_end = upos;
-    offset = clipped_start;
-    np = 0;
-    for(;;) {
-	int sz;
-
-	for (i = 0; i < i_end; i++) {
-
-	    if (cons[i] == '*')
-		np++;
-	    if (i + offset - (clipped_start-1) >= upos + np)
-		break;
-	}
-	
-	if (i + offset - (clipped_start-1) >= upos + np)
-	    break;
-
-	/* If we haven't found the unpadded location yet, keep going */
-	sz = MAX(upos + np - (i + offset), 8192);
-	if (-1 == calculate_consensus_simple(io, contig,
-					     i + offset, i + offset + sz,
-					     cons, NULL)) {
-	    free(cons);
+    /* Each column indexed adds at most one non-pad */
+    while (pi->nbases < upos && pi->len < pi->ncols) {
+	if (-1 == pad_index_extend(io, c, pi->len + upos - pi->nbases)) {
+	    cache_decr(io, c);
 	    return -1;
 	}
-					     
-	offset += i;
-	i_end = sz+1;
+	pi = c->pad_index;
     }
 
-    *pos = i + offset;
-    free(cons);
+    *pos = pad_index_select(pi, upos);
+    cache_decr(io, c);
 
     return 0;
 }
@@ -415,6 +415,9 @@ static void contig_unload(GapIO *io, cached_item *ci, int unlock) {
     if (c->haplo_hash)
 	HashTableDestroy(c->haplo_hash, 0);
 
+    if (c->pad_index)
+	free(c->pad_index);
+
     if (unlock)
 	io->iface->contig.unlock(io->dbh, ci->view);
     cache_free(ci);
@@ -438,6 +441,9 @@ static void contig_block_unload(GapIO *io, cached_item *ci, int unlock) {
 	    if (c->haplo_hash)
 		HashTableDestroy(c->haplo_hash, 0);
 
+	    if (c->pad_index)
+		free(c->pad_index);
+
 	    if (si)
 		free(si);
 	}
@@ -1320,6 +1326,8 @@ int cache_flush(GapIO *io) {
 				ArrayDestroy(bo->contig[j]->link);
 			    if (bo->contig[j]->haplo_hash)
 				HashTableDestroy(bo->contig[j]->haplo_hash, 0);
+			    if (bo->contig[j]->pad_index)
+				free(bo->contig[j]->pad_index);
 			    if (strcmp(bo->contig[j]->name,
 				       bn->contig[j]->name) &&
 				!io->base->base) {
@@ -2929,9 +2937,11 @@ cached_item *cache_dup(GapIO *io, cached_item *sub_ci) {
 		c->link = NULL; /* Just incase! */
 	    }
 
-	    /* Force creation of a new haplo_hash, if needed */
+	    /* Force creation of a new haplo_hash and pad_index, if needed */
 	    c->haplo_hash = NULL;
 	    c->haplo_timestamp = 0;
+	    c->pad_index = NULL;
+	    c->pad_timestamp = 0;
 
 	    break;
 	}
@@ -3129,9 +3139,11 @@ cached_item *cache_dup(GapIO *io, cached_item *sub_ci) {
 		       ArrayMax(oc->link) * sizeof(contig_link_t));
 	    }
 
-	    /* Force creation of a new haplo_hash, if needed */
+	    /* Force creation of a new haplo_hash and pad_index, if needed */
 	    c->haplo_hash = NULL;
 	    c->haplo_timestamp = 0;
+	    c->pad_index = NULL;
+	    c->pad_timestamp = 0;
 
 
 	    c->block = b;
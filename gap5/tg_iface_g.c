@@ -1875,6 +1875,8 @@ static cached_item *io_contig_read(void *dbh, tg_rec rec) {
     c->clipped_timestamp = 0;
     c->haplo_hash = NULL;
     c->haplo_timestamp = 0;
+    c->pad_index = NULL;
+    c->pad_timestamp = 0;
 
     free(ch);
 
@@ -5130,6 +5132,8 @@ static cached_item *io_contig_block_read(void *dbh, tg_rec rec) {
 	/* Nul values as these are in-memory only */
 	in[i].haplo_timestamp = 0;
 	in[i].haplo_hash = NULL;
+	in[i].pad_timestamp = 0;
+	in[i].pad_index = NULL;
     }
 
     /* Flags */
@@ -373,6 +373,10 @@ typedef struct {
     int haplo_start, haplo_end;
     tg_rec haplo_rec;
 
+    // To optimise padded/unpadded coordinate conversion
+    int pad_timestamp;
+    struct pad_index *pad_index;
+
     // Variable length data
     char  *name;
     char   data[1];
@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <os.h>
 #include <io_lib/misc.h>
@@ -76,13 +77,13 @@ double get_area(TRACE *trace, int startp, int endp)
     return(sum);
 }
 
-double total_area(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int endp)
+/**
+ * The area functions below all take the four per-channel areas for a base,
+ * as found by get_area(), so that each trace is only summed once per base.
+ */
+double total_area(double x, double y, double z, double w)
 {
-    double x,y,z,w,u;
-    x = get_area(tx,stp,endp);
-    y = get_area(ty,stp,endp);
-    z = get_area(tz,stp,endp);
-    w = get_area(tw,stp,endp);
+    double u;
     /*u = (w + x + y + z)/4.0;*/
     u = (w + x + y + z);
     /*printf("%f %f %f %f %f \n",w,x,y,z,u);*/
@@ -91,13 +92,9 @@ double total_area(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int endp)
 
 /** return sum_area_for_smallest_two_peaks / sum_area_for_largest_two_peaks
  */
-double max_area2(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int endp)
+double max_area2(double x, double y, double z, double w)
 {
-    double x,y,z,w,u,v;
-    x = get_area(tx,stp,endp);
-    y = get_area(ty,stp,endp);
-    z = get_area(tz,stp,endp);
-    w = get_area(tw,stp,endp);
+    double u,v;
 
     if ((w >= x) && (w >= y) && (w >= z)) {
 	if ((x >= y) && (x >= z)) {
@@ -175,13 +172,8 @@ double max_area2(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int endp)
 /**
  * return maximum peak area
  */
-double max_peak_area(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int endp)
+double max_peak_area(double x, double y, double z, double w)
 {
-    double x,y,z,w;
-    x = get_area(tx,stp,endp);
-    y = get_area(ty,stp,endp);
-    z = get_area(tz,stp,endp);
-    w = get_area(tw,stp,endp);
     /*printf("%f %f %f %f\n",w,x,y,z);*/
 
     if ((w >= x) && (w >= y) && (w >= z)) {
@@ -200,15 +192,12 @@ double max_peak_area(TRACE *tx, TRACE *ty, TRACE *tz, TRACE *tw, int stp, int en
 /**
  * smooth using window
  * and make the bits at the edge = first window
+ * a[] is workspace of at least l elements
  */
 
-void smoothe(double i[], int l, int w) {
+void smoothe(double i[], int l, int w, double a[]) {
   int r, f, m, wo2;
-  double s, *a;
-
-  if (NULL == (a = (double *)xcalloc(l, sizeof(double)))) {
-    return;
-  }
+  double s;
 
   wo2 = w / 2;
 
@@ -227,7 +216,6 @@ void smoothe(double i[], int l, int w) {
   for(r=0;r<l-1;r++) a[r] = a[r] / w;
   a[l-1] = a[l-2];
   for(r=0;r<l;r++) i[r] = a[r];
-  xfree(a);
 }
 
 /**
@@ -317,45 +305,130 @@ int find_heterozygous_indel(double *half_signal, double *envelope_signal,
 
 
 
-int heterozygous_indels(Read *r, HETINS_PARAMS params) {
+/**
+ * Work arrays for heterozygous_indels(). These are kept from one trace to the
+ * next, and only grown when a longer trace comes along, so that batches of
+ * traces are not dominated by allocation.
+ */
+typedef struct HETINS_SCRATCH_ {
+  double *signal, *good_signal, *good_signal_grad, *good_signal_grad_grad;
+  double *envelope_signal, *half_signal, *max_peak, *smooth;
+  double *envelope;
+  int    nbases;	/* allocated length of the per-base arrays */
+  int    npoints;	/* allocated length of envelope */
+}HETINS_SCRATCH;
+
+void free_hetins_scratch(HETINS_SCRATCH *s) {
+  xfree(s->signal);
+  xfree(s->good_signal);
+  xfree(s->good_signal_grad);
+  xfree(s->good_signal_grad_grad);
+  xfree(s->envelope_signal);
+  xfree(s->half_signal);
+  xfree(s->max_peak);
+  xfree(s->smooth);
+  xfree(s->envelope);
+  memset(s, 0, sizeof(*s));
+}
+
+/**
+ * Makes sure s can hold a trace of nbases bases and npoints samples, and
+ * clears the part of it that will be used.
+ * Returns 0 on success, -1 on failure or if there are no bases.
+ */
+int init_hetins_scratch(HETINS_SCRATCH *s, int nbases, int npoints) {
+  if (nbases < 1)
+    return -1;
+
+  if (nbases > s->nbases) {
+    int n = MAX(nbases, 2*s->nbases);
+    xfree(s->signal);
+    xfree(s->good_signal);
+    xfree(s->good_signal_grad);
+    xfree(s->good_signal_grad_grad);
+    xfree(s->envelope_signal);
+    xfree(s->half_signal);
+    xfree(s->max_peak);
+    xfree(s->smooth);
+    s->signal = (double *)xmalloc(n * sizeof(double));
+    s->good_signal = (double *)xmalloc(n * sizeof(double));
+    s->good_signal_grad = (double *)xmalloc(n * sizeof(double));
+    s->good_signal_grad_grad = (double *)xmalloc(n * sizeof(double));
+    s->envelope_signal = (double *)xmalloc(n * sizeof(double));
+    s->half_signal = (double *)xmalloc(n * sizeof(double));
+    s->max_peak = (double *)xmalloc(n * sizeof(double));
+    s->smooth = (double *)xmalloc(n * sizeof(double));
+    s->nbases = n;
+    if (!s->signal || !s->good_signal || !s->good_signal_grad ||
+	!s->good_signal_grad_grad || !s->envelope_signal ||
+	!s->half_signal || !s->max_peak || !s->smooth) {
+      free_hetins_scratch(s);
+      return -1;
+    }
+  }
+  if (npoints > s->npoints) {
+    int n = MAX(npoints, 2*s->npoints);
+    xfree(s->envelope);
+    if (NULL == (s->envelope = (double *)xmalloc(n * sizeof(double)))) {
+      free_hetins_scratch(s);
+      return -1;
+    }
+    s->npoints = n;
+  }
+
+  memset(s->signal, 0, nbases * sizeof(double));
+  memset(s->good_signal, 0, nbases * sizeof(double));
+  memset(s->good_signal_grad, 0, nbases * sizeof(double));
+  memset(s->good_signal_grad_grad, 0, nbases * sizeof(double));
+  memset(s->envelope_signal, 0, nbases * sizeof(double));
+  memset(s->half_signal, 0, nbases * sizeof(double));
+  memset(s->max_peak, 0, nbases * sizeof(double));
+  if (s->envelope && npoints > 0)
+    memset(s->envelope, 0, npoints * sizeof(double));
+  return 0;
+}
+
+int heterozygous_indels(Read *r, HETINS_PARAMS params, HETINS_SCRATCH *s) {
     int i, ret = -1, mode;
     int start_pos,end_pos,good_bases;
     int win_len;
     double *signal, *good_signal, *good_signal_grad, *good_signal_grad_grad;
     double *envelope, *envelope_signal, *half_signal, *max_peak;
+    double c, g, a, t;
 
     win_len = params.window;
     mode    = params.mode;
     good_bases = r->NBases - 1;
 
-    signal = good_signal = good_signal_grad = good_signal_grad_grad = NULL;
-    envelope = envelope_signal = half_signal = max_peak = NULL;
-    if (NULL == (signal = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (max_peak = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (good_signal = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (good_signal_grad = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (good_signal_grad_grad = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (envelope = (double *)xcalloc(r->NPoints, sizeof(double))))goto bail_out;
-    if (NULL == (envelope_signal = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
-    if (NULL == (half_signal = (double *)xcalloc(good_bases, sizeof(double))))goto bail_out;
+    if (init_hetins_scratch(s, good_bases, r->NPoints)) return -1;
+    signal = s->signal;
+    max_peak = s->max_peak;
+    good_signal = s->good_signal;
+    good_signal_grad = s->good_signal_grad;
+    good_signal_grad_grad = s->good_signal_grad_grad;
+    envelope = s->envelope;
+    envelope_signal = s->envelope_signal;
+    half_signal = s->half_signal;
+
     for (i = 1; i < good_bases-1; i++) {
       start_pos = (r->basePos)[i]-((r->basePos)[i] - (r->basePos[i-1])) /2;
       end_pos   = (r->basePos)[i]+((r->basePos)[i+1] - (r->basePos[i])) /2;
-      signal[i] = total_area(r->traceC, r->traceG, r->traceA,
-			     r->traceT, start_pos, end_pos);
-      max_peak[i] = max_peak_area(r->traceC, r->traceG, r->traceA,
-				  r->traceT, start_pos, end_pos);
-      half_signal[i] = max_area2(r->traceC, r->traceG, r->traceA,
-				 r->traceT, start_pos, end_pos);
+      c = get_area(r->traceC, start_pos, end_pos);
+      g = get_area(r->traceG, start_pos, end_pos);
+      a = get_area(r->traceA, start_pos, end_pos);
+      t = get_area(r->traceT, start_pos, end_pos);
+      signal[i] = total_area(c, g, a, t);
+      max_peak[i] = max_peak_area(c, g, a, t);
+      half_signal[i] = max_area2(c, g, a, t);
     }
 
     if(get_envelope(r->traceC, r->traceG, r->traceA,
-		    r->traceT, envelope, r->NPoints)) goto bail_out;
+		    r->traceT, envelope, r->NPoints)) return -1;
     calc_peak_trough_values(r, envelope, envelope_signal);
-    smoothe(signal,good_bases-1,win_len);
-    smoothe(max_peak,good_bases-1,win_len);
-    smoothe(envelope_signal,good_bases-1,win_len);
-    smoothe(half_signal,good_bases-1,win_len);
+    smoothe(signal,good_bases-1,win_len,s->smooth);
+    smoothe(max_peak,good_bases-1,win_len,s->smooth);
+    smoothe(envelope_signal,good_bases-1,win_len,s->smooth);
+    smoothe(half_signal,good_bases-1,win_len,s->smooth);
     get_good_signal(signal, max_peak, good_signal, good_bases);
     grad(good_signal,good_signal_grad,good_bases-1,win_len);
     grad(good_signal_grad,good_signal_grad_grad,good_bases-1,10);
@@ -374,26 +447,20 @@ int heterozygous_indels(Read *r, HETINS_PARAMS params) {
 				    good_signal_grad, good_signal_grad_grad,
 				    good_bases, params);
     }
- bail_out:
-    xfree(good_signal_grad_grad);
-    xfree(good_signal_grad);
-    xfree(good_signal);
-    xfree(half_signal);
-    xfree(signal);
-    xfree(max_peak);
-    xfree(envelope_signal);
-    xfree(envelope);
     return ret;
 }
 
 void usage(HETINS_PARAMS params) {
 
     fprintf(stderr,
-	    "Usage: hetins [options] file_name\n"
+	    "Usage: hetins [options] file_name ...\n"
 	    "Where options are:\n"
 	    "    [-w window_length (%d)]           [-e worst_envelope (%f)]\n"
 	    "    [-h worst_half_signal (%f)]  [-g good_signal_grad_indel (%f)]\n"
-	    "    [-t debug only]       file_name\n",
+	    "    [-f file_of_filenames]\n"
+	    "    [-t debug only]       file_name ...\n"
+	    "When more than one file is given each result line is prefixed\n"
+	    "by its file name.\n",
 	    params.window, params.worst_envelope, params.worst_half_signal,
 	    params.good_signal_grad_indel);
     exit(1);
@@ -408,56 +475,24 @@ void usage(HETINS_PARAMS params) {
 
 #define BUFSIZE 1024
 
-int main(int argc, char **argv) {
+/**
+ * Looks for a heterozygous indel in one experiment or trace file, printing
+ * the result and (for experiment files) adding a tag and updating QR.
+ * batch is set when several files are being processed, in which case the
+ * result is prefixed by the file name.
+ * Returns 0 on success, -1 on failure.
+ */
+int hetins_file(char *fn, HETINS_PARAMS params, HETINS_SCRATCH *s, int batch) {
   char buffer[BUFSIZE];
-  char *fn;
-  int c;
-  HETINS_PARAMS params;
   Read *read = NULL;
   Exp_info *exp_file = NULL;
   int file_type, ret;
   int qr;
-  extern DLL_IMPORT char *optarg;
-  extern DLL_IMPORT int optind;
 
-  params.window = 101;
-  params.worst_envelope = 0.5;
-  params.worst_half_signal     = 0.15;
-  params.good_signal_grad_indel = -0.146;
-  params.mode = 0;
-
-
-  while ((c = getopt(argc, argv, "w:e:h:g:tT")) != -1) {
-    switch (c) {
-    case 'T':
-      params.mode = FULL_TEST;
-      break;
-    case 't':
-      params.mode = TEST;
-      break;
-    case 'w':
-      params.window = atoi(optarg);
-      break;
-    case 'e':
-      params.worst_envelope = atof(optarg);
-      break;
-    case 'h':
-      params.worst_half_signal = atof(optarg);
-      break;
-    case 'g':
-      params.good_signal_grad_indel = atof(optarg);
-      break;
-    default:
-      usage(params);
-    }
-  }
-  if (optind == argc) usage(params);
-
-  fn = argv[optind];
   file_type = determine_trace_type(fn);
 
   if ((file_type == TT_PLN) || (file_type == TT_UNK)) {
-    fprintf(stderr,"Input file not EXP or trace\n");
+    fprintf(stderr,"Input file %s not EXP or trace\n", fn);
     goto bail_out;
   }
 
@@ -496,14 +531,17 @@ int main(int argc, char **argv) {
     params.mode = TEST;
   }
 
-  ret = heterozygous_indels(read, params);
+  ret = heterozygous_indels(read, params, s);
 
   if (params.mode == TEST ) {
     printf("%s %d\n",fn,ret);
   }
   else if (params.mode != FULL_TEST ) {
 
-    fprintf(stdout,"%d\n",ret);
+    if (batch)
+      fprintf(stdout,"%s %d\n",fn,ret);
+    else
+      fprintf(stdout,"%d\n",ret);
     if (ret && (file_type == TT_EXP) && (params.mode != 1)) {
       /* write out a tag */
       sprintf(buffer, "HETI = %d..%d\n %d %5.3f %5.3f %6.3f",
@@ -534,3 +572,74 @@ int main(int argc, char **argv) {
   return -1;
 }
 
+int main(int argc, char **argv) {
+  char fn[BUFSIZE], *cp;
+  char *fofn = NULL;
+  FILE *fp;
+  int c, i, ret = 0;
+  HETINS_PARAMS params;
+  HETINS_SCRATCH scratch;
+  extern DLL_IMPORT char *optarg;
+  extern DLL_IMPORT int optind;
+
+  params.window = 101;
+  params.worst_envelope = 0.5;
+  params.worst_half_signal     = 0.15;
+  params.good_signal_grad_indel = -0.146;
+  params.mode = 0;
+
+
+  while ((c = getopt(argc, argv, "w:e:h:g:f:tT")) != -1) {
+    switch (c) {
+    case 'T':
+      params.mode = FULL_TEST;
+      break;
+    case 't':
+      params.mode = TEST;
+      break;
+    case 'w':
+      params.window = atoi(optarg);
+      break;
+    case 'e':
+      params.worst_envelope = atof(optarg);
+      break;
+    case 'h':
+      params.worst_half_signal = atof(optarg);
+      break;
+    case 'g':
+      params.good_signal_grad_indel = atof(optarg);
+      break;
+    case 'f':
+      fofn = optarg;
+      break;
+    default:
+      usage(params);
+    }
+  }
+  if (optind == argc && !fofn) usage(params);
+
+  memset(&scratch, 0, sizeof(scratch));
+
+  for (i = optind; i < argc; i++) {
+    if (hetins_file(argv[i], params, &scratch, fofn || argc - optind > 1))
+      ret = -1;
+  }
+
+  if (fofn) {
+    if (NULL == (fp = fopen(fofn, "r"))) {
+      fprintf(stderr, "Couldn't open file of filenames %s\n", fofn);
+      ret = -1;
+    } else {
+      while (fgets(fn, BUFSIZE, fp)) {
+	if ((cp = strchr(fn, '\n'))) *cp = 0;
+	if (!*fn) continue;
+	if (hetins_file(fn, params, &scratch, 1))
+	  ret = -1;
+      }
+      fclose(fp);
+    }
+  }
+
+  free_hetins_scratch(&scratch);
+  return ret;
+}
@@ -62,6 +62,7 @@ Alignment::Alignment()
    m_nBand              = 0;
    m_pParams            = 0;
    m_pOverlap           = 0;
+   m_pWorkspace         = 0;
    m_nPadSymbol         = '*';
    m_nEdgeScore         = EDGE_SCORE_RIGHT;
    m_nGapPenaltyBegin   = 12;
@@ -193,6 +194,7 @@ int Alignment::Execute( algorithm_t a )
    sp::set_align_params( m_pParams, m_nBand, m_nGapPenaltyBegin, m_nGapPenaltyExtend,
                         SP_ALIGNMENT_RETURN_SEQ, 0, 0, m_nPadSymbol, m_nPadSymbol,
                         0, 0, a, 8, 0, m_nEdgeScore, 0.0, m_oMatrix.Raw() );
+   sp::set_align_params_workspace( m_pParams, m_pWorkspace );
 
 
 
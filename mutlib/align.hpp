@@ -68,6 +68,7 @@ class Alignment
    void   EdgeScore( edge_score_t es );
    void   InputSequence( int n, const char* s, int l=-1 );
    void   Matrix( int** m, int n, bool AutoDestroy=true );
+   void   Workspace( sp::ALIGN_WORKSPACE* w )             { m_pWorkspace=w; }
    int    Execute( algorithm_t a );
    double OutputScore() const;
    char*  OutputSequence( int n ) const;
@@ -89,6 +90,7 @@ class Alignment
    int               m_nBand;
    sp::ALIGN_PARAMS* m_pParams;
    sp::OVERLAP*      m_pOverlap;
+   sp::ALIGN_WORKSPACE* m_pWorkspace;
    SimpleMatrix<int> m_oMatrix;
    int               m_nPadSymbol;
    int               m_nEdgeScore;
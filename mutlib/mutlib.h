@@ -210,6 +210,13 @@ int             TraceDiffGetTagCount( tracediff_t* td );
 mutlib_tag_t*   TraceDiffGetTag( tracediff_t* td, int n );
 
 
+/** Called once per input, in input order, after each batch execution */
+typedef void (*tracediff_batch_callback_t)( tracediff_t* td, int n, void* data );
+
+mutlib_result_t TraceDiffExecuteBatch( tracediff_t* td, tracediff_algorithm_t a, mutlib_trace_t* in,
+                                       int count, tracediff_batch_callback_t f, void* data );
+
+
 
 /*---------------------*/
 /* MutScan Definitions */
@@ -249,6 +256,7 @@ typedef struct
    char*             ResultString;
 
    /* Internal objects owned by mutscan */
+   tracealign_t      Alignment;
    int               Initialised;
 
 }mutscan_t;
@@ -272,6 +280,13 @@ int             MutScanGetTagCount( mutscan_t* ms );
 mutlib_tag_t*   MutScanGetTag( mutscan_t* ms, int n );
 
 
+/** Called once per input, in input order, after each batch execution */
+typedef void (*mutscan_batch_callback_t)( mutscan_t* ms, int n, void* data );
+
+mutlib_result_t MutScanExecuteBatch( mutscan_t* ms, mutlib_trace_t* in, int count,
+                                     mutscan_batch_callback_t f, void* data );
+
+
 
 
 #ifdef __cplusplus
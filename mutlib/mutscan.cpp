@@ -44,6 +44,7 @@ void MutScanInit( mutscan_t* ms )
    std::memset( ms, 0, sizeof(mutscan_t) );
    for( int n=0; n<MUTSCAN_PARAMETERS; n++ )
        ms->Parameter[n] = Parameter[n].Default();
+   TraceAlignInit( &ms->Alignment );
    ms->Initialised = 1;
 }
 
@@ -60,6 +61,7 @@ void MutScanDestroy( mutscan_t* ms )
    try
    {
       // Delete all data
+      TraceAlignDestroy( &ms->Alignment );
       MutScanDestroyResults( ms );
    }
    catch(...)
@@ -206,7 +208,6 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
            STATE_MUTATION_POSITION, STATE_COVERAGE_TAG, STATE_MUTATION_TAG,
            STATE_EXIT };
     int                 n;
-    tracealign_t        ta;
     mutlib_result_t     Result;
     mutlib_strand_t     Strand = MUTLIB_STRAND_FORWARD; // silence warning
     MutScanParameters   Parameter;
@@ -232,7 +233,6 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
             {
                 case STATE_INITIALISE:
                     // Destroy old results
-                    TraceAlignInit( &ta );
                     MutScanDestroyResults( ms );
                     Strand              = ms->InputTrace.Strand;
                     ms->ResultCode      = MUTLIB_RESULT_SUCCESS;
@@ -259,18 +259,24 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
 
 
                 case STATE_TRACE_ALIGN:
-                    // Align the reference and input traces
-                    TraceAlignSetReference( &ta, Strand, ms->ReferenceTrace[Strand].Trace, ms->ReferenceTrace[Strand].ClipL, ms->ReferenceTrace[Strand].ClipR );
-                    TraceAlignSetInput( &ta, Strand, ms->InputTrace.Trace, ms->InputTrace.ClipL, ms->InputTrace.ClipR );
-                    if( TraceAlignExecute(&ta) != MUTLIB_RESULT_SUCCESS )
+                    // Align the reference and input traces. The alignment object
+                    // persists between calls so the reference is only preprocessed
+                    // when a new one has been supplied.
+                    if( ms->ReferenceTrace[Strand].New )
                     {
-                        ms->ResultCode = TraceAlignGetResultCode( &ta );
-                        std::strcpy( ms->ResultString, TraceAlignGetResultString(&ta) );
+                        TraceAlignSetReference( &ms->Alignment, Strand, ms->ReferenceTrace[Strand].Trace, ms->ReferenceTrace[Strand].ClipL, ms->ReferenceTrace[Strand].ClipR );
+                        ms->ReferenceTrace[Strand].New = 0;
+                    }
+                    TraceAlignSetInput( &ms->Alignment, Strand, ms->InputTrace.Trace, ms->InputTrace.ClipL, ms->InputTrace.ClipR );
+                    if( TraceAlignExecute(&ms->Alignment) != MUTLIB_RESULT_SUCCESS )
+                    {
+                        ms->ResultCode = TraceAlignGetResultCode( &ms->Alignment );
+                        std::strcpy( ms->ResultString, TraceAlignGetResultString(&ms->Alignment) );
                         State = STATE_EXIT;
                         break;
                     }
                     for( int n=0; n<2; n++ )
-                        AlignedTrace[n].Wrap( TraceAlignGetAlignment(&ta, static_cast<mutlib_input_t>(n), &AlignedTraceClipL[n], &AlignedTraceClipR[n]), false );
+                        AlignedTrace[n].Wrap( TraceAlignGetAlignment(&ms->Alignment, static_cast<mutlib_input_t>(n), &AlignedTraceClipL[n], &AlignedTraceClipR[n]), false );
                     State = STATE_TRACE_PREPROCESS;
                     break;
 
@@ -412,7 +418,33 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
     // Exit
     if( DifferenceTrace )
         delete DifferenceTrace;
-    TraceAlignDestroy( &ta );
     return ms->ResultCode;
 }
 
+
+
+/**
+   Runs the mutation scanner over 'count' input traces against the current
+   reference traces. The reference is preprocessed once and shared by every
+   input. The callback, if given, is invoked after each input has been
+   processed so that its tags can be read in input order. Returns success if
+   every input succeeded, otherwise the result code of the last failure.
+*/
+mutlib_result_t MutScanExecuteBatch( mutscan_t* ms, mutlib_trace_t* in, int count,
+                                     mutscan_batch_callback_t f, void* data )
+{
+    mutlib_result_t Result = MUTLIB_RESULT_SUCCESS;
+    assert(ms != NULL);
+    assert(ms->Initialised);
+    assert((in != NULL) || (count == 0));
+    for( int n=0; n<count; n++ )
+    {
+        MutScanSetInput( ms, in[n].Strand, in[n].Trace, in[n].ClipL, in[n].ClipR );
+        if( MutScanExecute(ms) != MUTLIB_RESULT_SUCCESS )
+            Result = ms->ResultCode;
+        if( f )
+            f( ms, n, data );
+    }
+    return Result;
+}
+
@@ -1089,6 +1089,68 @@ void destroy_af_mem ( int *F1, int *F2, int *G1, int *G2, int *H1, int *H2,
     seq2_out = NULL;
 }
 
+/*
+ * Allocate the dynamic programming tables for affine_align_big() and
+ * affine_align_bits(). With no workspace attached to params these are
+ * plain allocations; otherwise they come from the workspace, which is
+ * grown geometrically so that a run of alignments settles on a single
+ * allocation. release_af_mem() frees whatever the workspace does not own.
+ */
+
+int *af_row ( ALIGN_PARAMS *params, int n, int size ) {
+
+    ALIGN_WORKSPACE *ws = params->workspace;
+    int i, new_size;
+
+    if ( !ws )
+	return (int *) xmalloc(sizeof(int) * size);
+
+    if ( size > ws->row_size ) {
+	new_size = MAX(size, 2 * ws->row_size);
+	for ( i = 0; i < 6; i++ ) {
+	    if ( ws->row[i] ) xfree ( ws->row[i] );
+	    ws->row[i] = NULL;
+	}
+	ws->row_size = 0;
+	for ( i = 0; i < 6; i++ ) {
+	    if(!(ws->row[i] = (int *) xmalloc(sizeof(int) * new_size)))
+		return NULL;
+	}
+	ws->row_size = new_size;
+    }
+    return ws->row[n];
+}
+
+unsigned char *af_bit_trace ( ALIGN_PARAMS *params, int size ) {
+
+    ALIGN_WORKSPACE *ws = params->workspace;
+    int new_size;
+
+    if ( !ws )
+	return (unsigned char *) xmalloc(size);
+
+    if ( size > ws->bit_trace_size ) {
+	new_size = MAX(size, 2 * ws->bit_trace_size);
+	if ( ws->bit_trace ) xfree ( ws->bit_trace );
+	ws->bit_trace_size = 0;
+	if(!(ws->bit_trace = (unsigned char *) xmalloc(new_size)))
+	    return NULL;
+	ws->bit_trace_size = new_size;
+    }
+    return ws->bit_trace;
+}
+
+void release_af_mem ( ALIGN_PARAMS *params,
+		      int *F1, int *F2, int *G1, int *G2, int *H1, int *H2,
+		      unsigned char *bit_trace, char *seq1_out, char *seq2_out ) {
+
+    if ( params->workspace ) {
+	F1 = F2 = G1 = G2 = H1 = H2 = NULL;
+	bit_trace = NULL;
+    }
+    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+}
+
 /**
  * dynamic programming routine using 3 tables
  */
@@ -1899,34 +1961,34 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
 
     /* init tables */
 
-    if(!(F1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(F1 = af_row(params, 0, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for F1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(F2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(F2 = af_row(params, 1, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for F2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(G1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(G1 = af_row(params, 2, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for G1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(G2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(G2 = af_row(params, 3, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for G2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(H1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(H1 = af_row(params, 4, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for H1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(H2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(H2 = af_row(params, 5, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for H2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
@@ -1984,7 +2046,7 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
     }
     else {
 	printf("scream: unknown gaps mode\n");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
   
@@ -2013,10 +2075,9 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
 	size_mat = (MIN(seq1_len - band_left, seq2_len - first_row) + 1) 
 	    * band_length;
 
-	if(!(bit_trace = (unsigned char *) 
-	     xmalloc(1 + sizeof(char) * size_mat / 4))) {
+	if(!(bit_trace = af_bit_trace(params, 1 + sizeof(char) * size_mat / 4))) {
 	    verror(ERR_WARN, "affine_align", "xmalloc failed for bit_trace");
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, 
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, 
 			     seq1_out, seq2_out );
 	    return -1;
 	}
@@ -2290,9 +2351,9 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
 
 	/* Initialise the bit trace */
 	size_mat = (seq1_len + 1) * (seq2_len + 1);
-	if(!(bit_trace = (unsigned char *) xmalloc(1 + sizeof(char) * size_mat / 4))) {
+	if(!(bit_trace = af_bit_trace(params, 1 + sizeof(char) * size_mat / 4))) {
 	    verror(ERR_WARN, "affine_align", "xmalloc failed for bit_trace");
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
 	j = 1 + size_mat / 4;
@@ -2499,7 +2560,7 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
     if( i = do_trace_back_bits ( bit_trace, seq1, seq2, seq1_len, seq2_len,
 				 &seq1_out, &seq2_out, &seq_out_len, b_r, b_c, b_e,
 				 band, first_band_left, first_row, band_length, NEW_PAD_SYM)) {
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
@@ -2508,17 +2569,17 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
     overlap->seq_out_len = seq_out_len;
 
     if ( i = seq_to_overlap (overlap, OLD_PAD_SYM, NEW_PAD_SYM)) {
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
     if ( params->return_job & SP_ALIGNMENT_RETURN_EDIT_BUFFERS ) {
 	if (seq_to_edit ( seq1_out,seq_out_len,&overlap->S1,&overlap->s1_len,NEW_PAD_SYM)) {
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
 	if (seq_to_edit ( seq2_out,seq_out_len,&overlap->S2,&overlap->s2_len,NEW_PAD_SYM)) {
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
     }
@@ -2536,7 +2597,7 @@ int affine_align_bits(OVERLAP *overlap, ALIGN_PARAMS *params) {
 	 * ensure that othr routines do not try to free it too 
 	 */
     }
-    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 
     return 0;
 }
@@ -2671,34 +2732,34 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
 
     /* init tables */
 
-    if(!(F1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(F1 = af_row(params, 0, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for F1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(F2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(F2 = af_row(params, 1, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for F2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(G1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(G1 = af_row(params, 2, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for G1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(G2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(G2 = af_row(params, 3, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for G2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(H1 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(H1 = af_row(params, 4, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for H1");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
-    if(!(H2 = (int *) xmalloc(sizeof(int) * (seq1_len + 2)))) {
+    if(!(H2 = af_row(params, 5, seq1_len + 2))) {
 	verror(ERR_WARN, "affine_align", "xmalloc failed for H2");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
@@ -2755,7 +2816,7 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
     }
     else {
 	printf("scream: unknown gaps mode\n");
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
   
@@ -2789,10 +2850,9 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
 	  printf("size_mat %d band %d band_left %d first_row %d band_length %d\n",size_mat,band,band_left,first_row,band_length);
 	*/
 	SIZE_MAT = size_mat + 1;
-	if(!(bit_trace = (unsigned char *) 
-	     xmalloc(1 + sizeof(char) * size_mat))) {
+	if(!(bit_trace = af_bit_trace(params, 1 + sizeof(char) * size_mat))) {
 	    verror(ERR_WARN, "affine_align", "xmalloc failed for bit_trace");
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, 
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, 
 			     seq1_out, seq2_out );
 	    return -1;
 	}
@@ -3122,9 +3182,9 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
 	/* Initialise the bit trace */
 	size_mat = (seq1_len + 1) * (seq2_len + 1);
 	SIZE_MAT = size_mat + 1;
-	if(!(bit_trace = (unsigned char *) xmalloc(1 + sizeof(char) * size_mat))) {
+	if(!(bit_trace = af_bit_trace(params, 1 + sizeof(char) * size_mat))) {
 	    verror(ERR_WARN, "affine_align", "xmalloc failed for bit_trace");
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
 	j = 1 + size_mat;
@@ -3333,7 +3393,7 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
     if( i = do_trace_back ( bit_trace, seq1, seq2, seq1_len, seq2_len,
 			    &seq1_out, &seq2_out, &seq_out_len, b_r, b_c, b_e,
 			    band, first_band_left, first_row, band_length, NEW_PAD_SYM)) {
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
@@ -3342,17 +3402,17 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
     overlap->seq_out_len = seq_out_len;
 
     if ( i = seq_to_overlap (overlap, OLD_PAD_SYM, NEW_PAD_SYM)) {
-	destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	return -1;
     }
 
     if ( params->return_job & SP_ALIGNMENT_RETURN_EDIT_BUFFERS ) {
 	if (seq_to_edit ( seq1_out,seq_out_len,&overlap->S1,&overlap->s1_len,NEW_PAD_SYM)) {
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
 	if (seq_to_edit ( seq2_out,seq_out_len,&overlap->S2,&overlap->s2_len,NEW_PAD_SYM)) {
-	    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+	    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
 	    return -1;
 	}
     }
@@ -3370,7 +3430,7 @@ int affine_align_big(OVERLAP *overlap, ALIGN_PARAMS *params) {
 	 * ensure that othr routines do not try to free it too 
 	 */
     }
-    destroy_af_mem ( F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
+    release_af_mem ( params, F1, F2, G1, G2, H1, H2, bit_trace, seq1_out, seq2_out );
     return 0;
 }
 
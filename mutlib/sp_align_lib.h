@@ -294,6 +294,14 @@ int do_trace_back ( unsigned char *bit_trace, char *seq1, char *seq2,
 void destroy_af_mem ( int *F1, int *F2, int *G1, int *G2, int *H1, int *H2,
             unsigned char *bit_trace, char *seq1_out, char *seq2_out );
 
+int *af_row ( ALIGN_PARAMS *params, int n, int size );
+
+unsigned char *af_bit_trace ( ALIGN_PARAMS *params, int size );
+
+void release_af_mem ( ALIGN_PARAMS *params,
+            int *F1, int *F2, int *G1, int *G2, int *H1, int *H2,
+            unsigned char *bit_trace, char *seq1_out, char *seq2_out );
+
 int affine_align(OVERLAP *overlap, ALIGN_PARAMS *params);
 
 int affine_align3(OVERLAP *overlap, ALIGN_PARAMS *params);
@@ -165,6 +165,46 @@ void destroy_align_params (ALIGN_PARAMS *params) {
     }
 }
 
+/**
+  * create an empty dynamic programming workspace. It is filled on demand
+  * by affine_align() and may be shared by successive alignments, but
+  * only by one alignment at a time.
+  */
+
+ALIGN_WORKSPACE *create_align_workspace(void) {
+    ALIGN_WORKSPACE *ws;
+    int i;
+
+    if(NULL == (ws = (ALIGN_WORKSPACE *) xmalloc(sizeof(ALIGN_WORKSPACE)))) {
+   verror(ERR_WARN, "create_align_workspace", "xmalloc failed");
+   return NULL;
+    }
+    for (i = 0; i < 6; i++) ws->row[i] = NULL;
+    ws->row_size = 0;
+    ws->bit_trace = NULL;
+    ws->bit_trace_size = 0;
+    return ws;
+}
+
+void destroy_align_workspace (ALIGN_WORKSPACE *ws) {
+    int i;
+
+    if (ws) {
+   for (i = 0; i < 6; i++) if (ws->row[i]) xfree(ws->row[i]);
+   if (ws->bit_trace) xfree(ws->bit_trace);
+   xfree(ws);
+    }
+}
+
+/**
+  * attach a workspace to params, or detach it with NULL. The caller
+  * retains ownership of the workspace.
+  */
+
+void set_align_params_workspace (ALIGN_PARAMS *params, ALIGN_WORKSPACE *ws) {
+    params->workspace = ws;
+}
+
 /**
   *create align params structure and initialise what we can
   * ie gap_open, gap_extend, band, edge mode, return job and word length
@@ -194,6 +234,7 @@ ALIGN_PARAMS *create_align_params(void) {
     params->algorithm = 0;
     params->score_matrix = NULL;
     params->hash = NULL;
+    params->workspace = NULL;
     params->word_length = 8;
     params->min_match = 0;
     params->max_prob = 0.0;
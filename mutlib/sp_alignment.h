@@ -53,6 +53,12 @@ ALIGN_PARAMS *create_align_params(void);
 
 void destroy_align_params (ALIGN_PARAMS *params);
 
+ALIGN_WORKSPACE *create_align_workspace(void);
+
+void destroy_align_workspace (ALIGN_WORKSPACE *ws);
+
+void set_align_params_workspace (ALIGN_PARAMS *params, ALIGN_WORKSPACE *ws);
+
 #ifdef DYNMAT
 int set_align_params (ALIGN_PARAMS *params, int band, int gap_open, 
              int gap_extend, int return_job, 
@@ -167,6 +167,17 @@ typedef struct hash_ {
   int min_match;
 } Hash;
 
+/*
+ * Reusable dynamic programming workspace for affine_align(). The row
+ * tables and traceback grow geometrically and are kept between calls.
+ */
+typedef struct Align_workspace {
+    int *row[6];
+    int row_size;
+    unsigned char *bit_trace;
+    int bit_trace_size;
+} ALIGN_WORKSPACE;
+
 typedef struct Align_params {
     int band;
     int gap_open;
@@ -192,6 +203,7 @@ typedef struct Align_params {
     W128_P score_matrix;
 #endif
     Hash *hash;
+    ALIGN_WORKSPACE *workspace;
 } ALIGN_PARAMS;
 /*    int (*score_matrix)[128][128];*/
 
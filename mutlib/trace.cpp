@@ -857,6 +857,35 @@ Trace* Trace::Clone( const char* pNewFileName ) const
 
 
 
+//----------
+// Envelope
+//----------
+
+void Trace::Envelope( int* e ) const
+{
+/*
+   Computes the envelope of this trace, the maximum of the four channels at
+   each sample, into 'e' which must hold at least Samples() values. The
+   channels are walked through raw pointers with no branches in the loop
+   body so the compiler is free to vectorise it.
+*/
+   assert(m_pRead!=0);
+   assert(e != NULL);
+   const int    nSamples = Samples();
+   const TRACE* a = m_pTrace[0];
+   const TRACE* c = m_pTrace[1];
+   const TRACE* g = m_pTrace[2];
+   const TRACE* t = m_pTrace[3];
+   for( int n=0; n<nSamples; n++ )
+   {
+      int m1 = a[n] > c[n] ? a[n] : c[n];
+      int m2 = g[n] > t[n] ? g[n] : t[n];
+      e[n]   = m1 > m2 ? m1 : m2;
+   }
+}
+
+
+
 //----------------
 // CreateEnvelope
 //----------------
@@ -866,22 +895,26 @@ Trace* Trace::CreateEnvelope() const
 /*
    Creates a new trace containing the envelope and bases of this trace and
    returns it to the caller. The envelope is stored in the 'A' trace channel.
-   The caller is responsible for deleting the envelope.
+   The caller is responsible for deleting the envelope. Callers that only
+   need the envelope values should use Envelope() instead.
 */
-   TRACE Max1;
-   TRACE Max2;
    Trace& Envelope = *Clone();
    if( &Envelope )
    {
-      for( int n=0; n<Envelope.Samples(); n++ )
+      const int nSamples = Envelope.Samples();
+      TRACE*    a = Envelope[0];
+      TRACE*    c = Envelope[1];
+      TRACE*    g = Envelope[2];
+      TRACE*    t = Envelope[3];
+      for( int n=0; n<nSamples; n++ )
       {
-         Max1 = std::max( Envelope[0][n], Envelope[1][n] );
-         Max2 = std::max( Envelope[2][n], Envelope[3][n] );
-         Envelope[0][n] = std::max( Max1, Max2 );
-         Envelope[1][n] = 0;
-         Envelope[2][n] = 0;
-         Envelope[3][n] = 0;
+         TRACE m1 = a[n] > c[n] ? a[n] : c[n];
+         TRACE m2 = g[n] > t[n] ? g[n] : t[n];
+         a[n]     = m1 > m2 ? m1 : m2;
       }
+      std::memset( c, 0, nSamples*sizeof(TRACE) );
+      std::memset( g, 0, nSamples*sizeof(TRACE) );
+      std::memset( t, 0, nSamples*sizeof(TRACE) );
    }
    return &Envelope;
 }
@@ -1033,14 +1066,22 @@ Trace* Trace::Subtract( Trace& t )
 
 
 
-    // Generate the difference trace centred around nMax
-    for( int k=0, d=0; k<Samples(); k++ )
+    // Generate the difference trace centred around nMax, one channel at a time
+    const int nSamples = Samples();
+    for( int j=0; j<4; j++ )
     {
-        for( int j=0; j<4; j++ )
+        const TRACE* p = m_pTrace[j];
+        const TRACE* q = t[j];
+        TRACE*       r = (*pDifference)[j];
+        if( nScale < 1.0 )
+        {
+            for( int k=0; k<nSamples; k++ )
+                r[k] = static_cast<TRACE>( (int(p[k]) - int(q[k])) / 2 + nMax );
+        }
+        else
         {
-            d = static_cast<int>(m_pTrace[j][k]) - static_cast<int>(t[j][k]);
-            d = static_cast<int>( d * nScale ) + nMax;
-            (*pDifference)[j][k] = static_cast<TRACE>( d );
+            for( int k=0; k<nSamples; k++ )
+                r[k] = static_cast<TRACE>( int(p[k]) - int(q[k]) + nMax );
         }
     }
 
@@ -1081,16 +1122,20 @@ void Trace::ScaleTo( Trace& t )
     // Compute pointwise scale factors using signal energy measure
     double e1, e2;
     double last_good_sf = 1.0;
+    const TRACE* t0 = t[0];
+    const TRACE* t1 = t[1];
+    const TRACE* t2 = t[2];
+    const TRACE* t3 = t[3];
     for( int n=0; n<nLen; n++ )
     {
         e1  = m_pTrace[0][n];
         e1 += m_pTrace[1][n];
         e1 += m_pTrace[2][n];
         e1 += m_pTrace[3][n];
-        e2  = t[0][n];
-        e2 += t[1][n];
-        e2 += t[2][n];
-        e2 += t[3][n];
+        e2  = t0[n];
+        e2 += t1[n];
+        e2 += t2[n];
+        e2 += t3[n];
         if( e1 == 0.0 )
             Scale[n] = last_good_sf;
         else
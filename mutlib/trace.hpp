@@ -41,6 +41,7 @@ class Trace
     void        Smooth();
     void        FillGaps();
     double      Mean( int n=-1 ) const;
+    void        Envelope( int* e ) const;
     Trace*      CreateEnvelope() const;
     Trace*      Subtract( Trace& t );
     void        ScaleTo( Trace& t );
@@ -259,6 +259,7 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
                     char* iseq = &(InputTrace.Raw()->base[ ta->Input.ClipL ]);
                     int   wlen = ta->Reference[Strand].ClipR - ta->Reference[Strand].ClipL - 1;
                     int   ilen = ta->Input.ClipR - ta->Input.ClipL - 1;
+                    Aligner.Workspace( Cache->Workspace() );
                     Aligner.InputSequence( 0, wseq, wlen );
                     Aligner.InputSequence( 1, iseq, ilen );
                     Aligner.EdgeScore( Alignment::EDGE_SCORE_RIGHT );
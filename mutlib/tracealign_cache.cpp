@@ -14,10 +14,22 @@
 
 
 #include <cassert>
+#include <new>                   // For std::bad_alloc
 #include <tracealign_cache.hpp>
 
 
 
+//------------
+// Destructor
+//------------
+
+TraceAlignCache::~TraceAlignCache()
+{
+   sp::destroy_align_workspace( m_pWorkspace );
+}
+
+
+
 //-------
 // Flush
 //-------
@@ -27,6 +39,28 @@ void TraceAlignCache::Flush()
    RefData[0].Flush();
    RefData[1].Flush();
    AlignmentMatrix.Empty();
+   sp::destroy_align_workspace( m_pWorkspace );
+   m_pWorkspace = 0;
+}
+
+
+
+//-----------
+// Workspace
+//-----------
+
+sp::ALIGN_WORKSPACE* TraceAlignCache::Workspace()
+{
+   // The DP tables are reused by every alignment made through this cache,
+   // growing as required, so a batch of inputs against one reference
+   // stops allocating once the longest alignment has been seen.
+   if( !m_pWorkspace )
+   {
+      m_pWorkspace = sp::create_align_workspace();
+      if( !m_pWorkspace )
+         throw std::bad_alloc();
+   }
+   return m_pWorkspace;
 }
 
 
@@ -19,6 +19,7 @@
 
 
 #include <matrix.hpp>
+#include <align.hpp>
 #include <tracealign_preprocess.hpp>
 
 
@@ -27,8 +28,8 @@ class TraceAlignCache
 {
  public:
    // Constructor/Destructor
-   TraceAlignCache()  { }
-  ~TraceAlignCache()  { }
+   TraceAlignCache()  { m_pWorkspace=0; }
+  ~TraceAlignCache();
 
 
 
@@ -36,6 +37,7 @@ class TraceAlignCache
    // Services
    void Flush();
    void CreateAlignmentMatrix( int nMatrixSize, int nLevels, int nOffset );
+   sp::ALIGN_WORKSPACE* Workspace();
 
 
 
@@ -43,6 +45,12 @@ class TraceAlignCache
    // Cached data
    TraceAlignPreprocessor RefData[2];
    SimpleMatrix<int>      AlignmentMatrix;
+
+
+
+ private:
+   // Data
+   sp::ALIGN_WORKSPACE*   m_pWorkspace;
 };
 
 
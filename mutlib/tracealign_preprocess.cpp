@@ -63,23 +63,10 @@ void TraceAlignPreprocessor::PreprocessTrace( Trace& t, bool bCacheBaseIntervalS
 
 
 
-   // Create a trace envelope in the A channel
-   Trace& Envelope = *t.CreateEnvelope();
-   if( !(&Envelope) )
-      throw std::bad_alloc();
-
-   
-
-   // Make copy of envelope
+   // Compute the trace envelope straight into our array
    m_oEnvelope.Empty();
    m_oEnvelope.Create( t.Samples() );
-   for( int n=0; n<t.Samples(); n++ )
-      m_oEnvelope[n] = Envelope[0][n];
-
-
-
-   // Cleanup
-   delete &Envelope;
+   t.Envelope( m_oEnvelope.Raw() );
 }
 
 
@@ -338,3 +338,30 @@ mutlib_result_t TraceDiffExecute( tracediff_t* td, tracediff_algorithm_t a )
     return td->ResultCode;
 }
 
+
+
+/**
+   Runs the trace difference algorithm over 'count' input traces against the
+   current reference traces. The reference is preprocessed once and shared by
+   every input. The callback, if given, is invoked after each input has been
+   processed so that its tags and difference trace can be read in input order.
+   Returns success if every input succeeded, otherwise the result code of the
+   last failure.
+*/
+mutlib_result_t TraceDiffExecuteBatch( tracediff_t* td, tracediff_algorithm_t a, mutlib_trace_t* in,
+                                       int count, tracediff_batch_callback_t f, void* data )
+{
+    mutlib_result_t Result = MUTLIB_RESULT_SUCCESS;
+    assert(td != NULL);
+    assert(td->Initialised);
+    assert((in != NULL) || (count == 0));
+    for( int n=0; n<count; n++ )
+    {
+        TraceDiffSetInput( td, in[n].Trace, in[n].Strand, in[n].ClipL, in[n].ClipR );
+        if( TraceDiffExecute(td,a) != MUTLIB_RESULT_SUCCESS )
+            Result = td->ResultCode;
+        if( f )
+            f( td, n, data );
+    }
+    return Result;
+}
@@ -206,6 +206,133 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
 #endif
 }
 
+
+
+//----------------
+// Batch Handling
+//----------------
+
+// Inputs are gathered and scanned in batches of up to BATCHSIZE so the
+// references are shared by every input in the batch, while only a bounded
+// number of traces and experiment files are held open at once.
+const int BATCHSIZE = 32;
+
+struct ScanBatch
+{
+    int             Count;
+    char            Name[BATCHSIZE][BUFSIZE];
+    Exp_info*       ExpFile[BATCHSIZE];
+    mutlib_trace_t  Input[BATCHSIZE];
+    bool            Quiet;
+    int             ProximityThreshold;
+};
+
+
+
+void FreeBatch( ScanBatch& b )
+{
+    for( int n=0; n<b.Count; n++ )
+    {
+        if( b.ExpFile[n] )      exp_destroy_info( b.ExpFile[n] );
+        if( b.Input[n].Trace )  read_deallocate( b.Input[n].Trace );
+    }
+    b.Count = 0;
+}
+
+
+
+// Called by MutScanExecuteBatch() once each input has been scanned
+void ReportInput( mutscan_t* ms, int n, void* data )
+{
+    char       pBuffer[BUFSIZE];
+    ScanBatch& b        = *static_cast<ScanBatch*>(data);
+    Exp_info*  pExpFile = b.ExpFile[n];
+
+
+
+    // Tell user what we've done
+    if( !b.Quiet )
+    {
+        std::fprintf( stdout, "Scanning: %s\n", b.Name[n] );
+        std::fflush( stdout );
+    }
+    if( MutScanGetResultCode(ms) )
+    {
+        // Error
+        std::fprintf( stderr, "%s", MutScanGetResultString(ms) );
+        std::fflush( stderr );
+        return;
+    }
+    int nTags = MutScanGetTagCount( ms );
+
+
+
+    // Find the rightmost tag position for this trace
+    int nRightmostTag = -1;
+    for( int i=0; i<nTags; i++ )
+    {
+        mutlib_tag_t* pTag = MutScanGetTag( ms, i );
+        if( pTag->Position[0] > nRightmostTag )
+            nRightmostTag = pTag->Position[0];
+    }
+
+
+
+    // If mutation tag is beyond the right clip point (as in the case of
+    // insertions/deletions), we adjust QR so that it's visible in gap4.
+    if( (nTags>0) && (b.Input[n].ClipR<=nRightmostTag) )
+    {
+        std::sprintf( pBuffer, "%d", nRightmostTag+1 );
+        exp_put_str( pExpFile, EFLT_QR, pBuffer, std::strlen(pBuffer) );
+    }
+
+    // Filter clusters of tags too close to the end of MCOV
+    filter_tags( *ms, nTags, b.ProximityThreshold );
+
+    // Output results
+    for( int i=0; i<nTags; i++ )
+    {
+        // Write mutation tags to experiment file & stdout
+        mutlib_tag_t* pTag = MutScanGetTag( ms, i );
+        assert(pTag != NULL);
+
+        if (!*pTag->Type)
+            continue;
+
+        bool bCoverageTag = std::strcmp(pTag->Type,"MCOV") == 0;
+        char sc = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
+        if( bCoverageTag )
+        {
+            std::sprintf( pBuffer, "%s %c %d..%d", pTag->Type, sc, pTag->Position[0], pTag->Position[1] );
+            if( !b.Quiet )
+            {
+                std::fprintf( stdout, "%s\n", pBuffer );
+                std::fflush( stdout );
+            }
+        }
+        else
+        {
+            std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, sc, pTag->Position[0], pTag->Position[1], pTag->Comment );
+            if( !b.Quiet )
+            {
+                std::fprintf( stdout, "%s %5d %s\n", pTag->Type, pTag->Position[0], pTag->Comment );
+                std::fflush( stdout );
+            }
+        }
+        exp_put_str(pExpFile, EFLT_TG, pBuffer, std::strlen(pBuffer) );
+    }
+}
+
+
+
+void RunBatch( mutscan_t& ms, ScanBatch& b )
+{
+    MutScanExecuteBatch( &ms, b.Input, b.Count, ReportInput, &b );
+    FreeBatch( b );
+}
+
+
+
 //-----------
 // Tracediff
 //-----------
@@ -237,7 +364,9 @@ int main( int argc, char* argv[] )
     double          nPeakDropThresholdLower   = -1.0;
     double          nHeterozygoteSNRThreshold = -1.0;
     int 	    proximityThreshold = 7;
+    ScanBatch       Batch;
     MutScanInit( &ms );
+    Batch.Count = 0;
 
 
 
@@ -420,7 +549,9 @@ int main( int argc, char* argv[] )
 
 
 
-        // File processing loop
+        // File processing loop, inputs are scanned a batch at a time
+        Batch.Quiet              = bQuiet;
+        Batch.ProximityThreshold = proximityThreshold;
         for( n=0; n<FileList.Length(); n++ )
         {
             // Cleanup from previous iteration
@@ -438,15 +569,6 @@ int main( int argc, char* argv[] )
 
 
 
-            // Tell user what we're doing
-            if( !bQuiet )
-            {
-                std::fprintf( stdout, "Scanning: %s\n", p );
-                std::fflush( stdout );
-            }
-
-
-
             // Open experiment file
             pExpFile = exp_read_info( p );
             if( !pExpFile )
@@ -557,79 +679,21 @@ int main( int argc, char* argv[] )
 
 
 
-            // Initialise the algorithm
-            MutScanSetInput( &ms, nStrand, pInputTrace, nInputClipL, nInputClipR );
-
-
-
-            // Execute the algorithm
-            MutScanExecute( &ms );
-            if( MutScanGetResultCode(&ms) )
-            {
-                // Error
-                std::fprintf( stderr, "%s", MutScanGetResultString(&ms) );
-                std::fflush( stderr );
-                continue;
-            }
-            int nTags = MutScanGetTagCount( &ms );
-
-
-
-            // Find the rightmost tag position for this trace
-            int nRightmostTag = -1;
-            for( int i=0; i<nTags; i++ )
-            {
-                mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
-                if( pTag->Position[0] > nRightmostTag )
-                    nRightmostTag = pTag->Position[0];
-            }
-
-
-
-            // If mutation tag is beyond the right clip point (as in the case of
-            // insertions/deletions), we adjust QR so that it's visible in gap4.
-            if( (nTags>0) && (nInputClipR<=nRightmostTag) )
-            {
-                std::sprintf( pBuffer, "%d", nRightmostTag+1 );
-                exp_put_str( pExpFile, EFLT_QR, pBuffer, std::strlen(pBuffer) );
-            }
-
-	    // Filter clusters of tags too close to the end of MCOV
-	    filter_tags( ms, nTags, proximityThreshold );
-
-            // Output results
-            for( int i=0; i<nTags; i++ )
-            {
-                // Write mutation tags to experiment file & stdout
-                mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
-                assert(pTag != NULL);
-
-		if (!*pTag->Type)
-		  continue;
-
-                bool bCoverageTag = std::strcmp(pTag->Type,"MCOV") == 0;
-                char sc = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
-                if( bCoverageTag )
-                {
-                    std::sprintf( pBuffer, "%s %c %d..%d", pTag->Type, sc, pTag->Position[0], pTag->Position[1] );
-                    if( !bQuiet )
-                    {
-                        std::fprintf( stdout, "%s\n", pBuffer );
-                        std::fflush( stdout );
-                    }
-                }
-                else
-                {
-                    std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, sc, pTag->Position[0], pTag->Position[1], pTag->Comment );
-                    if( !bQuiet )
-                    {
-                        std::fprintf( stdout, "%s %5d %s\n", pTag->Type, pTag->Position[0], pTag->Comment );
-                        std::fflush( stdout );
-                    }
-                }
-                exp_put_str(pExpFile, EFLT_TG, pBuffer, std::strlen(pBuffer) );
-            }
+            // Queue the input, the batch now owns the experiment file and trace
+            int k = Batch.Count++;
+            std::strncpy( Batch.Name[k], p, BUFSIZE-1 );
+            Batch.Name[k][BUFSIZE-1] = 0;
+            Batch.ExpFile[k]      = pExpFile;
+            Batch.Input[k].Trace  = pInputTrace;
+            Batch.Input[k].Strand = nStrand;
+            Batch.Input[k].ClipL  = nInputClipL;
+            Batch.Input[k].ClipR  = nInputClipR;
+            pExpFile    = 0;
+            pInputTrace = 0;
+            if( Batch.Count == BATCHSIZE )
+                RunBatch( ms, Batch );
         }
+        RunBatch( ms, Batch );
     }
     catch( std::bad_alloc& )
     {
@@ -653,6 +717,7 @@ int main( int argc, char* argv[] )
     if(pInputTrace)  read_deallocate(pInputTrace);
     if(pRefTrace[0]) read_deallocate(pRefTrace[0]);
     if(pRefTrace[1]) read_deallocate(pRefTrace[1]);
+    FreeBatch( Batch );
     MutScanDestroy( &ms );
     return 0;
 }
@@ -9,6 +9,7 @@
 #include <os.h>
 #include "seqInfo.h"
 #include "dna_utils.h"
+#include "fastq.h"
 #include "xalloc.h"
 #include <io_lib/misc.h>
 
@@ -28,6 +29,8 @@ typedef struct {
   int verbose;
   int test_mode;
   int min_len;
+  int fastq;		/* 1 => files are FASTQ, not experiment files */
+  FILE *log;		/* verbose output; stderr when FASTQ goes to stdout */
 } params;
 
 
@@ -143,6 +146,50 @@ int scan_right(params p, char *seq, int start_pos, int len) {
     return len + 1;
 }
 
+/*
+ * Finds the polyA/T clip points of seq between left_pos and right_pos.
+ * *sr is set to the new right clip, or -1 if there is no polyA/T tail, and
+ * *sl to the new left clip, or -1 if there is no polyA/T head.
+ *
+ * Returns 0 for success.
+ *        -1 if the sequence becomes shorter than p.min_len (in which case
+ *           the clip points found so far are still returned).
+ */
+static int polyA_points(params p, char *seq, int left_pos, int right_pos,
+			int *sl, int *sr) {
+    int i1;
+
+    *sl = *sr = -1;
+
+    i1 = right_pos;
+    right_pos = scan_left(p, seq, left_pos, right_pos);
+    
+    if (right_pos > 0 ) {
+      if (right_pos - left_pos < p.min_len) {
+	fprintf(stderr, "Sequence too short (length=%d)\n",
+		right_pos - left_pos);
+	return -1;
+      }
+      *sr = right_pos;
+    }
+    else {
+      /* first window not polyA or T so do nothing */
+      right_pos = i1;
+    }
+
+    left_pos = scan_right(p, seq, left_pos, right_pos);
+    if (left_pos > 0 ) {
+      if (right_pos - left_pos < p.min_len) {
+	fprintf(stderr, "Sequence too short (length=%d)\n",
+		right_pos - left_pos);
+	return -1;
+      }
+      *sl = left_pos;
+    }
+
+    return 0;
+}
+
 /*
  * Quality clips file 'file', updating the QL and QR records in the process.
  *
@@ -151,7 +198,7 @@ int scan_right(params p, char *seq, int start_pos, int len) {
  */
 static int polyA_clip(char *file, params p) {
     SeqInfo *si = NULL;
-    int i1, i2, seq_length, right_pos, left_pos;
+    int i1, i2, seq_length, right_pos, left_pos, ret;
     char *seq;
     char *expline;
     FILE *fp;
@@ -191,17 +238,9 @@ static int polyA_clip(char *file, params p) {
     }
     right_pos = MIN(i1,i2);
 
-    i1 = right_pos;
-    right_pos = scan_left(p, seq, left_pos, right_pos);
-    
-    if (right_pos > 0 ) {
-      if (right_pos - left_pos < p.min_len) {
-	fprintf(stderr, "Sequence too short (length=%d)\n",
-		right_pos - left_pos);
-	freeSeqInfo(si);
-	return -1;
-      }
+    ret = polyA_points(p, seq, left_pos, right_pos, &left_pos, &right_pos);
 
+    if (right_pos > 0 || left_pos > 0) {
       /* Append details onto the end of the Exp File */
       if (!p.test_mode) {
 	if (NULL == (fp = fopen(file, "a"))) {
@@ -209,53 +248,107 @@ static int polyA_clip(char *file, params p) {
 	  freeSeqInfo(si);
 	  return -1;
 	}
-	fprintf(fp, "SR   %d\n", right_pos);
+	if (right_pos > 0)
+	  fprintf(fp, "SR   %d\n", right_pos);
+	if (left_pos > 0)
+	  fprintf(fp, "SL   %d\n", left_pos);
 	fclose(fp);
       } else {
-	printf("%-30s SR %4d\n", file, right_pos);
+	if (right_pos > 0)
+	  printf("%-30s SR %4d\n", file, right_pos);
+	if (left_pos > 0)
+	  printf("%-30s SL %4d\n", file, left_pos);
       }
     }
-    else {
-      /* first window not polyA or T so do nothing */
-      right_pos = i1;
-      /*printf("%-30s no PolyA tail\n", file);*/
+
+    freeSeqInfo(si);
+    return ret;
+}
+
+/*
+ * PolyA clips every read in FASTQ file 'file' ("-" for stdin), writing
+ * them to stdout with the clip points added as SL and SR tags. Existing
+ * QL/QR/SL/SR tags (eg from qclip -F) bound the search. Reads that end up
+ * too short are reported, but still written out with any clip found.
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+static int polyA_clip_fastq(char *file, params p) {
+    fastq_entry *e;
+    FILE *fp;
+    int i1, i2, right_pos, left_pos, ret = 0, r;
+
+    if (strcmp(file, "-") == 0) {
+	fp = stdin;
+    } else if (NULL == (fp = fopen(file, "r"))) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
     }
 
-    left_pos = scan_right(p, seq, left_pos, right_pos);
-    if (left_pos > 0 ) {
-      if (right_pos - left_pos < p.min_len) {
-	fprintf(stderr, "Sequence too short (length=%d)\n",
-		right_pos - left_pos);
-	freeSeqInfo(si);
+    if (NULL == (e = fastq_entry_create())) {
+	if (fp != stdin)
+	    fclose(fp);
 	return -1;
-      }
+    }
 
-      /* Append details onto the end of the Exp File */
-      if (!p.test_mode) {
-	if (NULL == (fp = fopen(file, "a"))) {
-	  fprintf(stderr, "Failed to write file '%s'\n", file);
-	  freeSeqInfo(si);
-	  return -1;
+    while ((r = fastq_next(fp, e)) == 0) {
+	if (p.verbose)
+	    fprintf(stderr, "Clipping read %s\n", e->name);
+
+	i1 = i2 = 0;
+	fastq_get_tag(e, "QL", &i1);
+	fastq_get_tag(e, "SL", &i2);
+	left_pos = MAX(i1,i2);
+
+	i1 = i2 = e->seq_len - 1;
+	fastq_get_tag(e, "QR", &i1);
+	fastq_get_tag(e, "SR", &i2);
+	right_pos = MIN(i1,i2);
+
+	/* As for experiment files, keep any clip found before failing */
+	if (polyA_points(p, e->seq, left_pos, right_pos,
+			 &left_pos, &right_pos)) {
+	    fprintf(stderr, "    in read '%s'\n", e->name);
+	    ret = -1;
+	}
+
+	if (!p.test_mode) {
+	    if (right_pos > 0)
+		fastq_set_tag(e, "SR", right_pos);
+	    if (left_pos > 0)
+		fastq_set_tag(e, "SL", left_pos);
+	    if (fastq_write(stdout, e)) {
+		ret = -1;
+		break;
+	    }
+	} else {
+	    if (right_pos > 0)
+		printf("%-30s SR %4d\n", e->name, right_pos);
+	    if (left_pos > 0)
+		printf("%-30s SL %4d\n", e->name, left_pos);
 	}
-	fprintf(fp, "SL   %d\n", left_pos);
-	fclose(fp);
-      } else {
-	printf("%-30s SL %4d\n", file, left_pos);
-      }
     }
-    else {
-      /* first window not polyA or T so do nothing */
-      /*printf("%-30s no PolyT head\n", file);*/
+    if (r < 0) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	ret = -1;
     }
-    freeSeqInfo(si);
-    return 0;
+
+    fastq_entry_destroy(e);
+    if (fp != stdin)
+	fclose(fp);
+
+    return ret;
 }
 
 static void usage(void) {
 fprintf(stderr,
 	"Usage:\n"
-	"polyA_clip [-vt] [-p percent cutoff(95)] [-x min_length(0)]\n"
-	"                  [-w window length(50)] file...\n");
+	"polyA_clip [-vtF] [-p percent cutoff(95)] [-x min_length(0)]\n"
+	"                  [-w window length(50)] file...\n"
+	"\n"
+	"With -F the files are FASTQ (\"-\" for stdin) and FASTQ with SL/SR\n"
+	"tags is written to stdout.\n");
     exit(1);
 }
 
@@ -269,10 +362,11 @@ double perc;
     p.verbose = 0;
     p.window_len = 50;
     p.test_mode = 0;
+    p.fastq = 0;
     perc = 95.0;
     set_dna_lookup();
     set_char_set(1);
-    while ((c = getopt(argc, argv, "w:x:p:vtx")) != -1) {
+    while ((c = getopt(argc, argv, "w:x:p:vtF")) != -1) {
 	switch (c) {
 
 	case 'v':
@@ -283,6 +377,10 @@ double perc;
 	    p.test_mode = 1;
 	    break;
 
+	case 'F':
+	    p.fastq = 1;
+	    break;
+
 	case 'x':
 	    p.min_len = atoi(optarg);
 	    break;
@@ -303,14 +401,17 @@ double perc;
     if (optind == argc)
 	usage();
 
+    /* FASTQ output owns stdout, so chatter goes to stderr instead */
+    p.log = p.fastq ? stderr : stdout;
+
     p.score = p.window_len * perc/100.0;
 
     for (i = optind; i < argc; i++) {
 	int ret_val;
 
-	ret_val = polyA_clip(argv[i], p);
+	ret_val = p.fastq ? polyA_clip_fastq(argv[i], p) : polyA_clip(argv[i], p);
 	if (p.verbose)
-	    printf("    polyA_clip() returned %d\n", ret_val);
+	    fprintf(p.log, "    polyA_clip() returned %d\n", ret_val);
 
 	ret |= ret_val;
     }
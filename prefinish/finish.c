@@ -151,6 +151,8 @@ static finish_t *finish_new(void) {
     fin->template_dup = NULL;
     fin->prob_script = NULL;
     fin->solu_script = NULL;
+    Tcl_InitHashTable(&fin->prob_cache, TCL_ONE_WORD_KEYS);
+    Tcl_InitHashTable(&fin->solu_cache, 2);
     fin->left_extent = 0;
     fin->right_extent = 0;
     fin->template_used = NULL;
@@ -273,6 +275,9 @@ static void finish_del(finish_t *fin) {
 	fin->solu_script = NULL;
     }
 
+    Tcl_DeleteHashTable(&fin->prob_cache);
+    Tcl_DeleteHashTable(&fin->solu_cache);
+
     if (fin->template_used) {
 	xfree(fin->template_used);
 	fin->template_used = NULL;
@@ -294,7 +299,7 @@ static void finish_del(finish_t *fin) {
     }
 
     if (fin->external_seq_h) {
-	free_hash8n(fin->external_seq_h);
+	primer_index_destroy(fin->external_seq_h);
 	fin->external_seq_h = NULL;
     }
 
@@ -304,7 +309,7 @@ static void finish_del(finish_t *fin) {
     }
 
     if (fin->all_cons_h) {
-	free_hash8n(fin->all_cons_h);
+	primer_index_destroy(fin->all_cons_h);
 	fin->all_cons_h = NULL;
     }
 
@@ -921,7 +926,7 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	}
 	fin->all_cons_len = 0;
 	if (fin->all_cons_h) {
-	    free_hash8n(fin->all_cons_h);
+	    primer_index_destroy(fin->all_cons_h);
 	    fin->all_cons_h = NULL;
 	}
 
@@ -940,24 +945,13 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 
 	depad_seq(fin->all_cons, &fin->all_cons_len, NULL);
 
-	/* hash it */
-	if (init_hash8n(fin->all_cons_len, FIN_MAXPRIMERLEN,
-			4 /* word_length */,
-			0 /* max_matches - unused */,
-			0 /* min_match - unused */,
-			1 /* job */,
-			&fin->all_cons_h)) {
+	/* Index it, for checking primers against */
+	if (NULL == (fin->all_cons_h = primer_index_create(fin->all_cons,
+							   fin->all_cons_len))) {
 	    verror(ERR_WARN, "finish_init", "Failed to hash consenus");
-	    fin->all_cons_h = NULL;
 	    xfree(fin->all_cons);
 	    fin->all_cons = NULL;
 	}
-	
-	fin->all_cons_h->seq1 = fin->all_cons;
-	fin->all_cons_h->seq1_len = fin->all_cons_len;
-
-	hash_seqn(fin->all_cons_h, 1);
-	store_hashn(fin->all_cons_h);
 
 	if (check_contigs)
 	    xfree(check_contigs);
@@ -991,7 +985,7 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	}
 	fin->external_seq_len = 0;
 	if (fin->external_seq_h) {
-	    free_hash8n(fin->external_seq_h);
+	    primer_index_destroy(fin->external_seq_h);
 	    fin->external_seq_h = NULL;
 	}
 
@@ -1012,23 +1006,13 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 #endif
 
 	/* Hash it */
-	if (init_hash8n(fin->external_seq_len, FIN_MAXPRIMERLEN,
-			4 /* word_length */,
-			0 /* max_matches - unused */,
-			0 /* min_match - unused */,
-			1 /* job */,
-			&fin->external_seq_h)) {
+	if (NULL == (fin->external_seq_h =
+		     primer_index_create(fin->external_seq,
+					 fin->external_seq_len))) {
 	    verror(ERR_WARN, "finish_init", "Failed to hash external_seq");
-	    fin->external_seq_h = NULL;
 	    xfree(fin->external_seq);
 	    fin->external_seq = NULL;
 	}
-	
-	fin->external_seq_h->seq1 = fin->external_seq;
-	fin->external_seq_h->seq1_len = fin->external_seq_len;
-
-	hash_seqn(fin->external_seq_h, 1);
-	store_hashn(fin->external_seq_h);
     }
 
     if (eseq_alloced && eseq) {
@@ -1222,6 +1206,56 @@ static int tcl_classify_bases(finish_t *fin, Tcl_Interp *interp,
 }
 
 
+/*
+ * ---------------------------------------------------------------------------
+ * Problem and solution caches
+ *
+ * The problem and solution commands are functions of their base (and
+ * problem) bit arguments alone, and most bases of a contig share a handful
+ * of distinct bit patterns. We remember each answer so that the Tcl
+ * commands are evaluated once per pattern rather than once per base, both
+ * in find_problems and when rescoring every candidate experiment.
+ * ---------------------------------------------------------------------------
+ */
+
+/* Key for fin->prob_cache; fin->solu_cache uses an unsigned int[2] */
+#define RULE_KEY(bits) ((char *)(unsigned long)(bits))
+
+/*
+ * Looks up key in a rule cache, setting *val if found.
+ *
+ * Returns 1 if found,
+ *	   0 if not.
+ */
+static int rule_cache_find(Tcl_HashTable *t, char *key, unsigned int *val) {
+    Tcl_HashEntry *hash;
+
+    if (NULL == (hash = Tcl_FindHashEntry(t, key)))
+	return 0;
+
+    *val = (unsigned int)(unsigned long)Tcl_GetHashValue(hash);
+    return 1;
+}
+
+static void rule_cache_add(Tcl_HashTable *t, char *key, unsigned int val) {
+    Tcl_HashEntry *hash;
+    int is_new;
+
+    hash = Tcl_CreateHashEntry(t, key, &is_new);
+    Tcl_SetHashValue(hash, (ClientData)(unsigned long)val);
+}
+
+/*
+ * Forgets all cached answers. Called whenever the problem or solution
+ * commands change.
+ */
+static void rule_cache_reset(finish_t *fin) {
+    Tcl_DeleteHashTable(&fin->prob_cache);
+    Tcl_DeleteHashTable(&fin->solu_cache);
+    Tcl_InitHashTable(&fin->prob_cache, TCL_ONE_WORD_KEYS);
+    Tcl_InitHashTable(&fin->solu_cache, 2);
+}
+
 /*
  * Given a tag 'curr_tag' on a reading 'r', we convert the tag corrdinates
  * into absolute contig coordinates and return these in start_p and end_p
@@ -1266,6 +1300,7 @@ static int tcl_find_problems(finish_t *fin, Tcl_Interp *interp,
     GAnnotations *curr_tag;
     int tag_start, tag_end;
     int do_ctags;
+    unsigned int solu_key[2];
 
     typedef struct {
 	Tcl_Obj *prob;
@@ -1317,6 +1352,8 @@ static int tcl_find_problems(finish_t *fin, Tcl_Interp *interp,
 	xfree(fin->solu_script);
     fin->solu_script = strdup(Tcl_GetString(args.solu));
 
+    rule_cache_reset(fin);
+
     if (fin->tag_mask) {
 	xfree(fin->tag_mask);
 	fin->tag_mask = NULL;
@@ -1381,23 +1418,26 @@ static int tcl_find_problems(finish_t *fin, Tcl_Interp *interp,
 	    }
 	}
 
-	/* Call problem_command */
-	Tcl_SetIntObj(prob_objv[1], fin->base_bits[i]);
-	if (TCL_OK != Tcl_EvalObjv(interp, 2, prob_objv, TCL_EVAL_GLOBAL)) {
-	    fprintf(stderr, "Eval failed '%s'\n", Tcl_GetStringResult(interp));
-	    continue;
-	}
-
-	pobj = Tcl_GetObjResult(interp);
-	Tcl_IncrRefCount(pobj);
+	/* Call problem_command, unless we already know the answer */
+	if (!rule_cache_find(&fin->prob_cache, RULE_KEY(fin->base_bits[i]),
+			     &fin->prob_bits[i])) {
+	    Tcl_SetIntObj(prob_objv[1], fin->base_bits[i]);
+	    if (TCL_OK != Tcl_EvalObjv(interp, 2, prob_objv,
+				       TCL_EVAL_GLOBAL)) {
+		fprintf(stderr, "Eval failed '%s'\n",
+			Tcl_GetStringResult(interp));
+		continue;
+	    }
 
-	/* Store result in fin->prob_bits[i] */
-	if (TCL_OK != Tcl_GetIntFromObj(interp, pobj,
-					(int *)&fin->prob_bits[i])) {
-	    fprintf(stderr, "Tcl_GetIntFromObj: %s\n",
-		    Tcl_GetStringResult(interp));
-	    Tcl_DecrRefCount(pobj);
-	    continue;
+	    /* Store result in fin->prob_bits[i] */
+	    if (TCL_OK != Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp),
+					    (int *)&fin->prob_bits[i])) {
+		fprintf(stderr, "Tcl_GetIntFromObj: %s\n",
+			Tcl_GetStringResult(interp));
+		continue;
+	    }
+	    rule_cache_add(&fin->prob_cache, RULE_KEY(fin->base_bits[i]),
+			   fin->prob_bits[i]);
 	}
 	if (init_orig_prob)
 	    fin->orig_prob_bits[i] = fin->prob_bits[i];
@@ -1405,32 +1445,37 @@ static int tcl_find_problems(finish_t *fin, Tcl_Interp *interp,
 	/* Optimise - if no problems then do not call solution command */
 	if (!fin->prob_bits[i]) {
 	    fin->solution_bits[i] = 0;
-	    Tcl_DecrRefCount(pobj);
 	    continue;
 	}
 
-	/* Call solution_command */
-	solu_objv[2] = pobj;
-	if (TCL_OK != Tcl_EvalObjv(interp, 3, solu_objv, TCL_EVAL_GLOBAL)) {
-	    fprintf(stderr, "Eval failed '%s'\n", Tcl_GetStringResult(interp));
+	/* Call solution_command, again only for new bit combinations */
+	solu_key[0] = fin->base_bits[i];
+	solu_key[1] = fin->prob_bits[i];
+	if (!rule_cache_find(&fin->solu_cache, (char *)solu_key,
+			     &fin->solution_bits[i])) {
+	    Tcl_SetIntObj(prob_objv[1], fin->base_bits[i]);
+	    pobj = Tcl_NewIntObj(fin->prob_bits[i]);
+	    Tcl_IncrRefCount(pobj);
+	    solu_objv[2] = pobj;
+	    if (TCL_OK != Tcl_EvalObjv(interp, 3, solu_objv,
+				       TCL_EVAL_GLOBAL)) {
+		fprintf(stderr, "Eval failed '%s'\n",
+			Tcl_GetStringResult(interp));
+		Tcl_DecrRefCount(pobj);
+		continue;
+	    }
 	    Tcl_DecrRefCount(pobj);
-	    continue;
-	}
 
-	/* Store result in fin->solution_bits[i] */
-	Tcl_DecrRefCount(pobj);
-	
-	pobj = Tcl_GetObjResult(interp);
-	Tcl_IncrRefCount(pobj);
-	if (TCL_OK != Tcl_GetIntFromObj(interp, pobj,
-					(int *)&fin->solution_bits[i])) {
-	    fprintf(stderr, "Tcl_GetIntFromObj: %s\n",
-		    Tcl_GetStringResult(interp));
-	    Tcl_DecrRefCount(pobj);
-	    continue;
+	    /* Store result in fin->solution_bits[i] */
+	    if (TCL_OK != Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp),
+					    (int *)&fin->solution_bits[i])) {
+		fprintf(stderr, "Tcl_GetIntFromObj: %s\n",
+			Tcl_GetStringResult(interp));
+		continue;
+	    }
+	    rule_cache_add(&fin->solu_cache, (char *)solu_key,
+			   fin->solution_bits[i]);
 	}
-	
-	Tcl_DecrRefCount(pobj);
 
 	if (fin->opts.debug[FIN_DEBUG] > 2)
 	    printf("%d: bits 0x%x, probs 0x%x, soln 0x%x\n",
@@ -1644,6 +1689,9 @@ static int tcl_implement_solutions(finish_t *fin, Tcl_Interp *interp,
 	fin->solu_script = strdup(args.solu);
     }
 
+    if (*args.prob || *args.solu)
+	rule_cache_reset(fin);
+
     SplitList(args.tag_list, &fin->nskip_tags, &fin->skip_tags);
     
     if (fin->nskip_tags) {
@@ -1872,6 +1920,7 @@ unsigned int *finishing_rules(Tcl_Interp *interp,
     int i;
     Tcl_Obj *objv[2];
     unsigned int *probs;
+    Tcl_HashTable *cache;
 
     if (!script)
 	return NULL;
@@ -1880,6 +1929,8 @@ unsigned int *finishing_rules(Tcl_Interp *interp,
     if (NULL == probs)
 	return NULL;
 
+    cache = script == fin->prob_script ? &fin->prob_cache : NULL;
+
     objv[0] = Tcl_NewStringObj(script, -1);
     objv[1] = Tcl_NewIntObj(0);
     Tcl_IncrRefCount(objv[0]);
@@ -1890,11 +1941,14 @@ unsigned int *finishing_rules(Tcl_Interp *interp,
 	    mask_offset + i < fin->length &&
 	    fin->tag_mask[mask_offset+i]) {
 	    probs[i] = 0;
-	} else {
+	} else if (!cache ||
+		   !rule_cache_find(cache, RULE_KEY(classbits[i]), &probs[i])) {
 	    Tcl_SetIntObj(objv[1], classbits[i]);
-	    Tcl_EvalObjv(interp, 2, objv, 0);
-	    Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp),
-			      (int *)&probs[i]);
+	    if (TCL_OK == Tcl_EvalObjv(interp, 2, objv, 0) &&
+		TCL_OK == Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp),
+					    (int *)&probs[i]) &&
+		cache)
+		rule_cache_add(cache, RULE_KEY(classbits[i]), probs[i]);
 	}
     }
 
@@ -1911,6 +1965,7 @@ unsigned int *finishing_rules(Tcl_Interp *interp,
  * bit patterns to produce a series of solution bit patterns.
  */
 unsigned int *finishing_solutions(Tcl_Interp *interp,
+				  finish_t *fin,
 				  char *solu_script,
 				  unsigned int *classbits,
 				  unsigned int *probbits,
@@ -1919,11 +1974,15 @@ unsigned int *finishing_solutions(Tcl_Interp *interp,
     int i;
     Tcl_Obj *objv[3];
     unsigned int *soln;
+    unsigned int key[2];
+    Tcl_HashTable *cache;
 
     soln = (unsigned int *)xmalloc(len * sizeof(*soln));
     if (NULL == soln)
 	return NULL;
 
+    cache = solu_script == fin->solu_script ? &fin->solu_cache : NULL;
+
     objv[0] = Tcl_NewStringObj(solu_script, -1);
     objv[1] = Tcl_NewIntObj(0);
     objv[2] = Tcl_NewIntObj(1);
@@ -1932,10 +1991,17 @@ unsigned int *finishing_solutions(Tcl_Interp *interp,
     Tcl_IncrRefCount(objv[2]);
 
     for (i = 0; i < len; i++) {
+	key[0] = classbits[i];
+	key[1] = probbits[i];
+	if (cache && rule_cache_find(cache, (char *)key, &soln[i]))
+	    continue;
+
 	Tcl_SetIntObj(objv[1], classbits[i]);
 	Tcl_SetIntObj(objv[2], probbits[i]);
 	Tcl_EvalObjv(interp, 3, objv, 0);
-	Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp), (int *)&soln[i]);
+	if (TCL_OK == Tcl_GetIntFromObj(interp, Tcl_GetObjResult(interp),
+					(int *)&soln[i]) && cache)
+	    rule_cache_add(cache, (char *)key, soln[i]);
     }
 
     Tcl_DecrRefCount(objv[0]);
@@ -145,6 +145,8 @@ typedef struct {
     int		      *template_dup;	/* Holds duplicate templates */
     char	      *prob_script;	/* Tcl function to find problems */
     char	      *solu_script;	/* Tcl function to find solutions */
+    Tcl_HashTable      prob_cache;	/* Base bits -> prob_script result */
+    Tcl_HashTable      solu_cache;	/* Base+prob bits -> solu_script */
     int                left_extent;	/* Max left posn in vc, <= 0 */
     int                right_extent;	/* Max right posn in vc, >= len-1 */
     int		      *template_used;	/* How many times we use each temp. */ 
@@ -159,11 +161,11 @@ typedef struct {
     int		       nskip_tags;	/* Number of elements in skip_tags */
     char	      *external_seq;	/* External sequence (eg vector) */
     int		       external_seq_len;/* Length of external_seq */
-    Hash	      *external_seq_h;	/* Hash of external_seq */
+    primer_index_t    *external_seq_h;	/* Primer index of external_seq */
     char	      *external_seq_rev;/* Reverse complement of external_seq*/
     char	      *all_cons;	/* Complete consensus sequence (cat) */
     int	      	       all_cons_len;	/* Length of all_cons */
-    Hash	      *all_cons_h;	/* Hash of all_cons */
+    primer_index_t    *all_cons_h;	/* Primer index of all_cons */
 
     Tcl_Command	       command_token;	/* From Tcl_CreateObjCommand() */
 
@@ -222,7 +224,8 @@ int Finish_Init(Tcl_Interp *interp);
  * finishing_rules
  *
  * Calls the Tcl finishing_rules function on a series of base classification
- * bit patterns to produce a series of problem bit patterns.
+ * bit patterns to produce a series of problem bit patterns. Results are
+ * cached in fin->prob_cache when script is fin->prob_script.
  */
 unsigned int *finishing_rules(Tcl_Interp *interp,
 			      finish_t *fin,
@@ -235,9 +238,11 @@ unsigned int *finishing_rules(Tcl_Interp *interp,
  * finishing_solutions
  *
  * Calls the Tcl tcl_find_solutions function on a series of base and problem
- * bit patterns to produce a series of solution bit patterns.
+ * bit patterns to produce a series of solution bit patterns. Results are
+ * cached in fin->solu_cache when solu_script is fin->solu_script.
  */
 unsigned int *finishing_solutions(Tcl_Interp *interp,
+				  finish_t *fin,
 				  char *solu_script,
 				  unsigned int *classbits,
 				  unsigned int *probbits,
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "finish_hash.h"
 #include "dna_utils.h"
@@ -143,32 +144,23 @@ static double false_priming(int end,
 extern int dna_hash8_lookup[256];
 
 /*
- * Compares a primer sequence 'prim' of length 'lprim' against a hashed
- * sequence stored in Hash. The primer is automatically checked in both
- * directions, but the primer must consist of upper case A,C,G,T characters
- * only.
+ * The body of hash_compare_primer. The description of the best match is
+ * written to best_msg_buf (at least 1024 bytes), or set to "" if none.
  *
- * Arguments:
- *	h		Hashed sequence
- *	prim		Primer sequence (must be uppercase)
- *	lprim		Length of primer sequence
- *	max_match	Maximum score before we reject (due to 2ndary prim)
- *	skip_self	How many matches to skip past (on skip_strand only)
- *	skip_strand	Strand (0=top,1=bot) on which skip_self counts.
- *
- * Returns:
- *	-1	Error
- *	>= 0	Score (high means strong match, low means poor match)
+ * 'seen', if non-NULL, is an array of h->seq1_len elements used to avoid
+ * scoring the same placement of the primer once for every word it shares
+ * with seq1. 'query' and query+1 (one per strand) must not already be
+ * present in 'seen'.
  */
-double hash_compare_primer(Hash *h, char *prim, int lprim,
-			   double max_match, int skip_self, int skip_strand) {
-    int nrw, ncw, word, pw2, pw1, j;
-    /* int maxmis = (1 - minmat) * lprim; */
+static double compare_hashed(Hash *h, int *seen, int query,
+			     char *prim, int lprim,
+			     int skip_self, int skip_strand,
+			     char *best_msg_buf) {
+    int nrw, ncw, word, pw2, pw1, pos, j;
     signed int last_pos = -1;
     int strand;
     char pcopy[FIN_MAXPRIMERLEN];
     double max_pscore = 0;
-    char msg_buf[1024], best_msg_buf[1024];
 
     *best_msg_buf = 0;
 
@@ -183,7 +175,7 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
     nrw = lprim - h->word_length + 1;
     
     /* Loop through both strands */
-    for (strand = 0; strand < 2; strand++) {
+    for (strand = 0; strand < 2; strand++, query++) {
 	int self_count = strand == skip_strand ? skip_self : 0;
 
 	/* Hash primer sequence */
@@ -203,59 +195,42 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 		continue;
 
 	    /* Check each matching word from seq1 for a 'real' match */
-	    for (j=0,pw1=h->last_word[word];j<ncw;j++) {
-#if 0
-		int nmismatch;
-#endif
+	    for (j=0,pw1=h->last_word[word];j<ncw;j++,pw1=h->values1[pw1]) {
 		double pscore;
 		int perfect;
 
-		if (pw1 - pw2 == last_pos) {
-		    pw1 = h->values1[pw1];
+		/*
+		 * Placements overhanging seq1 score zero, and those already
+		 * scored via another word cannot change the result.
+		 */
+		pos = pw1 - pw2;
+		if (pos == last_pos || pos < 0 || pos + lprim >= h->seq1_len)
+		    continue;
+		if (seen && seen[pos] == query)
 		    continue;
-		}
 
 		pscore = false_priming(strand ? 0 : 1,
 				       h->seq1, h->seq1_len, pw1,
 				       h->seq2, h->seq2_len, pw2,
 				       &perfect,
-				       msg_buf);
-
-		if (pw1-pw2 != last_pos) {
-		    if (self_count && perfect) {
-			self_count--;
-			last_pos = pw1 - pw2;
-		    } else {
-			/* Matches elsewhere */
-			if (pscore > max_pscore) {
-			    max_pscore = pscore;
-			    strcpy(best_msg_buf, msg_buf);
-			}
-		    }
-		}
-
-
-#if 0
-		nmismatch = count_mismatches(maxmis,
-					     h->seq1, h->seq1_len, pw1,
-					     h->seq2, h->seq2_len, pw2);
-		if (nmismatch <= maxmis) {
-		    if (fin->opts.debug[FIN_DEBUG_VPWALK] > 1)
-			printf("Match strand=%d pos=%d, last_pos=%d, "
-			       "self_count=%d\n",
-			       strand, pw1-pw2, last_pos, self_count);
-		    if (pw1-pw2 != last_pos) {
-			if (self_count) {
-			    self_count--;
-			} else {
-			    return 1;
-			}
-			last_pos = pw1 - pw2;
+				       NULL);
+
+		if (self_count && perfect) {
+		    self_count--;
+		    last_pos = pos;
+		} else {
+		    /* Matches elsewhere */
+		    if (seen)
+			seen[pos] = query;
+		    if (pscore > max_pscore) {
+			max_pscore = pscore;
+			false_priming(strand ? 0 : 1,
+				      h->seq1, h->seq1_len, pw1,
+				      h->seq2, h->seq2_len, pw2,
+				      &perfect,
+				      best_msg_buf);
 		    }
 		}
-#endif
-
-		pw1 = h->values1[pw1];
 	    }
 	}
 
@@ -263,12 +238,41 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 	complement_seq(pcopy, lprim);
     }
 
+    return max_pscore;
+}
+
+/*
+ * Compares a primer sequence 'prim' of length 'lprim' against a hashed
+ * sequence stored in Hash. The primer is automatically checked in both
+ * directions, but the primer must consist of upper case A,C,G,T characters
+ * only.
+ *
+ * Arguments:
+ *	h		Hashed sequence
+ *	prim		Primer sequence (must be uppercase)
+ *	lprim		Length of primer sequence
+ *	max_match	Maximum score before we reject (due to 2ndary prim)
+ *	skip_self	How many matches to skip past (on skip_strand only)
+ *	skip_strand	Strand (0=top,1=bot) on which skip_self counts.
+ *
+ * Returns:
+ *	-1	Error
+ *	>= 0	Score (high means strong match, low means poor match)
+ */
+double hash_compare_primer(Hash *h, char *prim, int lprim,
+			   double max_match, int skip_self, int skip_strand) {
+    char best_msg_buf[1024];
+    double score;
+
+    score = compare_hashed(h, NULL, 0, prim, lprim, skip_self, skip_strand,
+			   best_msg_buf);
+
 #if 1
-    if (max_pscore >= max_match && *best_msg_buf)
+    if (score >= max_match && *best_msg_buf)
 	printf("%s", best_msg_buf);
 #endif
 
-    return max_pscore;
+    return score;
 }
 
 /*
@@ -367,3 +371,156 @@ double compare_primer(char *seq1, int len1, char *prim, int lprim,
     return ret;
 }
 
+
+/*
+ * ---------------------------------------------------------------------------
+ * Primer indices.
+ *
+ * These hold a hashed sequence which stays fixed for the whole prefinish
+ * run (the complete database consensus and the external sequences), along
+ * with a cache of the scores already computed for each primer. Adjacent
+ * problem regions pick from overlapping windows and so test many of the
+ * same primers; these repeated checks become a single hash table lookup.
+ * ---------------------------------------------------------------------------
+ */
+
+/* A cached primer_index_compare result */
+typedef struct {
+    double score;
+    char *msg;		/* Best match, as printed by compare_hashed */
+} pi_score_t;
+
+/*
+ * The most scores cached per index. Primers are only ever retested from
+ * nearby problem regions, so once this many are held the cache is simply
+ * emptied rather than being allowed to grow with the database.
+ */
+#define PI_MAX_SCORES 50000
+
+/* Frees and removes all cached scores */
+static void primer_index_clear(primer_index_t *pi) {
+    Tcl_HashEntry *hash;
+    Tcl_HashSearch search;
+
+    for (hash = Tcl_FirstHashEntry(&pi->scores, &search);
+	 hash;
+	 hash = Tcl_NextHashEntry(&search)) {
+	pi_score_t *ps = (pi_score_t *)Tcl_GetHashValue(hash);
+	if (ps->msg)
+	    xfree(ps->msg);
+	xfree(ps);
+    }
+    Tcl_DeleteHashTable(&pi->scores);
+    Tcl_InitHashTable(&pi->scores, TCL_STRING_KEYS);
+}
+
+/*
+ * Builds a primer index over seq. The sequence is referenced, not copied,
+ * so it must remain unchanged until primer_index_destroy is called.
+ *
+ * Returns:
+ *	The new index on success
+ *	NULL on failure
+ */
+primer_index_t *primer_index_create(char *seq, int seq_len) {
+    primer_index_t *pi;
+
+    if (NULL == (pi = (primer_index_t *)xmalloc(sizeof(*pi))))
+	return NULL;
+
+    if (init_hash8n(seq_len, FIN_MAXPRIMERLEN,
+		    4 /* word_length */,
+		    0 /* max_matches - unused */,
+		    0 /* min_match - unused */,
+		    1 /* job */,
+		    &pi->h)) {
+	xfree(pi);
+	return NULL;
+    }
+
+    pi->h->seq1 = seq;
+    pi->h->seq1_len = seq_len;
+    if (hash_seqn(pi->h, 1)) {
+	free_hash8n(pi->h);
+	xfree(pi);
+	return NULL;
+    }
+    store_hashn(pi->h);
+
+    if (NULL == (pi->seen = (int *)xcalloc(seq_len, sizeof(int)))) {
+	free_hash8n(pi->h);
+	xfree(pi);
+	return NULL;
+    }
+    pi->query = 0;
+
+    Tcl_InitHashTable(&pi->scores, TCL_STRING_KEYS);
+
+    return pi;
+}
+
+void primer_index_destroy(primer_index_t *pi) {
+    if (!pi)
+	return;
+
+    primer_index_clear(pi);
+    Tcl_DeleteHashTable(&pi->scores);
+
+    free_hash8n(pi->h);
+    xfree(pi->seen);
+    xfree(pi);
+}
+
+/*
+ * As hash_compare_primer, but against a primer index. Results are
+ * remembered so that checking the same primer again (with the same
+ * skip_self and skip_strand) does not search the sequence again.
+ *
+ * Returns:
+ *	-1	Error
+ *	>= 0	Score (high means strong match, low means poor match)
+ */
+double primer_index_compare(primer_index_t *pi, char *prim, int lprim,
+			    double max_match, int skip_self, int skip_strand) {
+    char key[FIN_MAXPRIMERLEN + 50], msg_buf[1024];
+    Tcl_HashEntry *hash;
+    pi_score_t *ps;
+    int is_new;
+
+    if (lprim < 0 || lprim > FIN_MAXPRIMERLEN)
+	return -1;
+
+    sprintf(key, "%d %d %.*s", skip_self, skip_strand, lprim, prim);
+    if (pi->scores.numEntries >= PI_MAX_SCORES &&
+	!Tcl_FindHashEntry(&pi->scores, key))
+	primer_index_clear(pi);
+    hash = Tcl_CreateHashEntry(&pi->scores, key, &is_new);
+    if (!is_new) {
+	ps = (pi_score_t *)Tcl_GetHashValue(hash);
+	if (ps->score >= max_match && ps->msg)
+	    printf("%s", ps->msg);
+	return ps->score;
+    }
+
+    /* Two stamps per query, one for each strand */
+    if (pi->query >= INT_MAX - 2) {
+	memset(pi->seen, 0, pi->h->seq1_len * sizeof(int));
+	pi->query = 0;
+    }
+    pi->query += 2;
+
+    if (NULL == (ps = (pi_score_t *)xmalloc(sizeof(*ps)))) {
+	Tcl_DeleteHashEntry(hash);
+	return -1;
+    }
+    ps->score = compare_hashed(pi->h, pi->seen, pi->query - 1,
+			       prim, lprim, skip_self, skip_strand,
+			       msg_buf);
+    ps->msg = *msg_buf ? strdup(msg_buf) : NULL;
+    Tcl_SetHashValue(hash, ps);
+
+    if (ps->score >= max_match && ps->msg)
+	printf("%s", ps->msg);
+
+    return ps->score;
+}
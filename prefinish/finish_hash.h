@@ -1,15 +1,34 @@
 #ifndef _FINISH_HASH_H_
 #define _FINISH_HASH_H_
 
+#include <tcl.h>
 #include "align_lib.h"
 #include "hash_lib.h"
 
 #define FIN_MAXPRIMERLEN 50
 
+/*
+ * A hashed sequence used for repeated primer checks, with a cache of the
+ * scores of primers already compared against it.
+ */
+typedef struct {
+    Hash	  *h;		/* 4-mer hash of the sequence */
+    int		  *seen;	/* Last query to score each placement */
+    int		   query;	/* Query counter for 'seen' */
+    Tcl_HashTable  scores;	/* Primer -> cached score */
+} primer_index_t;
+
 double hash_compare_primer(Hash *h, char *prim, int lprim,
 			   double minmat, int skip_self, int skip_strand);
 
 double compare_primer(char *seq1, int len1, char *prim, int lprim,
 		      double minmat, int skip_self, int skip_strand);
 
+primer_index_t *primer_index_create(char *seq, int seq_len);
+
+void primer_index_destroy(primer_index_t *pi);
+
+double primer_index_compare(primer_index_t *pi, char *prim, int lprim,
+			    double max_match, int skip_self, int skip_strand);
+
 #endif /* _FINISH_HASH_H_ */
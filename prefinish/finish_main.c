@@ -1037,7 +1037,7 @@ static void add_experiment(Tcl_Interp *interp,
 			    bits, best_exp->r.sequence_length);
 
     /* Recompute solutions */
-    soln = finishing_solutions(interp, fin->solu_script, bits, probs,
+    soln = finishing_solutions(interp, fin, fin->solu_script, bits, probs,
 			       best_exp->r.sequence_length);
 
     for (i = 0; i < len; i++) {
@@ -494,9 +494,9 @@ double secondary_primer_match(finish_t *fin,
 	if (fin->opts.debug[EXPERIMENT_VPWALK] > 1)
 	    printf("Check allcons self=%d strand %d\n",
 		   self_match, self_strand);
-	sc = hash_compare_primer(fin->all_cons_h, primer, primer_len,
-				 fin->opts.pwalk_max_match,
-				 self_match, self_strand);
+	sc = primer_index_compare(fin->all_cons_h, primer, primer_len,
+				  fin->opts.pwalk_max_match,
+				  self_match, self_strand);
     } else if (check_contig > 0) {
 	/* Specific contig */
 	if (check_contig != fin->contig) {
@@ -525,8 +525,8 @@ double secondary_primer_match(finish_t *fin,
 	double vsc;
 	if (fin->opts.debug[EXPERIMENT_VPWALK] > 1)
 	    printf("Check extern self=%d strand %d\n", 0, 0);
-	vsc = hash_compare_primer(fin->external_seq_h, primer, primer_len,
-				  fin->opts.pwalk_max_match, 0, 0);
+	vsc = primer_index_compare(fin->external_seq_h, primer, primer_len,
+				   fin->opts.pwalk_max_match, 0, 0);
 	if (vsc > sc)
 	    sc = vsc;
     }
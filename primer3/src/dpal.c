@@ -723,20 +723,26 @@ _dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
     int *S0, *S1, *S2; 
     int *P0, *P1, *P2;
     int *S;
+    int buf[3 * DPAL_MAX_ALIGN]; /* Saves malloc() for short sequences */
 
     register int i, j;
     register int gap = in->gap;
     register int smax;           /* The optimum score. */
     register int score;          /* Current score. */
     register int a;
+    register const int *sx;      /* The row of ssm for X[i]. */
 
 #ifdef DPAL_PRINT_COVERAGE
     fprintf(stderr, "_dpal_long_nopath_maxgap1_local called\n");
 #endif
 
-    P0 = malloc(sizeof(int)*ylen);
-    P1 = malloc(sizeof(int)*ylen);
-    P2 = malloc(sizeof(int)*ylen);
+    if (ylen <= DPAL_MAX_ALIGN) {
+	P0 = buf; P1 = buf + DPAL_MAX_ALIGN; P2 = buf + 2 * DPAL_MAX_ALIGN;
+    } else {
+	P0 = malloc(sizeof(int)*ylen);
+	P1 = malloc(sizeof(int)*ylen);
+	P2 = malloc(sizeof(int)*ylen);
+    }
 
     S0 = P0; S1 = P1; S2 = P2;
 
@@ -766,13 +772,14 @@ _dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
     }
 
     for(i=2; i < xlen; i++) {
-	score = in->ssm[X[i]][Y[0]];
+	sx = in->ssm[X[i]];
+	score = sx[Y[0]];
 	if (score < 0) score = 0;
 	else if (score > smax) smax = score;
 	S2[0] = score;
 	score = S1[0];
 	if((a=S0[0] + gap) > score) score = a;
-	score += in->ssm[X[i]][Y[1]];
+	score += sx[Y[1]];
 	if(score < 0) score = 0;
 	else if (score > smax) smax = score;
 	S2[1] = score;
@@ -782,7 +789,7 @@ _dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
 	    score +=gap;
 	    if((a=S1[j-1]) >score) score = a;
 
-	    score += in->ssm[X[i]][Y[j]];	
+	    score += sx[Y[j]];
 	    if (score < 0 ) score = 0;
 	    else if (score > smax) smax = score;
 	    S2[j]=score;
@@ -791,7 +798,9 @@ _dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
     }
     out->score = smax;
     out->path_length=0;
-    free(P0); free(P1); free(P2);
+    if (P0 != buf) {
+	free(P0); free(P1); free(P2);
+    }
 } /* _dpal_long_nopath_maxgap1_local */
 
 static void
@@ -804,6 +813,7 @@ _dpal_long_nopath_maxgap1_global_end(X, Y, xlen, ylen, in, out)
     /* The "score matrix" (matrix of best scores). */
     int *S0, *S1, *S2, *S; 
     int *P0, *P1, *P2;
+    int buf[3 * DPAL_MAX_ALIGN]; /* Saves malloc() for short sequences */
 
     register int i, j, k;
     register int gap = in->gap;
@@ -815,9 +825,13 @@ _dpal_long_nopath_maxgap1_global_end(X, Y, xlen, ylen, in, out)
     fprintf(stderr, "_dpal_long_nopath_maxgap1_global_end called\n");
 #endif
 
-    P0 = malloc(sizeof(int)*xlen);
-    P1 = malloc(sizeof(int)*xlen);
-    P2 = malloc(sizeof(int)*xlen);
+    if (xlen <= DPAL_MAX_ALIGN) {
+	P0 = buf; P1 = buf + DPAL_MAX_ALIGN; P2 = buf + 2 * DPAL_MAX_ALIGN;
+    } else {
+	P0 = malloc(sizeof(int)*xlen);
+	P1 = malloc(sizeof(int)*xlen);
+	P2 = malloc(sizeof(int)*xlen);
+    }
 
     S0 = P0; S1 = P1; S2 = P2;
 
@@ -886,7 +900,9 @@ _dpal_long_nopath_maxgap1_global_end(X, Y, xlen, ylen, in, out)
        S = S0; S0 = S1; S1 = S2; S2 = S;
     }
 
-    free(P0); free(P1); free(P2);
+    if (P0 != buf) {
+	free(P0); free(P1); free(P2);
+    }
     out->score = smax;
     out->path_length=0;
 } /* _dpal_long_nopath_maxgap_global_end */
@@ -1010,20 +1026,26 @@ _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
     int *S0, *S1, *S2; 
     int *P0, *P1, *P2;
     int *S;
+    int buf[3 * DPAL_MAX_ALIGN]; /* Saves malloc() for short sequences */
 
     register int i, j;
     register int gap = in->gap;
     register int smax;           /* The optimum score. */
     register int score;          /* Current score. */
     register int a;
+    register const int *sx;      /* The row of ssm for X[i]. */
 
 #ifdef DPAL_PRINT_COVERAGE
     fprintf(stderr, "_dpal_long_nopath_maxgap1_local_end called\n");
 #endif
 
-    P0 = malloc(sizeof(int)*ylen);
-    P1 = malloc(sizeof(int)*ylen);
-    P2 = malloc(sizeof(int)*ylen);
+    if (ylen <= DPAL_MAX_ALIGN) {
+	P0 = buf; P1 = buf + DPAL_MAX_ALIGN; P2 = buf + 2 * DPAL_MAX_ALIGN;
+    } else {
+	P0 = malloc(sizeof(int)*ylen);
+	P1 = malloc(sizeof(int)*ylen);
+	P2 = malloc(sizeof(int)*ylen);
+    }
 
     S0 = P0; S1 = P1; S2 = P2;
 
@@ -1050,12 +1072,13 @@ _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
     }
 
     for(i=2; i < xlen - 1; i++) {
-	score = in->ssm[X[i]][Y[0]];
+	sx = in->ssm[X[i]];
+	score = sx[Y[0]];
 	if (score < 0) score = 0;
 	S2[0] = score;
 	score = S1[0];
 	if((a=S0[0] + gap) > score) score = a;
-	score += in->ssm[X[i]][Y[1]];
+	score += sx[Y[1]];
 	if(score < 0) score = 0;
 	S2[1] = score;
 	for(j=2; j < ylen; j++) {
@@ -1064,7 +1087,7 @@ _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
 	    score +=gap;
 	    if((a=S1[j-1]) >score) score = a;
 
-	    score += in->ssm[X[i]][Y[j]];	
+	    score += sx[Y[j]];
 	    if (score < 0 ) score = 0;
 	    S2[j]=score;
 	}
@@ -1072,13 +1095,14 @@ _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
     }
     /* Calculate scores for last row (i = xlen-1) and find smax */
     i = xlen - 1;
-    score = in->ssm[X[i]][Y[0]];
+    sx = in->ssm[X[i]];
+    score = sx[Y[0]];
     if (score < 0) score = 0;
     else if (score > smax) smax = score;
     S2[0] = score;
     score = S1[0];
     if((a=S0[0] + gap) > score) score = a;
-    score += in->ssm[X[i]][Y[1]];
+    score += sx[Y[1]];
     if(score < 0) score = 0;
     else if (score > smax) smax = score;
     S2[1] = score;
@@ -1087,12 +1111,14 @@ _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
 	if((a=S1[j-2])>score) score = a;
 	score +=gap;
 	if((a=S1[j-1]) >score) score = a;
-	score += in->ssm[X[i]][Y[j]];
+	score += sx[Y[j]];
 	if (score < 0 ) score = 0;
 	else if (score > smax) smax = score;
 	S2[j]=score;
     }
     out->score = smax;
     out->path_length=0;
-    free(P0); free(P1); free(P2);
+    if (P0 != buf) {
+	free(P0); free(P1); free(P2);
+    }
 } /* _dpal_long_nopath_maxgap1_local */
@@ -272,20 +272,20 @@
  * Query - should AAAACTTTT be considered symmetric? If not then
  * it implies all odd length strings are not. (We treat this as symmetric.)
  *
- * Returns 1 if 's' is a self complement.
+ * Returns 1 if the len bases at 's' are a self complement.
  *         0 if not.
  */
-static int is_sym(const char *s) {
-    const char *e = s + strlen(s)-1;
-    int comp[256];
-    comp['A'] = 'T';
-    comp['C'] = 'G';
-    comp['G'] = 'C';
-    comp['T'] = 'A';
+static int is_sym(const char *s, size_t len) {
+    const char *e = s + len - 1;
 
     while (s < e) {
-	if (comp[(const unsigned char)*s] != *e)
-	    return 0;
+	switch (*s) {
+	case 'A': if (*e != 'T') return 0; break;
+	case 'C': if (*e != 'G') return 0; break;
+	case 'G': if (*e != 'C') return 0; break;
+	case 'T': if (*e != 'A') return 0; break;
+	default:  return 0;
+	}
 	s++;
 	e--;
     }
@@ -293,73 +293,22 @@ static int is_sym(const char *s) {
     return 1;
 }
 
-double 
-oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
-     const  char *s;
+/*
+ * Turns the nearest-neighbor sums dh and ds for an oligo of length len
+ * into a melting temperature.
+ */
+static double
+tm_from_sums(dh, ds, len, symmetric, DNA_nM, K_mM, Mg_mM, dNTP_mM)
+     int dh, ds;
+     size_t len;
+     int symmetric;
      double DNA_nM;
      double K_mM;
      double Mg_mM;
      double dNTP_mM;
 {
-    register int dh = 0, ds = 0;
-    register char c;
     double delta_H, delta_S, Ct, salt;
-    size_t len = strlen(s);
-    int symmetric;
-
-    /* const char *orig=s; */
-
-#ifndef SANTALUCIA_1998
-    ds += 108;
-#else
-    /* SantaLucia method */
-
-    /* Terminal AT/GC scoring */
-    if (*s == 'A' || *s == 'T') {
-	ds += S_TERM_AT;
-	dh += H_TERM_AT;
-    } else if (*s == 'G' || *s == 'C') {
-	ds += S_TERM_GC;
-	dh += H_TERM_GC;
-    } else {
-	ds += S_TERM_N;
-	dh += H_TERM_N;
-    }
-
-    if (s[len-1] == 'A' || s[len-1] == 'T') {
-	ds += S_TERM_AT;
-	dh += H_TERM_AT;
-    } else if (s[len-1] == 'G' || s[len-1] == 'C') {
-	ds += S_TERM_GC;
-	dh += H_TERM_GC;
-    } else {
-	/* guess, pick avg */
-	ds += S_TERM_N;
-	dh += H_TERM_N;
-    }
 
-    /* Symmetry adjustment */
-    if ((symmetric = is_sym(s))) {
-	ds += S_SYM;
-	dh += H_SYM;
-    }
-#endif /* SANTALUCIA_1998 */
-
-    /* Use a finite-state machine (DFA) to calucluate dh and ds for s. */
-    c = *s; s++;
-    if (c == 'A') goto A_STATE;
-    else if (c == 'G') goto G_STATE;
-    else if (c == 'T') goto T_STATE;
-    else if (c == 'C') goto C_STATE;
-    else if (c == 'N') goto N_STATE;
-    else goto ERROR;
-    STATE(A);
-    STATE(T);
-    STATE(G);
-    STATE(C);
-    STATE(N);
-
- DONE:  /* dh and ds are now computed for the given sequence. */
     delta_H = dh * -100.0;  /* 
 			     * Nearest-neighbor thermodynamic values for dh
 			     * are given in 100 cal/mol of interaction.
@@ -418,6 +367,75 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
      */
     return delta_H / (delta_S + 1.987 * Ct) - 273.15;
 #endif
+}
+
+double 
+oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
+     const  char *s;
+     double DNA_nM;
+     double K_mM;
+     double Mg_mM;
+     double dNTP_mM;
+{
+    register int dh = 0, ds = 0;
+    register char c;
+    size_t len = strlen(s);
+    int symmetric = 0;
+
+    /* const char *orig=s; */
+
+#ifndef SANTALUCIA_1998
+    ds += 108;
+#else
+    /* SantaLucia method */
+
+    /* Terminal AT/GC scoring */
+    if (*s == 'A' || *s == 'T') {
+	ds += S_TERM_AT;
+	dh += H_TERM_AT;
+    } else if (*s == 'G' || *s == 'C') {
+	ds += S_TERM_GC;
+	dh += H_TERM_GC;
+    } else {
+	ds += S_TERM_N;
+	dh += H_TERM_N;
+    }
+
+    if (s[len-1] == 'A' || s[len-1] == 'T') {
+	ds += S_TERM_AT;
+	dh += H_TERM_AT;
+    } else if (s[len-1] == 'G' || s[len-1] == 'C') {
+	ds += S_TERM_GC;
+	dh += H_TERM_GC;
+    } else {
+	/* guess, pick avg */
+	ds += S_TERM_N;
+	dh += H_TERM_N;
+    }
+
+    /* Symmetry adjustment */
+    if ((symmetric = is_sym(s, len))) {
+	ds += S_SYM;
+	dh += H_SYM;
+    }
+#endif /* SANTALUCIA_1998 */
+
+    /* Use a finite-state machine (DFA) to calucluate dh and ds for s. */
+    c = *s; s++;
+    if (c == 'A') goto A_STATE;
+    else if (c == 'G') goto G_STATE;
+    else if (c == 'T') goto T_STATE;
+    else if (c == 'C') goto C_STATE;
+    else if (c == 'N') goto N_STATE;
+    else goto ERROR;
+    STATE(A);
+    STATE(T);
+    STATE(G);
+    STATE(C);
+    STATE(N);
+
+ DONE:  /* dh and ds are now computed for the given sequence. */
+    return tm_from_sums(dh, ds, len, symmetric, DNA_nM, K_mM, Mg_mM, dNTP_mM);
 
  ERROR:  /* 
 	  * length of s was less than 2 or there was an illegal character in
@@ -425,6 +443,113 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
 	  */
     return OLIGOTM_ERROR;
 }
+
+/* Index of a base in the nearest-neighbor tables below, or -1. */
+static int nn_code(c)
+    char c;
+{
+    switch (c) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    case 'N': return 4;
+    }
+    return -1;
+}
+
+#define NN_ROW(V,X) \
+    {CATID5(V,_,X,_,A), CATID5(V,_,X,_,C), CATID5(V,_,X,_,G), \
+     CATID5(V,_,X,_,T), CATID5(V,_,X,_,N)}
+
+static const int nn_dh[5][5] = {
+    NN_ROW(H,A), NN_ROW(H,C), NN_ROW(H,G), NN_ROW(H,T), NN_ROW(H,N)
+};
+static const int nn_ds[5][5] = {
+    NN_ROW(S,A), NN_ROW(S,C), NN_ROW(S,G), NN_ROW(S,T), NN_ROW(S,N)
+};
+
+void
+oligotm_prefix(seq, dh, ds, bad)
+    const char *seq;
+    int *dh, *ds, *bad;
+{
+    int i, c, last = -1;
+
+    dh[0] = ds[0] = bad[0] = 0;
+    for (i = 0; seq[i]; i++) {
+	c = nn_code(seq[i]);
+	bad[i+1] = bad[i] + (c < 0);
+	if (i > 0) {
+	    dh[i] = dh[i-1];
+	    ds[i] = ds[i-1];
+	    if (c >= 0 && last >= 0) {
+		dh[i] += nn_dh[last][c];
+		ds[i] += nn_ds[last][c];
+	    }
+	}
+	last = c;
+    }
+    if (i > 0) {
+	dh[i] = dh[i-1];
+	ds[i] = ds[i-1];
+    }
+}
+
+double
+oligotm_range(seq, start, len, dh, ds, bad, DNA_nM, K_mM, Mg_mM, dNTP_mM)
+    const char *seq;
+    int start, len;
+    const int *dh, *ds, *bad;
+    double DNA_nM;
+    double K_mM;
+    double Mg_mM;
+    double dNTP_mM;
+{
+    const char *s = &seq[start];
+    int h, d, symmetric = 0;
+
+    if (len < 1 || bad[start + len] != bad[start])
+	return OLIGOTM_ERROR;
+
+    h = dh[start + len - 1] - dh[start];
+    d = ds[start + len - 1] - ds[start];
+
+#ifndef SANTALUCIA_1998
+    d += 108;
+#else
+    if (*s == 'A' || *s == 'T') {
+	d += S_TERM_AT;
+	h += H_TERM_AT;
+    } else if (*s == 'G' || *s == 'C') {
+	d += S_TERM_GC;
+	h += H_TERM_GC;
+    } else {
+	d += S_TERM_N;
+	h += H_TERM_N;
+    }
+
+    if (s[len-1] == 'A' || s[len-1] == 'T') {
+	d += S_TERM_AT;
+	h += H_TERM_AT;
+    } else if (s[len-1] == 'G' || s[len-1] == 'C') {
+	d += S_TERM_GC;
+	h += H_TERM_GC;
+    } else {
+	d += S_TERM_N;
+	h += H_TERM_N;
+    }
+
+    if ((symmetric = is_sym(s, len))) {
+	d += S_SYM;
+	h += H_SYM;
+    }
+#endif /* SANTALUCIA_1998 */
+
+    return tm_from_sums(h, d, (size_t)len, symmetric,
+			DNA_nM, K_mM, Mg_mM, dNTP_mM);
+}
+
 #undef DO_PAIR
 
 #define DO_PAIR(LAST,THIS)          \
@@ -43,6 +43,19 @@ double oligotm(const  char *seq, /* The sequence. */
 	       double dNTP_conc  /* dNTP concentration (millimolar). */
 	       );
 
+/* Fill dh[i] and ds[i] with the nearest-neighbor sums for the first i+1
+   bases of seq, and bad[i] with the number of bases oligotm() rejects among
+   the first i, for i = 0 .. strlen(seq).  Each array needs strlen(seq)+1
+   elements. */
+void oligotm_prefix(const char *seq, int *dh, int *ds, int *bad);
+
+/* Return oligotm() of the len bases of seq starting at start, using the sums
+   from oligotm_prefix() instead of rescanning the bases. */
+double oligotm_range(const char *seq, int start, int len,
+		     const int *dh, const int *ds, const int *bad,
+		     double dna_conc, double salt_conc,
+		     double Mg_conc, double dNTP_conc);
+
 /* Return the delta G of disruption of oligo using the nearest neighbor model;
    seq should be relatively short, given the characteristics of the nearest
    neighbor model. */
@@ -226,6 +226,29 @@ typedef struct primer_state {
     int n_f, n_r, n_m;		/* Number of elements in f, r and mid */
     int f_len, r_len, mid_len;	/* and their lengths */
     pair_array_t best_pairs;	/* The best primer pairs */
+    pair_array_t pairs;		/* Pairs found by choose_pair() */
+
+    /*
+     * Running totals over trimmed_seq, so that oligo_param() can get the
+     * GC content and Tm of a candidate without rescanning its bases.
+     */
+    int seq_alloc;		/* Allocated length of the arrays below */
+    int *gc_sum, *n_sum;	/* G+C and N counts before each position */
+    int *tm_dh, *tm_ds, *tm_bad;/* See oligotm_prefix() */
+
+    /*
+     * Mispriming alignments shared by left or right primers with a common
+     * 3' end; see mispriming_score() in primer3_lib.c.
+     */
+    int mis_type;		/* oligo_type of the cached rows, or -1 */
+    int mis_end;		/* Their 3' end position in trimmed_seq */
+    int mis_nlib;		/* Library entries set up, or -1 */
+    int mis_nalloc, mis_size;	/* Allocated entries and row cells */
+    int *mis_ylen;		/* Length of each library entry */
+    int *mis_off;		/* Offset of each entry's rows in mis_row */
+    int *mis_done;		/* Rows computed so far for each entry */
+    int *mis_row;		/* Last two alignment rows for each entry */
+    short *mis_best;		/* Score for each primer length, per entry */
 
     primer_error err;		/* Error handling */
 } primer_state;
@@ -70,7 +70,8 @@ static void   create_and_print_file(const seq_args *, int, const primer_rec[],
 				    const char *, primer_state *);
 static int    data_control(primer_state *, primer_args *, seq_args *);
 static int    find_stop_codon(const char *, int, int);
-static void   gc_and_n_content(const int, const int, const char *, primer_rec *);
+static void   gc_and_n_content(const primer_state *, const int, const int,
+			       primer_rec *);
 static int    make_internal_oligos_list(const primer_args *,
 					seq_args *,
 					primer_state *);
@@ -99,12 +100,17 @@ static void   substr(const char *, int, int, char *);
 static double p_obj_fn(const primer_args *, primer_rec *, int );
 static void   oligo_compl(primer_rec *, const primer_args *, seq_args *,
 			  oligo_type, primer_state *);
+static short  mispriming_score(primer_state *, const seq_lib *, int,
+			       oligo_type, int, const char *, int);
 static void   oligo_mispriming(primer_rec *, const primer_args *, seq_args *,
 			       oligo_type, primer_state *);
 static int    pair_repeat_sim(primer_pair *, const primer_args *);
 static char   *strstr_nocase(primer_error *, char *, char *);
 static void free_repeat_sim_score(primer_state *);
 static void   set_dpal_args(dpal_args *);
+static void   seq_sums(primer_state *, const seq_args *);
+static double oligo_seqtm(const primer_state *, const char *, const char *,
+			  int, double, double, double, double);
 
 #define PR_UNDEFINED_INT_OPT INT_MIN
 #define PR_UNDEFINED_DBL_OPT DBL_MIN
@@ -689,11 +695,25 @@ primer3_create(void)
     state->best_pairs.storage_size = 0;
     state->best_pairs.pairs = NULL;
     state->best_pairs.num_pairs = 0;
+    state->pairs.storage_size = state->pairs.num_pairs = 0;
+    state->pairs.pairs = NULL;
+
+    state->seq_alloc = 0;
+    state->gc_sum = state->n_sum = NULL;
+    state->tm_dh = state->tm_ds = state->tm_bad = NULL;
 
     state->err.system_errno = 0;
     state->err.local_errno = PR_ERR_NONE;
     state->err.error_msg = NULL;
 
+    state->mis_type = -1;
+    state->mis_end = -1;
+    state->mis_nlib = -1;
+    state->mis_nalloc = state->mis_size = 0;
+    state->mis_ylen = state->mis_off = state->mis_done = NULL;
+    state->mis_row = NULL;
+    state->mis_best = NULL;
+
     /* Allocate and initialise alignment buffers */
     set_dpal_args(&state->local_args);
     state->local_args.flag = DPAL_LOCAL;
@@ -730,6 +750,28 @@ primer3_destroy(primer_state *state)
 	free(state->mid);
     if (state->best_pairs.storage_size != 0 && state->best_pairs.pairs)
 	free(state->best_pairs.pairs);
+    if (state->pairs.storage_size != 0 && state->pairs.pairs)
+	free(state->pairs.pairs);
+    if (state->gc_sum)
+	free(state->gc_sum);
+    if (state->n_sum)
+	free(state->n_sum);
+    if (state->tm_dh)
+	free(state->tm_dh);
+    if (state->tm_ds)
+	free(state->tm_ds);
+    if (state->tm_bad)
+	free(state->tm_bad);
+    if (state->mis_ylen)
+	free(state->mis_ylen);
+    if (state->mis_off)
+	free(state->mis_off);
+    if (state->mis_done)
+	free(state->mis_done);
+    if (state->mis_best)
+	free(state->mis_best);
+    if (state->mis_row)
+	free(state->mis_row);
 
     free(state);
 }
@@ -745,7 +787,7 @@ primer3_choose(primer_state *state,
 {
     int i;    /* Loop index. */
     int int_num; /* Product size range counter. */
-    pair_array_t p;
+    pair_array_t *p = &state->pairs;
 
     PR_ASSERT(NULL != pa);
     PR_ASSERT(NULL != sa);
@@ -761,15 +803,20 @@ primer3_choose(primer_state *state,
     if (setjmp(state->err.jmpenv) != 0)
 	return 1;
 
-    /* Reset best_pairs array */
+    /*
+     * Reset the lists from any previous call.  Their storage is kept, so
+     * that picking primers for many sequences does not reallocate it.
+     */
     state->best_pairs.num_pairs = 0;
-    if (state->best_pairs.storage_size != 0) {
-	state->best_pairs.storage_size = 0;
-	if (state->best_pairs.pairs)
-	    free(state->best_pairs.pairs);
-    }
+    free_repeat_sim_score(state);
+    state->n_f = state->n_r = state->n_m = 0;
+
+    /* The sequence and library may have changed since the last call */
+    state->mis_type = -1;
+    state->mis_nlib = -1;
 
     if (data_control(state, pa, sa) !=0 ) return 1;
+    seq_sums(state, sa);
 
     if (NULL == state->f) {
 	state->f = pr_jump_malloc(&state->err, sizeof(*state->f) * INITIAL_LIST_LEN);
@@ -799,24 +846,24 @@ primer3_choose(primer_state *state,
     if(pa->primer_task == pick_hyb_probe_only)
       qsort(&state->mid[0], state->n_m, sizeof(*state->mid), primer_rec_comp);
 
-    p.storage_size = p.num_pairs = 0;
+    p->num_pairs = 0;
     if (pa->primer_task == pick_pcr_primers 
 	|| pa->primer_task == pick_pcr_primers_and_hyb_probe){
 
       /* Look for pa->num_return best primer pairs. */
       for(int_num=0; int_num < pa->num_intervals; int_num++) {
-	  if(choose_pair(pa, sa, int_num, &p, state)!=0)
+	  if(choose_pair(pa, sa, int_num, p, state)!=0)
 	      continue;
 
 	for (i = 0;
-	     i < p.num_pairs &&
+	     i < p->num_pairs &&
 		 state->best_pairs.num_pairs < pa->num_return;
 	     i++)
-	  if (!oligo_pair_seen(&p.pairs[i], &state->best_pairs))
-	    add_pair(state, &p.pairs[i], &state->best_pairs);
+	  if (!oligo_pair_seen(&p->pairs[i], &state->best_pairs))
+	    add_pair(state, &p->pairs[i], &state->best_pairs);
 
 	if (pa->num_return == state->best_pairs.num_pairs) break;
-	p.num_pairs = 0;
+	p->num_pairs = 0;
       }
     }
 
@@ -835,7 +882,6 @@ primer3_choose(primer_state *state,
       }
     }
 
-    if (0 != p.storage_size) free(p.pairs);
     return 0;
 }
 
@@ -1228,7 +1274,7 @@ oligo_param(pa, h, l, state, sa, stats)
     PR_ASSERT(k >= 0);
     PR_ASSERT(k < TRIMMED_SEQ_LEN(sa));
 
-    gc_and_n_content(j, k-j+1, sa->trimmed_seq, h);
+    gc_and_n_content(state, j, k-j+1, h);
 
     if (((OT_LEFT == l || OT_RIGHT == l) && 
 	 h->num_ns > pa->num_ns_accepted) || 
@@ -1359,13 +1405,12 @@ oligo_param(pa, h, l, state, sa, stats)
 
     substr(seq,j,k-j+1,s1);
     if(OT_LEFT == l || OT_RIGHT == l) 
-      h->temp = seqtm(s1, pa->dna_conc, pa->salt_conc, 
-		      pa->mg_conc, pa->dntp_conc,
-		      MAX_NN_TM_LENGTH);
+      h->temp = oligo_seqtm(state, seq, s1, j, pa->dna_conc, pa->salt_conc,
+			    pa->mg_conc, pa->dntp_conc);
     else
-      h->temp = seqtm(s1, pa->io_dna_conc, pa->io_salt_conc,
-		      pa->io_mg_conc, pa->io_dntp_conc,
-		      MAX_NN_TM_LENGTH);
+      h->temp = oligo_seqtm(state, seq, s1, j, pa->io_dna_conc,
+			    pa->io_salt_conc, pa->io_mg_conc,
+			    pa->io_dntp_conc);
     if (((l == OT_LEFT || l == OT_RIGHT) && h->temp < pa->min_tm)
 	|| (l==OT_INTL && h->temp<pa->io_min_tm)) {
 	h->ok = OV_TM_LOW;
@@ -1414,6 +1459,11 @@ oligo_param(pa, h, l, state, sa, stats)
 	|| ((OT_RIGHT == l || OT_LEFT == l) && pa->primer_weights.repeat_sim)
 	|| (OT_INTL == l && pa->io_weights.repeat_sim)) {
       oligo_mispriming(h, pa, sa, l, state);
+      /* The list makers drop rejected oligos, so their scores go here. */
+      if (OV_UNINITIALIZED != h->ok && !must_use && h->repeat_sim.score) {
+	free(h->repeat_sim.score);
+	h->repeat_sim.score = NULL;
+      }
     }
     if (OV_UNINITIALIZED == h->ok) h->ok = OV_OK;
 }
@@ -1479,34 +1529,81 @@ check_sequence_quality(pa, h, l, sa, j, k, r_min_q, r_min_q_end)
   *r_min_q_end = min_q_end;
 }
 
-/* 
- * Set h->gc_content to the GC % of the 'len' bases starting at 'start' in
- * 'sequence' (excluding 'N's).  Set h->num_ns to the number of 'N's in that
- * subsequence.
+/*
+ * Set the GC content and number of Ns of h, which covers len bases of
+ * trimmed_seq from start, from the running totals made by seq_sums().
  */
 static void
-gc_and_n_content(start, len, sequence, h)
+gc_and_n_content(state, start, len, h)
+    const primer_state *state;
     const int start, len;
-    const char *sequence;
     primer_rec *h;
 {
-    const char* p = &sequence[start];
-    const char* stop = p + len;
-    int num_gc = 0, num_gcat = 0, num_n = 0;
-    while (p < stop) {
-	if ('N' == *p) 
-	    num_n++;
-	else {
-	    num_gcat++;
-	    if ('C' == *p || 'G' == *p) num_gc++;
-	}
-	p++;
-    }
+    int num_gc = state->gc_sum[start+len] - state->gc_sum[start];
+    int num_n = state->n_sum[start+len] - state->n_sum[start];
+    int num_gcat = len - num_n;
+
     h->num_ns = num_n;
     if (0 == num_gcat) h->gc_content= 0.0;
     else h->gc_content = 100.0 * ((double)num_gc)/num_gcat;
 }
 
+/*
+ * Build the running totals over sa->trimmed_seq that gc_and_n_content() and
+ * oligo_seqtm() use, reusing the arrays from earlier sequences when they
+ * are long enough.
+ */
+static void
+seq_sums(state, sa)
+    primer_state *state;
+    const seq_args *sa;
+{
+    const char *p = sa->trimmed_seq;
+    int i, n = strlen(p);
+
+    if (n + 1 > state->seq_alloc) {
+	state->gc_sum = pr_jump_realloc(&state->err, state->gc_sum,
+					(n + 1) * sizeof(int));
+	state->n_sum = pr_jump_realloc(&state->err, state->n_sum,
+				       (n + 1) * sizeof(int));
+	state->tm_dh = pr_jump_realloc(&state->err, state->tm_dh,
+				       (n + 1) * sizeof(int));
+	state->tm_ds = pr_jump_realloc(&state->err, state->tm_ds,
+				       (n + 1) * sizeof(int));
+	state->tm_bad = pr_jump_realloc(&state->err, state->tm_bad,
+					(n + 1) * sizeof(int));
+	state->seq_alloc = n + 1;
+    }
+
+    state->gc_sum[0] = state->n_sum[0] = 0;
+    for (i = 0; i < n; i++) {
+	state->gc_sum[i+1] = state->gc_sum[i] + ('C' == p[i] || 'G' == p[i]);
+	state->n_sum[i+1] = state->n_sum[i] + ('N' == p[i]);
+    }
+    oligotm_prefix(p, state->tm_dh, state->tm_ds, state->tm_bad);
+}
+
+/*
+ * Equivalent to seqtm(s1, ...) for s1, the bases of seq (the trimmed
+ * sequence) from start, but looks up the nearest-neighbor sums.
+ */
+static double
+oligo_seqtm(state, seq, s1, start, dna_conc, salt_conc, mg_conc, dntp_conc)
+    const primer_state *state;
+    const char *seq, *s1;
+    int start;
+    double dna_conc, salt_conc, mg_conc, dntp_conc;
+{
+    int len = strlen(s1);
+
+    if (len > MAX_NN_TM_LENGTH)
+	return seqtm(s1, dna_conc, salt_conc, mg_conc, dntp_conc,
+		     MAX_NN_TM_LENGTH);
+    return oligotm_range(seq, start, len,
+			 state->tm_dh, state->tm_ds, state->tm_bad,
+			 dna_conc, salt_conc, mg_conc, dntp_conc);
+}
+
 static int
 oligo_overlaps_interval(start, len, intervals, num_intervals)
     const int start, len;
@@ -2764,6 +2861,136 @@ oligo_compl(h, ha, sa, l, state)
     }
 }
 
+/*
+ * Left and right primer mispriming scores are DPAL_LOCAL_END alignments,
+ * which are anchored at the 3' end of the primer.  Candidate primers sharing
+ * a 3' end differ only in the bases added at their 5' end, so running the
+ * recurrence of _dpal_long_nopath_maxgap1_local_end() backwards from the 3'
+ * end gives the score for every primer length in turn, one row per base.
+ * make_lists() offers all lengths for a 3' end together, shortest first, so
+ * the last two rows for each library entry are kept in state and extended
+ * on demand; shorter lengths are answered from mis_best.  Each entry is
+ * extended only when it is scored, so an early OV_LIB_SIM return costs no
+ * more than before.  Scores are identical to those of align().
+ */
+#define MIS_FLOOR (INT_MIN / 4)
+
+static short
+mispriming_score(state, lib, i, l, end, x, len)
+    primer_state *state;
+    const seq_lib *lib;
+    int i;
+    oligo_type l;
+    int end;
+    const char *x;
+    int len;
+{
+    const dpal_args *a = &state->local_end_args_ambig;
+    const unsigned char *y;
+    const int *m;
+    int *cur, *prev;
+    short *best;
+    int j, r, ylen, n, score, rmax;
+
+    y = (const unsigned char *)
+	((OT_LEFT == l) ? lib->seqs[i] : lib->rev_compl_seqs[i]);
+
+    /*
+     * dpal treats oligos shorter than 3 bases specially.  read_seq_lib()
+     * leaves only bases and ambiguity codes in the library, so once the
+     * oligo is checked too no score below is INT_MIN.
+     */
+    if (len < 3 || (int)strspn(x, "ACGTNBDHVRYKMSW") < len)
+	return align(state, x, (const char *)y, a);
+
+    if (state->mis_nlib != lib->seq_num) {
+	state->mis_type = -1;
+	state->mis_nlib = -1;
+	if (lib->seq_num > state->mis_nalloc) {
+	    state->mis_nalloc = lib->seq_num;
+	    state->mis_ylen = pr_jump_realloc(&state->err, state->mis_ylen,
+				    state->mis_nalloc * sizeof(int));
+	    state->mis_off = pr_jump_realloc(&state->err, state->mis_off,
+				    state->mis_nalloc * sizeof(int));
+	    state->mis_done = pr_jump_realloc(&state->err, state->mis_done,
+				    state->mis_nalloc * sizeof(int));
+	    state->mis_best = pr_jump_realloc(&state->err, state->mis_best,
+				    state->mis_nalloc * MAX_PRIMER_LENGTH
+				    * sizeof(short));
+	}
+	for (n = j = 0; j < lib->seq_num; j++) {
+	    state->mis_ylen[j] = strlen(lib->seqs[j]);
+	    state->mis_off[j] = n;
+	    n += 2 * state->mis_ylen[j];
+	}
+	if (n > state->mis_size) {
+	    state->mis_size = n;
+	    state->mis_row = pr_jump_realloc(&state->err, state->mis_row,
+				    state->mis_size * sizeof(int));
+	}
+	state->mis_nlib = lib->seq_num;
+    }
+
+    if (state->mis_type != (int)l || state->mis_end != end) {
+	memset(state->mis_done, 0, lib->seq_num * sizeof(int));
+	state->mis_type = l;
+	state->mis_end = end;
+    }
+
+    ylen = state->mis_ylen[i];
+    if (0 == ylen)
+	return align(state, x, (const char *)y, a);
+
+    best = state->mis_best + i * MAX_PRIMER_LENGTH;
+    for (r = state->mis_done[i]; r < len; r++) {
+	/*
+	 * Row r aligns base x[len-1-r].  A path may only start in row 0, and
+	 * runs towards lower positions in y; MIS_FLOOR stands in for minus
+	 * infinity and is far enough below 0 that no path recovers from it,
+	 * nor underflows in MAX_PRIMER_LENGTH rows.
+	 */
+	cur  = state->mis_row + state->mis_off[i] + (r & 1) * ylen;
+	prev = state->mis_row + state->mis_off[i] + ((r & 1) ^ 1) * ylen;
+	m = a->ssm[(unsigned char)x[len - 1 - r]];
+	rmax = 0;
+	if (0 == r) {
+	    for (j = 0; j < ylen; j++) {
+		cur[j] = score = m[y[j]];
+		if (score > rmax) rmax = score;
+	    }
+	} else {
+	    /* cur[] still holds row r-2; there is none before row 2 */
+	    if (1 == r)
+		for (j = 0; j < ylen; j++)
+		    cur[j] = MIS_FLOOR;
+	    for (j = 0; j < ylen - 2; j++) {
+		score = cur[j+1];
+		if (prev[j+2] > score) score = prev[j+2];
+		score += a->gap;
+		if (prev[j+1] > score) score = prev[j+1];
+		cur[j] = (score += m[y[j]]);
+		if (score > rmax) rmax = score;
+	    }
+	    if (j == ylen - 2) {
+		score = cur[j+1] + a->gap;
+		if (prev[j+1] > score) score = prev[j+1];
+		cur[j] = (score += m[y[j]]);
+		if (score > rmax) rmax = score;
+		j++;
+	    }
+	    cur[j] = MIS_FLOOR;
+	}
+	if (r > 0 && best[r-1] > rmax)
+	    rmax = best[r-1];
+	PR_ASSERT(rmax <= SHRT_MAX);
+	best[r] = rmax;
+    }
+    if (len > state->mis_done[i])
+	state->mis_done[i] = len;
+
+    return best[len-1];
+}
+
 static void 
 oligo_mispriming(h, ha, sa, l, state)
    primer_rec *h;
@@ -2804,14 +3031,15 @@ oligo_mispriming(h, ha, sa, l, state)
     for(i = 0; i < lib->seq_num; i++){
       if (OT_LEFT == l)
 	  w = lib->weight[i] *
-	      align(state, s1, lib->seqs[i], &state->local_end_args_ambig);
+	      mispriming_score(state, lib, i, l, h->start + h->length - 1,
+			       s1, h->length);
       else if (OT_INTL == l)
 	  w = lib->weight[i] *
 	      align(state, s1, lib->seqs[i], &state->local_args_ambig);
       else
 	  w = lib->weight[i] *
-	      align(state, s, lib->rev_compl_seqs[i],
-		    &state->local_end_args_ambig);
+	      mispriming_score(state, lib, i, l, h->start - h->length + 1,
+			       s, h->length);
 
       h->repeat_sim.score[i] = w;
       if(w > max){
@@ -3,8 +3,10 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "seqInfo.h"
+#include "fastq.h"
 #include "consen.h"
 #include "xalloc.h"
 
@@ -26,6 +28,8 @@ typedef struct {
     int use_conf;	/* which method to use, 1 => confidence */
     int test_mode;	/* 1 => do not write out changes */
     int min_len;	/* minimum length */
+    int fastq;		/* 1 => files are FASTQ, not experiment files */
+    FILE *log;		/* verbose output; stderr when FASTQ goes to stdout */
 
     /* For N-count clipping */
     int start;		/* Start point for scanning left/right. */
@@ -40,33 +44,71 @@ typedef struct {
 } params;
 
 
+/*
+ * The window scans below work on cumulative confidence totals, so that the
+ * total of any window is a single subtraction rather than a loop over the
+ * window. psum[i] is the total of conf[0] to conf[i-1]. Positions beyond the
+ * end of the sequence count as zero confidence and psum[-1] is also valid,
+ * so windows hanging off either end of very short reads are still safe.
+ */
+#define WIN_TOTAL(psum, i, w) ((psum)[(i)+(w)] - (psum)[i])
+
+/*
+ * Allocates and fills in the cumulative totals for conf. Free the result with
+ * free_conf_psum().
+ */
+static int *conf_psum(int1 *conf, int len, int window_len) {
+    int *psum, i, total;
+
+    psum = (int *)xmalloc((len + window_len + 2) * sizeof(*psum));
+    if (!psum)
+	return NULL;
+
+    psum[0] = 0;
+    psum++;
+    for (total = i = 0; i < len; i++) {
+	psum[i] = total;
+	total += conf[i];
+    }
+    for (; i <= len + window_len; i++)
+	psum[i] = total;
+
+    return psum;
+}
+
+static void free_conf_psum(int *psum) {
+    xfree(psum-1);
+}
+
 /*
  * Scans through a quality buffer finding the highest average block of length
  * window_len.
  */
-static int find_highest_conf(params p, int1 *conf, int len) {
-    int i, total, best_total, best_pos;
+static int find_highest_conf(params p, int *psum, int len) {
+    int i, total, best_total, best_pos, nwin = len - p.window_len + 1;
 
     if (p.window_len >= len)
 	return len/2;
 
-    for (total = i = 0; i < p.window_len; i++) {
-	total += conf[i];
-    }
-    best_total = total;
-    best_pos = 0;
-
-    for (i = 0; i < len - p.window_len; i++) {
-	total = total - conf[i] + conf[i+p.window_len];
-	if (total > best_total) {
-	    best_total = total;
-	    best_pos = i;
-	}
+    /*
+     * Find the best total first and then the first window that has it,
+     * rather than tracking both at once; the first loop has no dependency
+     * between iterations and so vectorises.
+     */
+    best_total = WIN_TOTAL(psum, 0, p.window_len);
+    for (i = 1; i < nwin; i++) {
+	total = WIN_TOTAL(psum, i, p.window_len);
+	best_total = total > best_total ? total : best_total;
     }
+    for (i = 0; WIN_TOTAL(psum, i, p.window_len) != best_total; i++)
+	;
+
+    /* The first window is reported as starting at 1, as it always was */
+    best_pos = i ? i-1 : 0;
 
     if (p.verbose)
-	printf("    Start position = %d (total %d)\n",
-	       best_pos+1, best_total);
+	fprintf(p.log, "    Start position = %d (total %d)\n",
+		best_pos+1, best_total);
 
     return best_pos+1;
 }
@@ -80,30 +122,25 @@ static int find_highest_conf(params p, int1 *conf, int len) {
  * Having found this window, the procedure repeats with successively smaller
  * windows until the exact base is identified.
  */
-int scan_left(params p, int1 *conf, int start_pos) {
-    int i, total, lclip;
+int scan_left(params p, int *psum, int start_pos) {
+    int i, lclip;
     int lowest_total;
     int win_len = p.window_len;
 
     do {
 	lowest_total = p.qual_val * win_len;
 
-	total = 0;
-	for (i = start_pos; i < start_pos + win_len; i++)
-	    total += conf[i];
-
 	i = start_pos;
 	do {
 	    i--;
-	    total = total + conf[i] - conf[i+win_len];
-	} while (i > 0 && total >= lowest_total);
+	} while (i > 0 && WIN_TOTAL(psum, i, win_len) >= lowest_total);
 
 	start_pos = i+2;
     } while (--win_len > 0);
 
     lclip = i;
     if (p.verbose)
-	printf("    left clip = %d\n", lclip);
+	fprintf(p.log, "    left clip = %d\n", lclip);
 
     return lclip;
 }
@@ -117,89 +154,71 @@ int scan_left(params p, int1 *conf, int start_pos) {
  * Having found this window, the procedure repeats with successively smaller
  * windows until the exact base is identified.
  */
-int scan_right(params p, int1 *conf, int start_pos, int len) {
-    int i, total, rclip;
+int scan_right(params p, int *psum, int start_pos, int len) {
+    int i, rclip;
     int lowest_total;
     int win_len = p.window_len;
 
     do {
 	lowest_total = p.qual_val * win_len;
 
-	total = 0;
-	for (i = start_pos; i < start_pos + win_len; i++)
-	    total += conf[i];
-
 	i = start_pos;
 	do {
-	    total = total - conf[i] + conf[i+win_len];
 	    i++;
-	} while (i <= (len - win_len - 1) && total >= lowest_total);
+	} while (i <= (len - win_len - 1) &&
+		 WIN_TOTAL(psum, i, win_len) >= lowest_total);
 
 	start_pos = i-1;
     } while (--win_len > 0);
 
     rclip = i == len ? len + 1 : i;
     if (p.verbose)
-	printf("    right clip = %d\n", rclip);
+	fprintf(p.log, "    right clip = %d\n", rclip);
 
     return rclip;
 }
 
 
 /*
- * Quality clips file 'file', updating the QL and QR records in the process.
+ * Computes the left and right clip points for a sequence of length len,
+ * using the confidence values in conf when p.use_conf is set and conf is
+ * non-NULL, and the N-count method otherwise.
  *
  * Returns 0 for success.
- *        -1 for failure.
+ *        -1 if the clipped sequence is shorter than p.min_len.
  */
-static int qclip(char *file, params p) {
-    SeqInfo *si = NULL;
-    int start_pos, right_pos, left_pos;
-    FILE *fp;
-
-    if (p.verbose)
-	printf("Clipping file %s\n", file);
+static int clip_points(params p, char *seq, int1 *conf, int len,
+		       int *left, int *right) {
+    int start_pos, right_pos, left_pos, *psum;
 
-    /* Read the sequence and confidence */
-    if (NULL == (si = read_sequence_details(file, 0))) {
-	fprintf(stderr, "Failed to read file '%s'\n", file);
-	return -1;
-    }
-
-    if (p.use_conf) {
+    if (p.use_conf && conf) {
 	int i;
-	int1 *conf;
 
-	conf = xmalloc(si->length * sizeof(*conf));
-	if (SeqInfo_conf(si, conf, si->length) == -1) {
-	    if (p.verbose)
-		puts("    Could not load confidence values - using sequence");
-	    p.use_conf = 0;
-	}
-
-	for (i = 0; i < si->length; i++)
+	for (i = 0; i < len; i++)
 	    if (conf[i] != 0)
 		break;
-	if (i == si->length) {
+	if (i == len) {
 	    if (p.verbose)
-		puts("    Confidence values are all zero - using sequence");
+		fputs("    Confidence values are all zero - using sequence\n",
+		      p.log);
 	    p.use_conf = 0;
 	}
-
-	if (p.use_conf) {
-	    /* Identify the best location to start from */
-	    start_pos = find_highest_conf(p, conf, si->length);
-
-	    /* Scan left, and scan right */
-	    left_pos = scan_left(p, conf, start_pos)+1;
-	    right_pos = scan_right(p, conf, start_pos, si->length)+1;
-	}
-	xfree(conf);
+    } else {
+	p.use_conf = 0;
     }
 
-    if (!p.use_conf) {
-	char *seq = exp_get_entry(si->e, EFLT_SQ);
+    if (p.use_conf && NULL == (psum = conf_psum(conf, len, p.window_len)))
+	p.use_conf = 0;
+
+    if (p.use_conf) {
+	/* Identify the best location to start from */
+	start_pos = find_highest_conf(p, psum, len);
 
+	/* Scan left, and scan right */
+	left_pos = scan_left(p, psum, start_pos)+1;
+	right_pos = scan_right(p, psum, start_pos, len)+1;
+	free_conf_psum(psum);
+    } else {
 	left_pos = start_of_good(seq, p.start, p.lwin1, p.lcnt1,
 				 p.lwin2, p.lcnt2) - 1;
 	right_pos = end_of_good(seq, p.start, p.rwin1, p.rcnt1,
@@ -213,9 +232,55 @@ static int qclip(char *file, params p) {
     if (left_pos >= right_pos)
 	left_pos = right_pos-1;
 
+    *left = left_pos;
+    *right = right_pos;
+
     if (right_pos - left_pos < p.min_len) {
 	fprintf(stderr, "Sequence too short (length=%d)\n",
 		right_pos - left_pos);
+	return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Quality clips file 'file', updating the QL and QR records in the process.
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+static int qclip(char *file, params p) {
+    SeqInfo *si = NULL;
+    int right_pos, left_pos, ret;
+    int1 *conf = NULL;
+    FILE *fp;
+
+    if (p.verbose)
+	printf("Clipping file %s\n", file);
+
+    /* Read the sequence and confidence */
+    if (NULL == (si = read_sequence_details(file, 0))) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
+    }
+
+    if (p.use_conf) {
+	conf = xmalloc(si->length * sizeof(*conf));
+	if (SeqInfo_conf(si, conf, si->length) == -1) {
+	    if (p.verbose)
+		puts("    Could not load confidence values - using sequence");
+	    xfree(conf);
+	    conf = NULL;
+	}
+    }
+
+    ret = clip_points(p, exp_get_entry(si->e, EFLT_SQ), conf, si->length,
+		      &left_pos, &right_pos);
+    if (conf)
+	xfree(conf);
+
+    if (ret) {
 	freeSeqInfo(si);
 	return -1;
     }
@@ -238,11 +303,92 @@ static int qclip(char *file, params p) {
     return 0;
 }
 
+/*
+ * Quality clips every read in FASTQ file 'file' ("-" for stdin), writing
+ * them to stdout with the clip points added as QL and QR tags. Reads that
+ * end up too short are reported and written out unclipped.
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+static int qclip_fastq(char *file, params p) {
+    fastq_entry *e;
+    FILE *fp;
+    int1 *conf = NULL;
+    int conf_len = 0, right_pos, left_pos, ret = 0, r, i;
+
+    if (strcmp(file, "-") == 0) {
+	fp = stdin;
+    } else if (NULL == (fp = fopen(file, "r"))) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
+    }
+
+    if (NULL == (e = fastq_entry_create())) {
+	if (fp != stdin)
+	    fclose(fp);
+	return -1;
+    }
+
+    while ((r = fastq_next(fp, e)) == 0) {
+	if (p.verbose)
+	    fprintf(stderr, "Clipping read %s\n", e->name);
+
+	if (e->seq_len > conf_len) {
+	    int1 *tmp = xrealloc(conf, e->seq_len * sizeof(*conf));
+	    if (NULL == tmp) {
+		fprintf(stderr, "Out of memory clipping read '%s'\n", e->name);
+		ret = -1;
+		break;
+	    }
+	    conf = tmp;
+	    conf_len = e->seq_len;
+	}
+	for (i = 0; i < e->seq_len; i++)
+	    conf[i] = e->qual[i] - 33;
+
+	if (clip_points(p, e->seq, conf, e->seq_len, &left_pos, &right_pos)) {
+	    fprintf(stderr, "    in read '%s'\n", e->name);
+	    ret = -1;
+	    /* Still written, unclipped, to keep one record per input record */
+	    if (!p.test_mode && fastq_write(stdout, e))
+		break;
+	    continue;
+	}
+
+	if (!p.test_mode) {
+	    fastq_set_tag(e, "QL", left_pos);
+	    fastq_set_tag(e, "QR", right_pos);
+	    if (fastq_write(stdout, e)) {
+		ret = -1;
+		break;
+	    }
+	} else {
+	    printf("%-30s QL %4d            QR %4d\n",
+		   e->name, left_pos, right_pos);
+	}
+    }
+    if (r < 0) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	ret = -1;
+    }
+
+    if (conf)
+	xfree(conf);
+    fastq_entry_destroy(e);
+    if (fp != stdin)
+	fclose(fp);
+
+    return ret;
+}
+
 static void usage(void) {
     fprintf(stderr,
 	"Usage for using confidence codes (default mode):\n"
 	"       qclip [-c] [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
 	"                  [-w window_len(30)] [-q average_quality (10)] file ...\n\n"
+	"Usage for FASTQ input (\"-\" for stdin), writing FASTQ with QL/QR tags to stdout:\n"
+	"       qclip -F   [options as above] file ...\n\n"
 	"Usage for using sequence only:\n"
 	"       qclip -n   [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
 	"                  [-s start_offset(70)]\n"
@@ -274,8 +420,9 @@ int main(int argc, char **argv) {
     p.qual_val = 10;
     p.window_len = 30;
     p.test_mode = 0;
+    p.fastq = 0;
 
-    while ((c = getopt(argc, argv, "q:w:vtncm:M:R:r:L:l:s:x:")) != -1) {
+    while ((c = getopt(argc, argv, "q:w:vtncFm:M:R:r:L:l:s:x:")) != -1) {
 	switch (c) {
 	    /* Both methods */
 	case 'v':
@@ -306,6 +453,10 @@ int main(int argc, char **argv) {
 	    p.use_conf = 1;
 	    break;
 
+	case 'F':
+	    p.fastq = 1;
+	    break;
+
 	    /* New method */
 	case 'q':	    
 	    p.qual_val = atoi(optarg);
@@ -344,12 +495,15 @@ int main(int argc, char **argv) {
     if (optind == argc)
 	usage();
 
+    /* FASTQ output owns stdout, so chatter goes to stderr instead */
+    p.log = p.fastq ? stderr : stdout;
+
     for (i = optind; i < argc; i++) {
 	int ret_val;
 
-	ret_val = qclip(argv[i], p);
+	ret_val = p.fastq ? qclip_fastq(argv[i], p) : qclip(argv[i], p);
 	if (p.verbose)
-	    printf("    qclip() returned %d\n", ret_val);
+	    fprintf(p.log, "    qclip() returned %d\n", ret_val);
 
 	ret |= ret_val;
     }
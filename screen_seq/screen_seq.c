@@ -17,6 +17,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include "misc.h" 
 #include "dna_utils.h"
@@ -27,7 +28,7 @@
 #define NORMAL_MODE 0
 #define TEST_ONLY 1
 
-#define MAX_READ 4096 /* the reading */
+#define MAX_READ 4096 /* initial size of the reading arrays */
 #define MAX_VECTOR_D 100000 /* the vector sequence */
 #define MIN_VECTOR 4096 /* the vector sequence */
 #define MAX_READS 10000
@@ -283,59 +284,6 @@ void set_hash8_lookup(void) {
 
 }
 
-int init_hash8 ( int seq1_len, int seq2_len,
-	        int **hash_values1, int **last_word,
-	        int **word_count, int **hash_values2,
-	        int **diag, int **line ) {
-    int size_hash, word_length;
-
-    word_length = 8;
-
-    set_hash8_lookup ();
-
-    size_hash = 65536;
-
-
-    if ( NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*last_word = (int *) xmalloc ( sizeof(int)*size_hash ))) {
-	return -2;
-    }
-
-    if ( ! (*word_count = (int *) xmalloc ( sizeof(int)*size_hash ))) {
-	return -2;
-    }
-
-
-    if ( ! (*hash_values2 = (int *) xmalloc ( sizeof(int)*(seq2_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*line = (int *) xmalloc ( sizeof(int)*(seq2_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*diag = (int *) xmalloc ( sizeof(int)*(seq2_len + seq1_len) ))) {
-	return -2;
-    }
-
-    return 0;
-}
-
-void free_hash8 ( int *hash_values1, int *last_word,
-	        int *word_count, int *hash_values2,
-	        int *diag) {
-
-    if ( hash_values1 ) xfree ( hash_values1 );
-    if ( hash_values2 ) xfree ( hash_values2 );
-    if ( word_count )   xfree ( word_count );
-    if ( last_word )    xfree ( last_word );
-    if ( diag )         xfree ( diag );
-
-}
-
 int hash_word8 ( char *seq, int *start_base, int seq_len,
 	      unsigned short *uword) {
 
@@ -433,137 +381,213 @@ int hash_seq8 ( char *seq, int *hash_values, int seq_len) {
     return 0;
 }
 
-int do_hash_con (   int seq1_len, int seq2_len,
-	        int *hash_values1, int *last_word,
-	        int *word_count, int *hash_values2,
-		int *diag, int *line,
-	        char *seq1, char *seq2, int new_seq1, 
-	        int min_match, int half_window, int *x, int *y, int *score ) {
-
-    int nrw, word, pw1, pw2, i, ncw, j, match_length, word_length = 8;
-    int size_hash = 65536;
-    int diag_pos;
-    int top_score, min_line, max_line, line_pos, i1, i2, j1, j2, k;
-    int top_score_pos, new_score, xx, yy;
-    double n_score;
-
-    /* seq2 is the reading which changes each entry, but seq1 is
-       the vector which may be the same for consecutive
-       entries, so we use new_seq1 to tell if we need to hash seq1
-    */
+/*
+ * All the sequences to screen against, concatenated with a '-' between
+ * each (so that no 8-mer spans two of them) and hashed once as a single
+ * sequence. Each reading is then compared against every screening
+ * sequence in a single pass over its words, rather than once per
+ * screening sequence.
+ */
+typedef struct screen_index_ {
+    char  *seq;
+    int    length;
+    int   *hash_values;	/* as left by store_hash */
+    int   *last_word;
+    int   *word_count;
+    int   *start;	/* start[i] is the offset of sequence i in seq */
+    char **name;	/* name[i] is the file sequence i came from */
+    int    number;
+} Screen_index;
+
+void free_screen_index ( Screen_index *si ) {
+    if ( si->seq )         xfree ( si->seq );
+    if ( si->hash_values ) xfree ( si->hash_values );
+    if ( si->last_word )   xfree ( si->last_word );
+    if ( si->word_count )  xfree ( si->word_count );
+    if ( si->start )       xfree ( si->start );
+    if ( si->name )        xfree ( si->name );
+}
 
-	
-    *score = 0;
-    if ( seq1_len < min_match ) return -4; 
-    if ( seq2_len < min_match ) return -4; 
+int init_screen_index ( Screen_index *si, int num_vfiles,
+		        char *vector_seq, int max_vector, int tmode ) {
 
+    int vfile_num, vector_length, ret, alloced;
+    char *vfile_name;
+    FILE *vf;
 
-    if ( new_seq1 ) {
+    memset ( si, 0, sizeof(*si) );
+    alloced = max_vector;
+    if ( NULL == (si->seq = (char *) xmalloc ( alloced + 1 ))) return -2;
+    if ( NULL == (si->start = (int *) xmalloc ( sizeof(int)*(num_vfiles+1) )))
+	return -2;
+    if ( NULL == (si->name = (char **) xmalloc ( sizeof(char *)*num_vfiles )))
+	return -2;
 
-	if ( hash_seq8 ( seq1, hash_values1, seq1_len )  != 0 ) {
-	    return -1;
-	}
+    for ( vfile_num = 0; (vfile_num < num_vfiles) && 
+	 (vfile_name=vfile_names[vfile_num]); vfile_num++ ) {
 
-	(void) store_hash ( hash_values1, seq1_len, last_word, word_count,
-			    word_length, size_hash);
+      if ( tmode ) {
+	printf(">>>>>>>>>>>>>>>>>>>>>>>>>>> %s\n", vfile_name);
+      }
+
+      if ( !(vf = fopen(vfile_name, "r"))) {
+	fprintf(stderr, "Error: could not open sequence file %s\n", vfile_name);
+	continue;
+      }
+      ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
+      fclose(vf);
+      if ( ret ) {
+	fprintf(stderr, "Error: could not read vector file %s\n", vfile_name);
+	continue;
+      }
+
+      if ( si->length + vector_length + 1 > alloced ) {
+	char *tmp;
+	alloced = 2 * (si->length + vector_length + 1);
+	if ( NULL == (tmp = (char *) xrealloc ( si->seq, alloced + 1 )))
+	  return -2;
+	si->seq = tmp;
+      }
+
+      si->start[si->number] = si->length;
+      si->name[si->number] = vfile_name;
+      si->number++;
+      memcpy ( &si->seq[si->length], vector_seq, vector_length );
+      si->length += vector_length;
+      si->seq[si->length++] = '-';
     }
+    si->start[si->number] = si->length;
+    si->seq[si->length] = '\0';
+
+    if ( si->number == 0 ) return -1;
+
+    if ( NULL == (si->hash_values = (int *) xmalloc ( sizeof(int)*si->length )))
+	return -2;
+    if ( NULL == (si->last_word = (int *) xmalloc ( sizeof(int)*65536 )))
+	return -2;
+    if ( NULL == (si->word_count = (int *) xmalloc ( sizeof(int)*65536 )))
+	return -2;
+
+    if ( hash_seq8 ( si->seq, si->hash_values, si->length ) != 0 ) {
+	fprintf(stderr, "Error: could not hash sequences to screen against\n");
+	return -1;
+    }
+    (void) store_hash ( si->hash_values, si->length, si->last_word,
+		        si->word_count, 8, 65536 );
+
+    return 0;
+}
+
+/* Returns the number of the screening sequence containing offset pos */
+int screen_index_seq ( Screen_index *si, int pos ) {
+    int l = 0, r = si->number - 1, m;
+
+    while ( l < r ) {
+	m = (l + r + 1) / 2;
+	if ( si->start[m] <= pos )
+	    l = m;
+	else
+	    r = m - 1;
+    }
+    return l;
+}
+
+int do_hash_con ( Screen_index *si, int seq2_len,
+	        int *hash_values2, int *diag, int diag_len, int *diag_base,
+	        char *seq2, int min_match,
+	        int *x, int *y, int *score, int *seq_num ) {
+
+    /* Finds the longest exact match, of at least min_match, between seq2
+       (the reading) and any of the screening sequences. x is relative to
+       the start of screening sequence seq_num.
+
+       diag[] has an element for every diagonal of the combined screening
+       sequence against a reading, so rather than clearing it for every
+       reading we store positions relative to *diag_base and advance that
+       past anything this reading can write. Anything left over from
+       previous readings is then below the current base. diag holds
+       diag_len elements, at least seq1_len + seq2_len.
+    */
+
+    int nrw, word, pw1, pw2, ncw, j, match_length, word_length = 8;
+    int seq1_len = si->length;
+    int diag_pos, base, s, end;
+
+    *score = 0;
+    if ( seq2_len < min_match ) return -4; 
 
     if ( hash_seq8 ( seq2, hash_values2, seq2_len )  != 0 ) {
 	return -1;
     }
 
-    j = seq1_len + seq2_len;
-    for (i=0;i<j;i++) diag[i] = -word_length;
+    if ( *diag_base > INT_MAX - 2*(seq2_len + 1) ) {
+	for (j=0;j<diag_len;j++) diag[j] = 0;
+	*diag_base = 1;
+    }
+    base = *diag_base;
+    *diag_base += seq2_len + 1;
 
     nrw = seq2_len - word_length + 1;
 
 /* 	loop for all (nrw) complete words in hash_values2 */
 
-
     for (pw2=0;pw2<nrw;pw2++) {
 
  	word = hash_values2[pw2];
 
 	if ( -1 != word ) {
 
-	    if ( 0 != (ncw = word_count[word]) ) {
+	    if ( 0 != (ncw = si->word_count[word]) ) {
 
-		for (j=0,pw1=last_word[word];j<ncw;j++) {
+		for (j=0,pw1=si->last_word[word];j<ncw;j++) {
 
 		    diag_pos = seq1_len - pw1 + pw2 - 1;
 
-		    if ( diag[diag_pos] < pw2 ) {
-
-			if ((match_length = match_len ( 
-						  seq1, pw1, seq1_len,
-						  seq2, pw2, seq2_len))
-			    >= min_match ) {
-
-			  *score = match_length;
-			  *x = pw1+1;
-			  *y = pw2+1;
-			  return 1;
+		    if ( diag[diag_pos] < base + pw2 ) {
+
+			s = screen_index_seq ( si, pw1 );
+			end = si->start[s+1] - 1;
+			match_length = match_len ( si->seq, pw1, end,
+						   seq2, pw2, seq2_len);
+			if ( match_length > *score ) {
+			    *score = match_length;
+			    *seq_num = s;
+			    *x = pw1 - si->start[s] + 1;
+			    *y = pw2 + 1;
 			}
-			diag[diag_pos] = pw2 + match_length;
+			diag[diag_pos] = base + pw2 + match_length;
 		    }
-		    pw1 = hash_values1[pw1];
+		    pw1 = si->hash_values[pw1];
 		}
 	    }
 	}
     }
 
-    if ( *score < min_match ) return 0;
-
-    /* NONE OF THIS USED */
-
-
-    /* check out this region by adding up the matches
-       in all the loca hits to see how much of the
-       reading they cover */
-
-    top_score_pos = 0; /* to keep marks compiler happy */
-    if ( top_score_pos < seq1_len ) {
-	yy = seq1_len - top_score_pos - 1;
-	xx = 0;
-    }
-    else {
-	xx = top_score_pos - seq1_len + 1;
-	yy = 0;
-    }
-
-    top_score = *score;
-
-    min_line = yy;
-    max_line = MIN(seq1_len-yy,seq2_len-xx) - (word_length-1);
+    return *score >= min_match ? 1 : 0;
+}
 
-    for ( i=0;i<max_line;i++) line[i] = 0;
-    i1 = MAX(0,xx-half_window);
-    i2 = MIN(i1+max_line+half_window,seq2_len-word_length);
+/*
+ * Makes the reading work arrays big enough for a reading of read_len
+ * bases. diag is reallocated cleared, so diag_base starts again.
+ * Returns 0 for success, -1 for failure (leaving the old arrays intact).
+ */
+static int grow_read_arrays ( int read_len, int seq1_len, int *max_read,
+			      int **hash_values2, int **diag, int *diag_base ) {
+    int *hv, *dg;
 
-    j1 = top_score_pos-half_window;
-    j2 = top_score_pos+half_window;
+    if ( read_len <= *max_read ) return 0;
 
-    for (i=i1;i<i2;i++) {
-	word = hash_values2[i];
-	if ( -1 != word ) {
-	    if ( 0 != (ncw = word_count[word]) ) {
-		pw1 = last_word[word];
-		for (j=0;j<ncw;j++) {
-		    k = i - pw1 + seq1_len - 1;
-		    if((k>j1)&&(k<j2)) {
-			line_pos = pw1 - min_line;
-
-			if ( (line_pos > 0) && (line_pos < max_line) ) line[line_pos]=1;
-		    }
-		    pw1 = hash_values1[pw1];
-		}
-	    }
-	}
-    }
-    for (i=0,new_score=0;i<max_line;i++) new_score += line[i];
-    n_score = 100.0 * (double)new_score/(double)(max_line-1);
-    *score = (int) (n_score + 0.5);
-    return 1;
+    if ( NULL == (hv = (int *) xrealloc ( *hash_values2,
+					  sizeof(int)*read_len )))
+	return -1;
+    *hash_values2 = hv;
+    if ( NULL == (dg = (int *) xcalloc ( seq1_len + read_len, sizeof(int) )))
+	return -1;
+    xfree ( *diag );
+    *diag = dg;
+    *diag_base = 1;
+    *max_read = read_len;
+    return 0;
 }
 
 int do_it_con ( char *vector_seq, int max_vector,
@@ -575,31 +599,21 @@ int do_it_con ( char *vector_seq, int max_vector,
     char *seq, *expt_file_name;
 
     Exp_info *e;
-    int ql,qr,seq_length,i;
+    int ql,qr,seq_length;
 
 /* for this algorithm */
 
-    int *hash_values1, *hash_values2, *last_word, *word_count;
-    int *diag, *line;
-    int vector_length, x, y, ret, eret;
-    char *vfile_name;
-    int num_files, file_num, num_vfiles, vfile_num;
-    FILE *vf;
+    Screen_index si;
+    int *hash_values2, *diag, diag_base, max_read = MAX_READ;
+    int x, y, ret, eret;
+    int num_files, file_num, num_vfiles;
     int sl, sr; /* sequencing vector left and right */
-    int new_vector = 0;
-    int score, score_f, score_r;
-    int lg, rg, xf, xr, yf, yr;
-    int match_found, half_window;
-    int size_hash = 65536;
+    int score_f, score_r, seq_f = 0, seq_r = 0;
+    int lg, rg, xf = 0, xr = 0, yf = 0, yr = 0;
+    int failed;
 
-    half_window = MAX(1,window_size/2);
     if ( min_match < 8 ) min_match = 8;
 
-    if ( init_hash8 ( max_vector, MAX_READ,
-		     &hash_values1, &last_word, &word_count,
-		     &hash_values2, &diag, &line ))
-	return -1;
-
     if ( mode_i ) {
 	if (( num_files = get_filenames ( fp_i )) < 1 )
 	    return -1;
@@ -616,218 +630,172 @@ int do_it_con ( char *vector_seq, int max_vector,
 	num_vfiles = 1;
     }
 
-    /* for each vector sequence */
-
-    for ( vfile_num = 0; (vfile_num < num_vfiles) && 
-	 (vfile_name=vfile_names[vfile_num]); vfile_num++ ) {
-
-      if ( tmode ) {
-	printf(">>>>>>>>>>>>>>>>>>>>>>>>>>> %s\n", vfile_names[vfile_num]);
-      }
-
-      if ( !(vf = fopen(vfile_names[vfile_num], "r"))) {
-	fprintf(stderr, "Error: could not open sequence file %s\n", vfile_name);
-	continue;
-      }
-      ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
-      fclose(vf);
-      if ( ret ) {
-	fprintf(stderr, "Error: could not read vector file %s\n", vfile_name);
-	continue;
-      }
+    /* hash all of the sequences to screen against once */
 
-      if ( hash_seq8 ( vector_seq, hash_values1, vector_length ) != 0 ) {
-	fprintf(stderr, "Error: could not hash sequence file %s\n", vfile_name);
-	continue;
-      }
-      (void) store_hash ( hash_values1, vector_length, last_word, word_count,
-			   word_length, size_hash );
+    set_hash8_lookup ();
+    if ( init_screen_index ( &si, num_vfiles, vector_seq, max_vector, tmode )) {
+	free_screen_index ( &si );
+	return -1;
+    }
 
-      /* for all the readings that are left */
+    if ( NULL == (hash_values2 = (int *) xmalloc ( sizeof(int)*MAX_READ ))) {
+	free_screen_index ( &si );
+	return -1;
+    }
+    if ( NULL == (diag = (int *) xcalloc ( si.length + MAX_READ, sizeof(int) ))) {
+	xfree ( hash_values2 );
+	free_screen_index ( &si );
+	return -1;
+    }
+    diag_base = 1;
 
-      for ( file_num = 0; file_num < num_files; file_num++ ) {
+    /* and then screen each reading against all of them */
 
-	if ( expt_file_name=file_names[file_num]) {
+    for ( file_num = 0; file_num < num_files; file_num++ ) {
 
+	if ( !(expt_file_name=file_names[file_num]) ) continue;
 
-	  if ( tmode ) {
+	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", expt_file_name );
-	  }
+	}
 
-	  e = exp_read_info ( expt_file_name );
-	  if ( e == NULL ) {
+	e = exp_read_info ( expt_file_name );
+	if ( e == NULL ) {
 	    eret =  vep_error ( fp_f, expt_file_name, 1 );
+	    continue;
+	}
+	if ( exp_Nentries ( e, EFLT_SQ ) < 1 ) {
+	    eret =  vep_error ( fp_f, expt_file_name, 2 );
 	    exp_destroy_info ( e );
-	    file_names[file_num] = NULL;
 	    continue;
-	  }
-	  else {
-	    if ( exp_Nentries ( e, EFLT_SQ ) < 1 ) {
-	      eret =  vep_error ( fp_f, expt_file_name, 2 );
-	      exp_destroy_info ( e );
-	      file_names[file_num] = NULL;
-	      continue;
-	    }
-	    else {
+	}
+	else {
 
-	      char *expline;
+	    char *expline;
 
-	      seq = exp_get_entry ( e, EFLT_SQ );
-	      seq_length = strlen ( seq );
-	      ql = 0;
-	      qr = seq_length + 1;
+	    seq = exp_get_entry ( e, EFLT_SQ );
+	    seq_length = strlen ( seq );
+	    ql = 0;
+	    qr = seq_length + 1;
 
-	      if ( exp_Nentries ( e, EFLT_QL )) {
+	    if ( exp_Nentries ( e, EFLT_QL )) {
 		expline = exp_get_entry ( e, EFLT_QL );
 		ql = atoi ( expline );
-	      }
-	      if ( exp_Nentries ( e, EFLT_QR )) {
+	    }
+	    if ( exp_Nentries ( e, EFLT_QR )) {
 		expline = exp_get_entry ( e, EFLT_QR );
 		qr = atoi ( expline );
-	      }
+	    }
 
-	      sl = 0;
-	      sr = seq_length + 1;
-	      if ( exp_Nentries ( e, EFLT_SL )) {
+	    sl = 0;
+	    sr = seq_length + 1;
+	    if ( exp_Nentries ( e, EFLT_SL )) {
 		expline = exp_get_entry ( e, EFLT_SL );
 		sl = atoi ( expline );
-	      }
-	      if ( exp_Nentries ( e, EFLT_SR )) {
+	    }
+	    if ( exp_Nentries ( e, EFLT_SR )) {
 		expline = exp_get_entry ( e, EFLT_SR );
 		sr = atoi ( expline );
-	      }
-
-	      /* we have to search both strands so we call do_hash
-		 with the read in its original sense, then its
-		 complement.
-	      */
-
-	      match_found = 0;
-	      score_f = score_r = 0;
-	      lg = MAX ( ql, sl ) - 1;
-	      lg = MAX ( lg, 0 );
-	      rg = MIN ( qr, sr ) - 1;
-	      rg = MIN ( rg, seq_length-1 );
-	      /* 		printf("lg %d rg %d\n",lg,rg); */
-
-	      if ( rg - lg + 1 < min_match ) {
+	    }
+
+	    lg = MAX ( ql, sl ) - 1;
+	    lg = MAX ( lg, 0 );
+	    rg = MIN ( qr, sr ) - 1;
+	    rg = MIN ( rg, seq_length-1 );
+
+	    if ( rg - lg + 1 < min_match ) {
 		eret =  vep_error ( fp_f, expt_file_name, 3 );
 		exp_destroy_info ( e );
-		file_names[file_num] = NULL;
 		continue;
-	      }
-	      ret = do_hash_con ( vector_length, rg-lg+1,
-				 hash_values1, last_word,
-				 word_count, hash_values2, diag, line,
-				 vector_seq, &seq[lg], new_vector,
-				 min_match, half_window,
-				 &x, &y, &score);
-	      if ( ret < 0 ) {
+	    }
+
+	    /* readings longer than any so far need bigger work arrays */
+
+	    if ( grow_read_arrays ( rg-lg+1, si.length, &max_read,
+				    &hash_values2, &diag, &diag_base )) {
+		eret =  vep_error ( fp_f, expt_file_name, 5 );
+		exp_destroy_info ( e );
+		continue;
+	    }
+
+	    /* we have to search both strands so we call do_hash_con
+	       with the read in its original sense, then its
+	       complement, and keep whichever match is longest.
+	    */
+
+	    score_f = score_r = 0;
+	    ret = do_hash_con ( &si, rg-lg+1, hash_values2, diag,
+				si.length + max_read, &diag_base,
+			        &seq[lg], min_match, &x, &y, &score_f, &seq_f );
+	    if ( ret < 0 ) {
+		eret =  vep_error ( fp_f, expt_file_name, 5 );
+		exp_destroy_info ( e );
+		continue;
+	    }
+	    if ( ret ) {
+		xf = x;
+		yf = y + lg;
+	    }
+
+	    complement_seq ( &seq[lg], rg-lg+1);
+	    ret = do_hash_con ( &si, rg-lg+1, hash_values2, diag,
+				si.length + max_read, &diag_base,
+			        &seq[lg], min_match, &x, &y, &score_r, &seq_r );
+	    complement_seq ( &seq[lg], rg-lg+1);
+	    if ( ret < 0 ) {
 		eret =  vep_error ( fp_f, expt_file_name, 5 );
 		exp_destroy_info ( e );
-		file_names[file_num] = NULL;
 		continue;
-	      }
-
-	      if ( ret ) {
-		if ( score >= percent_cut ) {
-		  xf = x;
-		  yf = y + lg;
-		  score_f = score;
-		  match_found = 1;
-		  /* printf("forward score %d at %d %d\n",score_f,xf,yf); */
-		  if ( !tmode ) {
+	    }
+	    if ( ret ) {
+		xr = x;
+		yr = rg - lg - y + lg - score_r + 3;
+	    }
+	    if ( score_r > score_f ) {
+		xf = xr;
+		yf = yr;
+		score_f = score_r;
+		seq_f = seq_r;
+	    }
+
+	    failed = 0;
+	    if ( score_f >= min_match && score_f >= percent_cut ) {
+		if ( !tmode ) {
 		    char mess[2048]; /* twice vfile_name ! */
 
 		    if (exp_put_str(e, EFLT_PS, "contaminated", 
-					  strlen("contaminated"))) {
-		      eret =  vep_error ( fp_f, expt_file_name, 4 );
-		      exp_destroy_info ( e );
-		      file_names[file_num] = NULL;
-		      continue;
+				    strlen("contaminated"))) {
+			eret =  vep_error ( fp_f, expt_file_name, 4 );
+			exp_destroy_info ( e );
+			continue;
 		    }
 		    sprintf(mess, "CONT = %d..%d\n%d %d %s",
-			    yf,yf+score-1,xf,score,vfile_name);
+			    yf,yf+score_f-1,xf,score_f,si.name[seq_f]);
 		    exp_put_str(e, EFLT_TG, mess, strlen(mess));
 
 		    if ( fp_f ) fprintf ( fp_f, "%s\n",expt_file_name);
-		    file_names[file_num] = NULL;
-		  }
-		  else {
-		    printf("match %d at %d  %d\n",score,xf,yf);
-		  }
-		}
-	      }
-
-	      if ( !match_found ) {
-
-		complement_seq ( &seq[lg], rg-lg+1);
-
-		ret = do_hash_con ( vector_length, rg-lg+1,
-				hash_values1, last_word,
-			        word_count, hash_values2, diag, line,
-			        vector_seq, &seq[lg], new_vector,
-			        min_match, half_window,
-			        &x, &y, &score);
-		if ( ret < 0 ) {
-		  eret =  vep_error ( fp_f, expt_file_name, 5 );
-		  exp_destroy_info ( e );
-		  file_names[file_num] = NULL;
-		  continue;
+		    failed = 1;
 		}
-		if ( ret ) {
-		  if ( score >= percent_cut ) {
-		    xr = x;
-		    yr = rg - lg - y + lg - score + 3;
-		    score_r = score;
-		    match_found = 1;
-		    /*  printf("reverse score %d at %d %d\n",score,xr,yr); */
-
-		    if ( !tmode ) {
-		    char mess[2048]; /* twice vfile_name ! */
-
-		      if (exp_put_str(e, EFLT_PS, "contaminated", 
-				      strlen("contaminated"))) {
-			eret =  vep_error ( fp_f, expt_file_name, 4 );
-			exp_destroy_info ( e );
-			file_names[file_num] = NULL;
-			continue;
-		      }
-		      sprintf(mess, "CONT = %d..%d\n%d %d %s",
-			      yr,yr+score-1,xr,score,vfile_name);
-		      exp_put_str(e, EFLT_TG, mess, strlen(mess));
-
-		      if ( fp_f ) fprintf ( fp_f, "%s\n",expt_file_name);
-		      file_names[file_num] = NULL;
-		    }
-		    else {
-		      printf("---match %d at %d  %d\n",score,xr,yr);
-		    }
-		  }
-		  match_found = 1;
+		else {
+		    printf("match %d at %d  %d %s\n",score_f,xf,yf,
+			   si.name[seq_f]);
 		}
-	      }
-	      if ( tmode && !match_found ) printf("no match\n");
 	    }
-	  }
-	  exp_destroy_info ( e );
-	  if (!(tmode)) (void) write_dot();
-	}
-      }
-    }
-      /*fprintf ( fp_p, "%s\n",expt_file_name); */
+	    else if ( tmode ) {
+		printf("no match\n");
+	    }
 
-      /* screening finished so write out those that have not failed */
+	    /* screening finished so write it out if it has not failed */
 
-    if ( fp_p ) {
-      for(i=0;i<num_files;i++) {
-	if ( file_names[i] ) fprintf( fp_p, "%s\n", file_names[i]);
-      }
+	    if ( !failed && fp_p ) fprintf ( fp_p, "%s\n", expt_file_name );
+	}
+	exp_destroy_info ( e );
+	if (!(tmode)) (void) write_dot();
     }
 
-    free_hash8 ( hash_values1, last_word,
-	         word_count, hash_values2,
-	         diag );
+    xfree ( diag );
+    xfree ( hash_values2 );
+    free_screen_index ( &si );
     return 0;
 }
 
@@ -0,0 +1,198 @@
+/*
+ * DUST low-complexity filtering.
+ *
+ * The sequence is examined in windows of 'window' bases, stepping by half a
+ * window. Within each window every suffix is scored by counting repeated
+ * triplets as they accumulate, and the highest scoring region is masked if
+ * its score exceeds 'level'.
+ *
+ * The triplet codes and run lengths are computed once for the whole
+ * sequence, and counts are reset by a generation stamp rather than by
+ * searching the list of triplets seen so far. This gives the same masking
+ * as the original implementation in a fraction of the time, making it
+ * cheap enough to run over complete assemblies.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dna_utils.h>
+
+#include "dust.h"
+
+#define TRUE   1
+#define FALSE  0
+
+#define DUST_NCODES (32*32*32)
+
+static int word = 3;
+static int window = 48;
+static int window2 = 24;
+static int level = 20;
+
+void set_dust_level(int value)
+{
+	level = value;
+}
+
+void set_dust_window(int value)
+{
+	window = value;
+	window2 = window / 2;
+}
+
+void set_dust_word(int value)
+{
+	word = value;
+}
+
+/* Per-sequence data shared by all windows */
+typedef struct {
+	unsigned short *code;	/* Last 3 letters (5 bits each) ending here */
+	int *run;		/* Number of consecutive letters ending here */
+	int *counts;		/* Triplet counts within the current suffix */
+	int *stamp;		/* Suffix number each counts[] entry is for */
+	int suffix;		/* Current suffix number */
+} dust_t;
+
+/*
+ * Scores the suffix of a window starting at s (an index into the
+ * sequence) and len bases long. ivv is the offset of s in the window.
+ * Updates *mv, *iv and *jv if a better scoring region is found.
+ */
+static void wo1(dust_t *d, int len, int s, int ivv, int *mv, int *iv, int *jv)
+{
+	int j, v, t, n, c, sum;
+	int suffix;
+
+	/* Restart the stamps rather than let the suffix number wrap */
+	if (d->suffix == INT_MAX) {
+		memset(d->stamp, 0, DUST_NCODES * sizeof(*d->stamp));
+		d->suffix = 0;
+	}
+	suffix = ++d->suffix;
+
+	sum = 0;
+	for (j = 0; j < len; j++) {
+		n = d->run[s+j];
+		if (n > j+1)
+			n = j+1;
+		if (n < word)
+			continue;
+
+		/* Letters before the suffix start do not form part of the word */
+		c = d->code[s+j];
+		if (j < 2)
+			c &= (1 << 5*(j+1)) - 1;
+
+		if (d->stamp[c] != suffix) {
+			d->stamp[c] = suffix;
+			d->counts[c] = 0;
+		}
+		if ((t = d->counts[c]) > 0) {
+			sum += t;
+			v = 10 * sum / j;
+			if (*mv < v) {
+				*mv = v;
+				*iv = ivv;
+				*jv = j;
+			}
+		}
+		d->counts[c]++;
+	}
+}
+
+static int wo(dust_t *d, int len, int s, int *beg, int *end)
+{
+	int i, l1, mv, iv, jv;
+
+	l1 = len - word + 1;
+	if (l1 < 0) {
+		*beg = 0;
+		*end = len - 1;
+		return 0;
+	}
+	mv = 0;
+	iv = 0;
+	jv = 0;
+	for (i=0; i < l1; i++) {
+		wo1(d, len-i, s+i, i, &mv, &iv, &jv);
+	}
+	*beg = iv;
+	*end = iv + jv;
+	return mv;
+}
+
+/*
+ * Masks low complexity regions of s (of length len) by replacing the
+ * bases with '#'. Pads ('*') are ignored when scoring and left untouched.
+ */
+void dust(int len, char *s)
+{
+	int i, j, l, from, to, a, b, v;
+	char *depadded = (char *)malloc(len);
+	int *depad_to_pad = (int *)calloc(len, sizeof(int));
+	int depadded_len;
+	dust_t d;
+	unsigned int ii;
+
+	d.code = (unsigned short *)malloc(len * sizeof(*d.code));
+	d.run = (int *)malloc(len * sizeof(*d.run));
+	d.counts = (int *)malloc(DUST_NCODES * sizeof(*d.counts));
+	d.stamp = (int *)calloc(DUST_NCODES, sizeof(*d.stamp));
+	d.suffix = 0;
+
+	if (!depadded || !depad_to_pad ||
+	    !d.code || !d.run || !d.counts || !d.stamp)
+		goto error;
+
+	memcpy(depadded, s, len);
+	depadded_len = len;
+	depad_seq(depadded, &depadded_len, depad_to_pad);
+
+	/* Encode words; non-letters break a run and shift in a zero */
+	for (ii = 0, i = 0; i < depadded_len; i++) {
+		int ch = (unsigned char)depadded[i];
+		if (isalpha(ch)) {
+			ii = ((ii << 5) | (toupper(ch) - 'A')) & (DUST_NCODES-1);
+			d.run[i] = i ? d.run[i-1] + 1 : 1;
+		} else {
+			ii = (ii << 5) & (DUST_NCODES-1);
+			d.run[i] = 0;
+		}
+		d.code[i] = ii;
+	}
+
+	from = 0;
+	to = -1;
+	for (i=0; i < depadded_len; i += window2) {
+		from -= window2;
+		to -= window2;
+		l = (depadded_len > i+window) ? window : depadded_len-i;
+		v = wo(&d, l, i, &a, &b);
+		for (j = from; j <= to; j++) {
+			if (isalpha(s[depad_to_pad[i+j]]))
+				s[depad_to_pad[i+j]] = '#';
+		}
+		if (v > level) {
+			for (j = a; j <= b && j < window2; j++) {
+				if (isalpha(s[depad_to_pad[i+j]]))
+					s[depad_to_pad[i+j]] = '#';
+			}
+			from = j;
+			to = b;
+		} else {
+			from = 0;
+			to = -1;
+		}
+	}
+
+ error:
+	if (depadded)     free(depadded);
+	if (depad_to_pad) free(depad_to_pad);
+	if (d.code)       free(d.code);
+	if (d.run)        free(d.run);
+	if (d.counts)     free(d.counts);
+	if (d.stamp)      free(d.stamp);
+}
@@ -4,6 +4,11 @@
 void set_dust_level(int value);
 void set_dust_window(int value);
 void set_dust_word(int value);
+
+/*
+ * Replaces low complexity regions of s (length len) with '#'. Pads are
+ * skipped over when scoring and are left untouched.
+ */
 void dust(int len, char *s);
 
 #endif
@@ -0,0 +1,209 @@
+/*
+ * Streaming FASTQ reading and writing for the read pre-processing programs
+ * (qclip, polyA_clip, ...) so that they can work on one file of many reads
+ * rather than one experiment file per read.
+ */
+
+#include <staden_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "xalloc.h"
+#include "fastq.h"
+
+fastq_entry *fastq_entry_create(void) {
+    return (fastq_entry *)xcalloc(1, sizeof(fastq_entry));
+}
+
+void fastq_entry_destroy(fastq_entry *e) {
+    if (!e)
+	return;
+
+    if (e->name)    xfree(e->name);
+    if (e->comment) xfree(e->comment);
+    if (e->seq)     xfree(e->seq);
+    if (e->qual)    xfree(e->qual);
+    if (e->line)    xfree(e->line);
+    xfree(e);
+}
+
+/*
+ * Ensures *str has room for at least len bytes.
+ * Returns 0 on success, -1 on failure.
+ */
+static int fastq_grow(char **str, size_t *alloc, size_t len) {
+    size_t n = *alloc ? *alloc : 128;
+    char *tmp;
+
+    if (len <= *alloc)
+	return 0;
+
+    while (n < len)
+	n *= 2;
+    if (NULL == (tmp = (char *)xrealloc(*str, n)))
+	return -1;
+
+    *str = tmp;
+    *alloc = n;
+    return 0;
+}
+
+/*
+ * Reads a complete line, of any length, into e->line with the trailing
+ * newline (and any carriage return) removed.
+ * Returns the line length, or -1 on end of file.
+ */
+static int fastq_getline(FILE *fp, fastq_entry *e) {
+    size_t len = 0;
+
+    for (;;) {
+	if (fastq_grow(&e->line, &e->line_alloc, len + 256))
+	    return -1;
+	if (NULL == fgets(e->line + len, e->line_alloc - len, fp)) {
+	    if (len == 0)
+		return -1;
+	    break;
+	}
+	len += strlen(e->line + len);
+	if (len && e->line[len-1] == '\n')
+	    break;
+    }
+
+    while (len && (e->line[len-1] == '\n' || e->line[len-1] == '\r'))
+	len--;
+    e->line[len] = 0;
+    e->line_no++;
+
+    return len;
+}
+
+int fastq_next(FILE *fp, fastq_entry *e) {
+    int len, qlen;
+    char *cp;
+
+    /* Header, skipping any blank lines */
+    do {
+	if ((len = fastq_getline(fp, e)) < 0)
+	    return 1;
+    } while (len == 0);
+
+    if (*e->line != '@') {
+	fprintf(stderr, "FASTQ line %lu: expected '@'\n", e->line_no);
+	return -1;
+    }
+
+    for (cp = e->line+1; *cp && !isspace((unsigned char)*cp); cp++)
+	;
+    if (fastq_grow(&e->name, &e->name_alloc, cp - e->line))
+	return -1;
+    memcpy(e->name, e->line+1, cp - e->line - 1);
+    e->name[cp - e->line - 1] = 0;
+
+    while (*cp && isspace((unsigned char)*cp))
+	cp++;
+    if (fastq_grow(&e->comment, &e->comment_alloc, strlen(cp)+1))
+	return -1;
+    strcpy(e->comment, cp);
+
+    /* Sequence, possibly over several lines */
+    e->seq_len = 0;
+    for (;;) {
+	if ((len = fastq_getline(fp, e)) < 0) {
+	    fprintf(stderr, "FASTQ line %lu: unexpected end of file\n",
+		    e->line_no);
+	    return -1;
+	}
+	if (*e->line == '+')
+	    break;
+	if (fastq_grow(&e->seq, &e->seq_alloc, e->seq_len + len + 1))
+	    return -1;
+	memcpy(e->seq + e->seq_len, e->line, len);
+	e->seq_len += len;
+    }
+    if (fastq_grow(&e->seq, &e->seq_alloc, e->seq_len + 1))
+	return -1;
+    e->seq[e->seq_len] = 0;
+
+    /* Quality, as many lines as needed to match the sequence length */
+    if (fastq_grow(&e->qual, &e->qual_alloc, e->seq_len + 1))
+	return -1;
+    for (qlen = 0; qlen < e->seq_len; ) {
+	if ((len = fastq_getline(fp, e)) < 0 || qlen + len > e->seq_len) {
+	    fprintf(stderr, "FASTQ line %lu: quality length does not match "
+		    "sequence length for %s\n", e->line_no, e->name);
+	    return -1;
+	}
+	memcpy(e->qual + qlen, e->line, len);
+	qlen += len;
+    }
+    e->qual[qlen] = 0;
+
+    return 0;
+}
+
+int fastq_write(FILE *fp, fastq_entry *e) {
+    if (fprintf(fp, "@%s%s%s\n%s\n+\n%s\n",
+		e->name, *e->comment ? " " : "", e->comment,
+		e->seq, e->qual) < 0)
+	return -1;
+
+    return 0;
+}
+
+/*
+ * Returns a pointer to the start of "tag:i:" within the comment, or NULL.
+ */
+static char *fastq_find_tag(fastq_entry *e, char *tag) {
+    size_t tlen = strlen(tag);
+    char *cp = e->comment;
+
+    while (cp && *cp) {
+	if (strncmp(cp, tag, tlen) == 0 && strncmp(cp+tlen, ":i:", 3) == 0)
+	    return cp;
+	if ((cp = strpbrk(cp, " \t")))
+	    cp++;
+    }
+
+    return NULL;
+}
+
+int fastq_get_tag(fastq_entry *e, char *tag, int *val) {
+    char *cp = fastq_find_tag(e, tag);
+
+    if (!cp)
+	return 0;
+
+    *val = atoi(cp + strlen(tag) + 3);
+    return 1;
+}
+
+int fastq_set_tag(fastq_entry *e, char *tag, int val) {
+    char buf[100], *cp, *end;
+    size_t clen = strlen(e->comment), blen;
+
+    sprintf(buf, "%.10s:i:%d", tag, val);
+    blen = strlen(buf);
+
+    if ((cp = fastq_find_tag(e, tag))) {
+	/* Cut out the old tag, then append the new one */
+	if (NULL == (end = strpbrk(cp, " \t")))
+	    end = cp + strlen(cp);
+	else
+	    end++;
+	memmove(cp, end, strlen(end)+1);
+	clen = strlen(e->comment);
+	while (clen && isspace((unsigned char)e->comment[clen-1]))
+	    e->comment[--clen] = 0;
+    }
+
+    if (fastq_grow(&e->comment, &e->comment_alloc, clen + blen + 2))
+	return -1;
+    if (clen)
+	e->comment[clen++] = ' ';
+    strcpy(e->comment + clen, buf);
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef _FASTQ_H_
+#define _FASTQ_H_
+
+#include <stdio.h>
+
+/*
+ * A single FASTQ record, reused from one call of fastq_next() to the next.
+ *
+ * The header line is split into the read name (up to the first white space)
+ * and a comment holding everything after it. Clip points and other per-read
+ * annotations are carried in the comment as SAM style "XX:i:value" tags so
+ * that the output of one clipping program can be streamed into the next.
+ */
+typedef struct {
+    char  *name;
+    char  *comment;
+    char  *seq;
+    char  *qual;		/* phred+33 encoded, seq_len long */
+    int    seq_len;
+    size_t name_alloc;
+    size_t comment_alloc;
+    size_t seq_alloc;
+    size_t qual_alloc;
+    char  *line;		/* line buffer */
+    size_t line_alloc;
+    unsigned long line_no;
+} fastq_entry;
+
+fastq_entry *fastq_entry_create(void);
+void fastq_entry_destroy(fastq_entry *e);
+
+/*
+ * Reads the next record from fp into e.
+ * Returns 0 on success, 1 on end of file and -1 on a malformed record.
+ */
+int fastq_next(FILE *fp, fastq_entry *e);
+
+/*
+ * Writes e to fp.
+ * Returns 0 on success, -1 on failure.
+ */
+int fastq_write(FILE *fp, fastq_entry *e);
+
+/*
+ * Looks up integer tag 'tag' (eg "QL") in the record comment.
+ * Returns 1 and sets *val if found, 0 otherwise.
+ */
+int fastq_get_tag(fastq_entry *e, char *tag, int *val);
+
+/*
+ * Sets integer tag 'tag' in the record comment, replacing any existing value.
+ * Returns 0 on success, -1 on failure.
+ */
+int fastq_set_tag(fastq_entry *e, char *tag, int val);
+
+#endif /* _FASTQ_H_ */
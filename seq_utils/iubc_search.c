@@ -0,0 +1,218 @@
+/*
+ * Bit parallel (Shift-And) searching for words of IUBC symbols.
+ *
+ * Which sequence characters each word symbol matches is taken from
+ * iubc_word_match, so the matches found are exactly those it would
+ * confirm, without first having to find candidate positions.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xalloc.h"
+#include "dna_utils.h"
+#include "iubc_search.h"
+
+iubc_searcher *iubc_searcher_create(char **words, int nwords) {
+    iubc_searcher *s;
+    iubc_group *g;
+    int i, j, c, len, bit;
+    char sym;
+
+    if (NULL == (s = (iubc_searcher *)xcalloc(1, sizeof(iubc_searcher))))
+	return NULL;
+
+    s->nwords = nwords;
+    s->word = words;
+    if (NULL == (s->word_len = (int *)xmalloc((nwords + 1) * sizeof(int)))) {
+	iubc_searcher_destroy(s);
+	return NULL;
+    }
+
+    /* count the groups needed, packing the words in order */
+    bit = IUBC_BITS;
+    for (i = 0; i < nwords; i++) {
+	len = s->word_len[i] = strlen(words[i]);
+	if (len > s->max_len)
+	    s->max_len = len;
+	if (len == 0)
+	    continue;
+	if (len > IUBC_BITS)
+	    len = IUBC_BITS;
+	if (bit + len > IUBC_BITS) {
+	    s->ngroups++;
+	    bit = 0;
+	}
+	bit += len;
+    }
+
+    if (s->ngroups &&
+	NULL == (s->group = (iubc_group *)xcalloc(s->ngroups,
+						  sizeof(iubc_group)))) {
+	iubc_searcher_destroy(s);
+	return NULL;
+    }
+
+    g = s->group - 1;
+    bit = IUBC_BITS;
+    for (i = 0; i < nwords; i++) {
+	if (0 == (len = s->word_len[i]))
+	    continue;
+	if (len > IUBC_BITS)
+	    len = IUBC_BITS;
+	if (bit + len > IUBC_BITS) {
+	    g++;
+	    bit = 0;
+	}
+
+	for (j = 0; j < len; j++) {
+	    for (c = 0; c < 256; c++) {
+		/* iubc_lookup is only safe for 7 bit chars; others are unknown */
+		sym = c < 128 ? c : 0;
+		if (iubc_word_match(&sym, 0, 1, &words[i][j], 1))
+		    g->mask[c] |= (uint64_t)1 << (bit + j);
+	    }
+	}
+
+	g->first |= (uint64_t)1 << bit;
+	g->word_last[g->nwords] = (uint64_t)1 << (bit + len - 1);
+	g->last |= g->word_last[g->nwords];
+	g->word[g->nwords++] = i;
+	bit += len;
+    }
+
+    return s;
+}
+
+void iubc_searcher_destroy(iubc_searcher *s) {
+    if (!s)
+	return;
+
+    if (s->word_len) xfree(s->word_len);
+    if (s->group)    xfree(s->group);
+    xfree(s);
+}
+
+/*
+ * Returns the position of the first symbol of a match of len symbols
+ * ending at seq[end], allowing for pads.
+ */
+static int iubc_match_start(char *seq, int end, int len) {
+    for (;; end--) {
+	if (seq[end] != '*' && --len == 0)
+	    return end;
+    }
+}
+
+/*
+ * Appends a match to *hits, growing it as needed.
+ * Returns 0 for success, -1 for failure.
+ */
+static int iubc_add_hit(iubc_hit **hits, int *max_hits, int n,
+			int word, int pos) {
+    if (n == *max_hits) {
+	int new_max = *max_hits ? *max_hits * 2 : 1000;
+	iubc_hit *h = (iubc_hit *)xrealloc(*hits, new_max * sizeof(iubc_hit));
+	if (!h)
+	    return -1;
+	*hits = h;
+	*max_hits = new_max;
+    }
+
+    (*hits)[n].word = word;
+    (*hits)[n].pos = pos;
+    return 0;
+}
+
+int iubc_search(iubc_searcher *s, char *seq, int seq_len, int circle,
+		iubc_hit **hits, int *max_hits) {
+    unsigned char *useq;
+    char *ext = NULL;
+    iubc_hit *sorted;
+    int *count;
+    int ext_len, i, k, w, start, n = 0;
+    int gi;
+
+    /*
+     * For circles search a copy of seq extended by enough of its start
+     * for the longest word to run off the end.
+     */
+    ext_len = seq_len;
+    if (circle && seq_len > 0 && s->max_len > 1) {
+	ext_len = seq_len + s->max_len - 1;
+	if (NULL == (ext = (char *)xmalloc(ext_len)))
+	    return -1;
+	memcpy(ext, seq, seq_len);
+	for (i = seq_len; i < ext_len; i++)
+	    ext[i] = ext[i - seq_len];
+	seq = ext;
+    }
+    useq = (unsigned char *)seq;
+
+    for (gi = 0; gi < s->ngroups; gi++) {
+	iubc_group *g = &s->group[gi];
+	uint64_t *mask = g->mask;
+	uint64_t first = g->first, last = g->last, d = 0;
+
+	for (i = 0; i < ext_len; i++) {
+	    if (useq[i] == '*')
+		continue;
+
+	    d = ((d << 1) | first) & mask[useq[i]];
+	    if (!(d & last))
+		continue;
+
+	    for (k = 0; k < g->nwords; k++) {
+		if (!(d & g->word_last[k]))
+		    continue;
+
+		w = g->word[k];
+		if (s->word_len[w] > IUBC_BITS) {
+		    start = iubc_match_start(seq, i, IUBC_BITS);
+		    if (!iubc_word_match_padded(seq, start, ext_len,
+						s->word[w], s->word_len[w]))
+			continue;
+		} else {
+		    start = iubc_match_start(seq, i, s->word_len[w]);
+		}
+
+		/* in circles, matches starting in the copy were found already */
+		if (start >= seq_len)
+		    continue;
+
+		if (-1 == iubc_add_hit(hits, max_hits, n++, w, start + 1)) {
+		    if (ext)
+			xfree(ext);
+		    return -1;
+		}
+	    }
+	}
+    }
+
+    if (ext)
+	xfree(ext);
+
+    if (n == 0)
+	return 0;
+
+    /* group by word, keeping each word's matches in order of position */
+    count = (int *)xcalloc(s->nwords + 1, sizeof(int));
+    sorted = (iubc_hit *)xmalloc(*max_hits * sizeof(iubc_hit));
+    if (!count || !sorted) {
+	if (count)  xfree(count);
+	if (sorted) xfree(sorted);
+	return -1;
+    }
+
+    for (i = 0; i < n; i++)
+	count[(*hits)[i].word + 1]++;
+    for (w = 0; w < s->nwords; w++)
+	count[w + 1] += count[w];
+    for (i = 0; i < n; i++)
+	sorted[count[(*hits)[i].word]++] = (*hits)[i];
+
+    xfree(*hits);
+    xfree(count);
+    *hits = sorted;
+    return n;
+}
@@ -0,0 +1,75 @@
+#ifndef _IUBC_SEARCH_H_
+#define _IUBC_SEARCH_H_
+
+#include <inttypes.h>
+
+/* Number of word symbols searched for together */
+#define IUBC_BITS 64
+
+typedef struct {
+    int word;			/* index of the word matched */
+    int pos;			/* left end of the match, 1 based */
+} iubc_hit;
+
+/*
+ * A set of words sharing one 64 bit mask, each word taking one bit per
+ * symbol. Words longer than IUBC_BITS have a group to themselves and only
+ * their first IUBC_BITS symbols are in the mask.
+ */
+typedef struct {
+    uint64_t mask[256];		/* symbols matching each sequence char */
+    uint64_t first;		/* first symbol of each word */
+    uint64_t last;		/* last symbol of each word */
+    int nwords;
+    int word[IUBC_BITS];	/* words in the group */
+    uint64_t word_last[IUBC_BITS]; /* last symbol of each of them */
+} iubc_group;
+
+/*
+ * Words of IUBC symbols prepared for searching, such as all of the
+ * recognition sequences of a set of restriction enzymes.
+ *
+ * The sequence is read once per group of words. After each character
+ * the state has a bit set for every symbol ending a match of the start
+ * of its word; the state for the next character is the previous one
+ * shifted up a symbol, with the first symbol of every word added, and
+ * masked by the symbols matching that character. Unlike expanding the
+ * words into every sequence they stand for, the cost does not depend on
+ * how ambiguous the words are.
+ */
+typedef struct {
+    int nwords;
+    char **word;		/* the words, not copied */
+    int *word_len;
+    int max_len;		/* length of the longest word */
+    int ngroups;
+    iubc_group *group;
+} iubc_searcher;
+
+/*
+ * Creates a searcher for nwords words of IUBC symbols. The words are not
+ * copied so must be kept until the searcher is destroyed. Requires
+ * set_iubc_lookup() to have been called.
+ *
+ * Returns the searcher, or NULL on failure.
+ */
+iubc_searcher *iubc_searcher_create(char **words, int nwords);
+
+void iubc_searcher_destroy(iubc_searcher *s);
+
+/*
+ * Finds every match of the searcher's words in seq, as iubc_word_match_padded
+ * would, skipping any pads ('*') in seq. If circle is true, matches may run
+ * off the end of seq and continue from its start.
+ *
+ * Matches are stored in *hits, which is grown with xrealloc as needed and
+ * *max_hits updated; both may be reused between calls and the caller
+ * should xfree *hits when done.
+ *
+ * Returns the number of matches, grouped by word in the order given and
+ * then in order of position, or -1 for failure.
+ */
+int iubc_search(iubc_searcher *s, char *seq, int seq_len, int circle,
+		iubc_hit **hits, int *max_hits);
+
+#endif
@@ -8,6 +8,7 @@
 #include "getfile.h"
 #include "misc.h"                                        /* need for strdup */
 #include "dna_utils.h"
+#include "iubc_search.h"
 
 #define NAMEDEL "/"
 #define SEQDEL "/"
@@ -933,88 +934,95 @@ FindMatches(R_Enz *r_enzyme,                                          /* in */
 	    R_Match **match,                                         /* out */
 	    int *total_matches)                                      /* out */
 {
-#define SIZE_HASH 256
-
-    int *seq_hash_values;
-    int *matches, max_matches=MAXMATCHES;
-    int num_matches;
-    int i, j, k;
-    int cnt = 0;
+    iubc_searcher *searcher;
+    iubc_hit *hits = NULL;
+    int max_hits = 0, num_hits;
+    char **words = NULL;
+    int *word_enz = NULL, *word_seq = NULL, *word_count = NULL;
+    int num_words;
+    int i, j, k, w;
+    int cnt = 0, ret = -2;
     int array_size = MAXMATCHES;
     int array_inc = MAXMATCHES;
-    int last_word[SIZE_HASH];
-    int word_count[SIZE_HASH];
 
-    if ( ! (seq_hash_values = (int *) xmalloc ( sizeof(int)*(sequence_len)))) {
-	return -2;
+    *total_matches = 0;
+
+    /* search for every recognition sequence of every enzyme in one pass */
+    for (num_words = i = 0; i < num_enzymes; i++)
+	num_words += r_enzyme[i].num_seq;
+    if (num_words == 0)
+	return 1;
+
+    words = (char **)xmalloc(num_words * sizeof(char *));
+    word_enz = (int *)xmalloc(num_words * sizeof(int));
+    word_seq = (int *)xmalloc(num_words * sizeof(int));
+    word_count = (int *)xcalloc(num_words, sizeof(int));
+    if (!words || !word_enz || !word_seq || !word_count)
+	goto cleanup;
+
+    for (w = i = 0; i < num_enzymes; i++) {
+	for (j = 0; j < r_enzyme[i].num_seq; j++, w++) {
+	    words[w] = r_enzyme[i].seq[j];
+	    word_enz[w] = i;
+	    word_seq[w] = j;
+	}
     }
 
-    if ( ! (matches = (int *) xmalloc ( sizeof(int)*(max_matches) ))) {
-	return -2;
-    }
+    if (NULL == (searcher = iubc_searcher_create(words, num_words)))
+	goto cleanup;
+    num_hits = iubc_search(searcher, sequence, sequence_len, sequence_type,
+			   &hits, &max_hits);
+    iubc_searcher_destroy(searcher);
+    if (num_hits < 0)
+	goto cleanup;
+
+    /* as before, ignore recognition sequences with too many matches */
+    for (k = 0; k < num_hits; k++)
+	word_count[hits[k].word]++;
+
+    /* store the match results in array 'match' */
+    for (k = 0; k < num_hits; k++) {
+	w = hits[k].word;
+	if (word_count[w] > MAXMATCHES)
+	    continue;
 
-    /* hash sequence */
-    hash_dna(sequence, sequence_len, seq_hash_values, last_word, word_count);
+	(*match)[cnt].enz_name = word_enz[w];
+	(*match)[cnt].enz_seq = word_seq[w];
+	/* store the cut position in matches as required for displaying */
+	(*match)[cnt].padded_cut_pos =
+	    (*match)[cnt].cut_pos =
+		hits[k].pos + r_enzyme[word_enz[w]].cut_site[word_seq[w]];
 
-    /* for each enzyme */
-    for (i = 0; i < num_enzymes; i++) {
-	/* for each recognition sequence */
-	for (j = 0; j < r_enzyme[i].num_seq; j++) {
-	    /* find the matches between rec seq and dna */
-	    dna_search(sequence, sequence_len, r_enzyme[i].seq[j],
-		       strlen(r_enzyme[i].seq[j]), sequence_type,
-		       seq_hash_values, last_word, word_count, matches, 
-		       max_matches, &num_matches);
-
-	    /* error = search_dna (sequence, sequence_len, r_enzyme[i].seq[j], 
-				strlen(r_enzyme[i].seq[j]), sequence_type, 
-				matches, max_matches, 
-				&num_matches, seq_hash_values);
-				*/
-	    /* store the match results in array 'match' */
-	    for (k = 0; k < num_matches; k++) {
-		(*match)[cnt].enz_name = i;
-		(*match)[cnt].enz_seq = j;
-		/* store the cut position in matches as required for 
-		 * displaying 
-		 */
-		if (matches[k] + r_enzyme[i].cut_site[j] == sequence_len) {
-		    (*match)[cnt].padded_cut_pos =
-			(*match)[cnt].cut_pos = sequence_len;
-		} else {
-		    /*
-		    (*match)[cnt].cut_pos = (matches[k] + 
-				      r_enzyme[i].cut_site[j])%sequence_len;
-				      */
-		    (*match)[cnt].padded_cut_pos =
-			(*match)[cnt].cut_pos =
-			    matches[k] + r_enzyme[i].cut_site[j];
-		}
-		   
-		cnt++;
-		/* cnt is less than MAXMATCHES 
-	        * if it is larger, then need to allocate more space to array
-		*/
-		if (cnt >= array_size) {
-	            /* set array_size to be count plus arbitary increment */
-	            array_size = cnt + array_inc;
-
-	            if (NULL == ( (*match) = (R_Match *)realloc((*match), 
-							     array_size * 
-							     sizeof(R_Match))))
-			return 0;
-		    /* clear the new memory */
-
-		    memset(&(*match)[cnt], 0, sizeof(R_Match) * array_inc); 
-		}
+	cnt++;
+	/* cnt is less than MAXMATCHES 
+	 * if it is larger, then need to allocate more space to array
+	 */
+	if (cnt >= array_size) {
+	    /* set array_size to be count plus arbitary increment */
+	    array_size = cnt + array_inc;
+
+	    if (NULL == ( (*match) = (R_Match *)realloc((*match), 
+							 array_size * 
+							 sizeof(R_Match)))) {
+		ret = 0;
+		goto cleanup;
 	    }
+	    /* clear the new memory */
+
+	    memset(&(*match)[cnt], 0, sizeof(R_Match) * array_inc); 
 	}
     }
 
     *total_matches = cnt;
-    xfree(seq_hash_values);
-    xfree(matches);
-    return 1;
+    ret = 1;
+
+ cleanup:
+    if (hits)       xfree(hits);
+    if (words)      xfree(words);
+    if (word_enz)   xfree(word_enz);
+    if (word_seq)   xfree(word_seq);
+    if (word_count) xfree(word_count);
+    return ret;
 }
 
 /*
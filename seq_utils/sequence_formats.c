@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "os.h"
 #include "getfile.h"
@@ -85,7 +87,8 @@ char genetic_code_ft[16][10]={
 
    For embl, genbank and fasta an entryname can also be supplied to enable
    entries to be extracted from concatenated files. The default is to extract
-   the first entry.
+   the first entry. Named entries are found using an index of the file, see
+   find_seq_entry.
 
    seq_file_format works out the file format.
    get_seq_type returns 1 for dna, 2 for protein, 0 for anything else
@@ -236,13 +239,14 @@ write_sequence(char *line,
     for (j = 0; j < MAX_SEQ_LINE && line[j]; j++) {
 	if ( isalpha ( (int) line[j]) || (int) line[j] == '-') {
 	    if ( *seq_len+1 >= (*buf_size)) {
-		realloc_sequence(seq, buf_size, increment);
+		realloc_sequence(seq, buf_size, MAX(increment, *buf_size));
 	    }
 	    (*seq)[*seq_len] = line[j];
 	    *seq_len += 1;
 	}
     }
-    (*seq)[*seq_len] = 0; /* nul terminate */
+    if (*seq)
+	(*seq)[*seq_len] = 0; /* nul terminate */
 }
 
 
@@ -273,7 +277,7 @@ void get_staden_format_seq ( char **seq, int max_len, int *seq_len, FILE *fp )
 		if ( '<' == line[j] ) j += 20;
 		if (isalpha ( (int) line[j]) || (int) line[j] == '-') {
 		    if ( *seq_len >= buf_size) {
-			realloc_sequence(seq, &buf_size, increment);
+			realloc_sequence(seq, &buf_size, MAX(increment, buf_size));
 		    }
 		    (*seq)[*seq_len] = line[j];
 		    *seq_len += 1;
@@ -961,6 +965,636 @@ EGFR_HUMAN  Length: 1210  November 26, 1997 16:11  Type: P  Check: 1521  ..
     }
 }
 
+/*
+ * ---------------------------------------------------------------------------
+ * Entry index for EMBL, GenBank and FASTA files.
+ *
+ * Rather than reading the file from the start for each named entry, which
+ * makes loading every entry of a large file in turn quadratic in its size,
+ * the file is scanned once to record where each entry starts. The index is
+ * kept in memory for the most recently used file and saved alongside it.
+ *
+ * The index has one line per entry in the style of a samtools .fai file:
+ * name, length, offset, bases per line and bytes per line, separated by
+ * tabs. For FASTA entries the offset is that of the first base, and when
+ * all the sequence lines but the last are the same length the sequence is
+ * read straight into place in a single fread, as with samtools. Otherwise,
+ * and for EMBL and GenBank entries (whose offset is that of the ID or
+ * LOCUS line), the line lengths are 0 and the entry is parsed from there
+ * as before.
+ *
+ * A FASTA file whose entries can all be read directly is one samtools
+ * could index itself, so its index is saved as file.fai and a samtools
+ * index of it is used as it is. Any other index is saved as file.sidx,
+ * which samtools does not read.
+ *
+ * The index only says where to start reading. Each entry is checked
+ * against the header line at its offset before it is used, and an index
+ * which disagrees with the file, for instance one left newer than a file
+ * copied over it, is rebuilt. An entry name which is not found is looked
+ * for from the start of the file as before.
+ * ---------------------------------------------------------------------------
+ */
+
+typedef struct {
+    char *name;
+    int length;			/* number of bases */
+    off_t offset;		/* start of the entry or of its sequence */
+    int line_bases;		/* bases per full line, 0 if irregular */
+    int line_width;		/* bytes per full line */
+} seq_index_entry;
+
+typedef struct {
+    char *file_name;
+    time_t mtime;		/* of the sequence file when indexed */
+    off_t size;
+    int nentries;
+    seq_index_entry *entry;	/* in file order */
+    seq_index_entry **by_name;	/* entries sorted by name, then file order */
+} seq_index;
+
+/* The index of the most recently used file */
+static seq_index *last_index = NULL;
+
+/*
+ * Removes all the entries from idx.
+ */
+static void seq_index_clear(seq_index *idx) {
+    int i;
+
+    for (i = 0; i < idx->nentries; i++)
+	free(idx->entry[i].name);
+    if (idx->entry)
+	xfree(idx->entry);
+    idx->entry = NULL;
+    idx->nentries = 0;
+}
+
+static void seq_index_destroy(seq_index *idx) {
+    if (!idx)
+	return;
+
+    seq_index_clear(idx);
+    if (idx->by_name)   xfree(idx->by_name);
+    if (idx->file_name) free(idx->file_name);
+    xfree(idx);
+}
+
+/*
+ * Appends an entry to idx, growing it as needed.
+ * Returns the entry, or NULL for failure.
+ */
+static seq_index_entry *seq_index_add(seq_index *idx, int *max_entries,
+				      char *name, off_t offset) {
+    seq_index_entry *e;
+
+    if (idx->nentries == *max_entries) {
+	int new_max = *max_entries ? *max_entries * 2 : 1000;
+	e = (seq_index_entry *)xrealloc(idx->entry,
+					new_max * sizeof(seq_index_entry));
+	if (!e)
+	    return NULL;
+	idx->entry = e;
+	*max_entries = new_max;
+    }
+
+    e = &idx->entry[idx->nentries];
+    if (NULL == (e->name = strdup(name)))
+	return NULL;
+    e->length = 0;
+    e->offset = offset;
+    e->line_bases = 0;
+    e->line_width = 0;
+    idx->nentries++;
+    return e;
+}
+
+/*
+ * Copies the name following a header line's tag at line+skip, as the
+ * entry name is compared by the format readers.
+ * Returns 0 for success, -1 if there is no name.
+ */
+static int seq_index_name(char *line, int skip, char *name) {
+    char *cp;
+    int len;
+
+    if ((int)strlen(line) <= skip)
+	return -1;
+
+    for (cp = line + skip; *cp && !isspace(*cp); cp++)
+	;
+    if (0 == (len = cp - (line + skip)))
+	return -1;
+
+    memcpy(name, line + skip, len);
+    name[len] = 0;
+    return 0;
+}
+
+/*
+ * Counts the bases of a line that write_sequence would keep.
+ */
+static int seq_index_bases(char *line) {
+    int j, n = 0;
+
+    for (j = 0; line[j]; j++)
+	if (isalpha((int)line[j]) || (int)line[j] == '-')
+	    n++;
+
+    return n;
+}
+
+/*
+ * Checks a FASTA sequence line against the line length of its entry,
+ * taken from the first line. width is -1 for a last line with no newline.
+ * Returns 1 if the entry cannot be read directly, 0 otherwise.
+ */
+static int seq_index_line(seq_index_entry *e, int bases, int width,
+			  int kept, int *ended) {
+    if (kept != bases)
+	return 1;
+
+    if (bases == 0) {
+	*ended = 1;
+	return 0;
+    }
+    if (*ended)
+	return 1;
+
+    if (!e->line_bases) {
+	e->line_bases = bases;
+	e->line_width = width < 0 ? bases + 1 : width;
+    } else if (bases > e->line_bases) {
+	return 1;
+    } else if (bases < e->line_bases) {
+	*ended = 1;
+    } else if (width >= 0 && width != e->line_width) {
+	return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Scans an EMBL, GenBank or FASTA file for the entries in it.
+ * Returns 0 for success, -1 for failure.
+ */
+static int seq_index_scan(seq_index *idx, FILE *fp, int fmt) {
+    char line[MAX_SEQ_LINE], name[MAX_SEQ_LINE];
+    seq_index_entry *e = NULL;
+    int max_entries = 0;
+    int len, line_start = 1, in_seq = 0;
+    int line_bytes = 0, line_kept = 0;	/* of the current FASTA line */
+    int ended = 0, irregular = 0;	/* of the current FASTA entry */
+    off_t pos;
+
+    if (fseeko(fp, 0, SEEK_SET))
+	return -1;
+
+    for (pos = 0; fgets(line, sizeof(line), fp) != NULL; pos += len) {
+	if (0 == (len = strlen(line)))
+	    continue;
+
+	if (line_start &&
+	    ((EMBL == fmt && 0 == strncmp("ID", line, 2)) ||
+	     (GENBANK == fmt && 0 == strncmp("LOCUS", line, 5)) ||
+	     (FASTA == fmt && '>' == line[0]))) {
+	    if (e && irregular)
+		e->line_bases = e->line_width = 0;
+	    e = NULL;
+	    in_seq = ended = irregular = 0;
+
+	    if (0 == seq_index_name(line, EMBL == fmt ? 5 :
+				    GENBANK == fmt ? 12 : 1, name)) {
+		if (NULL == (e = seq_index_add(idx, &max_entries, name,
+					       FASTA == fmt ? pos + len : pos)))
+		    return -1;
+		in_seq = (FASTA == fmt);
+	    }
+
+	} else if (e && !in_seq) {
+	    /* look for the line that precedes the sequence data */
+	    if ((EMBL == fmt && 0 == strncmp("SQ", line, 2)) ||
+		(GENBANK == fmt && 0 == strncmp("ORIGIN", line, 6)))
+		in_seq = 1;
+
+	} else if (e && FASTA != fmt) {
+	    if (0 == strncmp("//", line, 2)) {
+		e = NULL;
+		in_seq = 0;
+	    } else {
+		e->length += seq_index_bases(line);
+	    }
+
+	} else if (e) {
+	    e->length += seq_index_bases(line);
+
+	    /*
+	     * FASTA sequence lines can be read directly if they are all
+	     * the same length, bar a shorter last one, and hold nothing
+	     * but bases.
+	     */
+	    line_bytes += len;
+	    line_kept += seq_index_bases(line);
+	    if (line[len-1] == '\n') {
+		int nl = (line_bytes > 1 && line[len-2] == '\r') ? 2 : 1;
+		irregular |= seq_index_line(e, line_bytes - nl, line_bytes,
+					    line_kept, &ended);
+		line_bytes = line_kept = 0;
+	    }
+	}
+
+	line_start = (line[len-1] == '\n');
+    }
+
+    /* a last line with no newline */
+    if (e && FASTA == fmt && line_bytes)
+	irregular |= seq_index_line(e, line_bytes, -1, line_kept, &ended);
+    if (e && irregular)
+	e->line_bases = e->line_width = 0;
+
+    return 0;
+}
+
+/*
+ * Returns the number of bytes holding the sequence of a FASTA entry that
+ * can be read directly, from its first base to its last, as samtools
+ * counts them. The line end after the last base is not included, since
+ * the file may stop without one.
+ */
+static off_t seq_index_span(seq_index_entry *e) {
+    if (e->length <= 0)
+	return 0;
+    return (off_t)((e->length - 1) / e->line_bases) * e->line_width
+	+ (e->length - 1) % e->line_bases + 1;
+}
+
+/*
+ * Loads an index saved by seq_index_save, or by samtools, for a sequence
+ * file of size bytes. Entries which lie outside the file are rejected.
+ * Returns 0 for success, -1 for failure.
+ */
+static int seq_index_load(seq_index *idx, char *fai_name, off_t size) {
+    char line[MAX_SEQ_LINE], *tab;
+    seq_index_entry *e;
+    int max_entries = 0;
+    int length, line_bases, line_width;
+    int64_t offset;
+    FILE *fp;
+
+    if (NULL == (fp = fopen(fai_name, "r")))
+	return -1;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if (NULL == (tab = strchr(line, '\t')))
+	    goto error;
+	*tab = 0;
+	if (4 != sscanf(tab+1, "%d %"SCNd64" %d %d", &length, &offset,
+			&line_bases, &line_width))
+	    goto error;
+	if (length < 0 || line_bases < 0 || line_width < line_bases)
+	    goto error;
+	if (offset < 0 || offset > size)
+	    goto error;
+
+	if (NULL == (e = seq_index_add(idx, &max_entries, line, offset)))
+	    goto error;
+	e->length = length;
+	e->line_bases = line_bases;
+	e->line_width = line_width;
+	if (line_bases && seq_index_span(e) > size - e->offset)
+	    goto error;
+    }
+
+    fclose(fp);
+    return 0;
+
+ error:
+    fclose(fp);
+    return -1;
+}
+
+/*
+ * Returns the name of the saved index of file_name with the given suffix,
+ * or NULL for failure. The caller should xfree the result.
+ */
+static char *seq_index_file(char *file_name, char *suffix) {
+    char *fai_name;
+
+    if (NULL == (fai_name = (char *)xmalloc(strlen(file_name) +
+					    strlen(suffix) + 1)))
+	return NULL;
+    sprintf(fai_name, "%s%s", file_name, suffix);
+    return fai_name;
+}
+
+/*
+ * Loads the index of file_name saved with the given suffix, provided it is
+ * no older than the file, described by st.
+ * Returns 0 for success, -1 for failure, leaving idx empty.
+ */
+static int seq_index_try(seq_index *idx, char *file_name, char *suffix,
+			 struct stat *st) {
+    struct stat fai_st;
+    char *fai_name;
+    int ret = -1;
+
+    if (NULL == (fai_name = seq_index_file(file_name, suffix)))
+	return -1;
+
+    if (0 == stat(fai_name, &fai_st) && fai_st.st_mtime >= st->st_mtime &&
+	0 == seq_index_load(idx, fai_name, st->st_size))
+	ret = 0;
+    else
+	seq_index_clear(idx);
+
+    xfree(fai_name);
+    return ret;
+}
+
+/*
+ * Saves the index of file_name, in format fmt, quietly giving up if it
+ * cannot be written. Only an index samtools could have made is saved as
+ * file_name.fai; see above.
+ */
+static void seq_index_save(seq_index *idx, char *file_name, int fmt) {
+    seq_index_entry *e;
+    char *fai_name;
+    FILE *fp;
+    int i, err = 0, samtools = (FASTA == fmt);
+
+    for (i = 0; samtools && i < idx->nentries; i++)
+	if (!idx->entry[i].line_bases)
+	    samtools = 0;
+
+    if (NULL == (fai_name = seq_index_file(file_name,
+					   samtools ? ".fai" : ".sidx")))
+	return;
+    if (NULL == (fp = fopen(fai_name, "w"))) {
+	xfree(fai_name);
+	return;
+    }
+
+    for (i = 0; i < idx->nentries; i++) {
+	e = &idx->entry[i];
+	if (fprintf(fp, "%s\t%d\t%"PRId64"\t%d\t%d\n", e->name, e->length,
+		    (int64_t)e->offset, e->line_bases, e->line_width) < 0)
+	    err = 1;
+    }
+
+    if (fclose(fp) || err)
+	remove(fai_name);
+    xfree(fai_name);
+}
+
+/* Orders entries by name and then by position in the file */
+static int seq_index_cmp(const void *p1, const void *p2) {
+    seq_index_entry *e1 = *(seq_index_entry **)p1;
+    seq_index_entry *e2 = *(seq_index_entry **)p2;
+    int r;
+
+    if ((r = strcmp(e1->name, e2->name)))
+	return r;
+    return (e1 > e2) - (e1 < e2);
+}
+
+/*
+ * Returns the first entry called name, or NULL if there is none.
+ */
+static seq_index_entry *seq_index_find(seq_index *idx, char *name) {
+    int lo = 0, hi = idx->nentries, mid;
+
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (strcmp(idx->by_name[mid]->name, name) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+
+    if (lo < idx->nentries && 0 == strcmp(idx->by_name[lo]->name, name))
+	return idx->by_name[lo];
+    return NULL;
+}
+
+/*
+ * Returns the index of file_name, in format fmt and open as fp. The index
+ * in memory or saved beside the file is used if it is up to date, and
+ * otherwise, or if rescan is set, the file is scanned and the index saved.
+ * Returns NULL for failure.
+ */
+static seq_index *seq_index_get(char *file_name, FILE *fp, int fmt,
+				int rescan) {
+    struct stat st;
+    seq_index *idx;
+    int i;
+
+    if (stat(file_name, &st))
+	return NULL;
+
+    if (!rescan && last_index &&
+	0 == strcmp(last_index->file_name, file_name) &&
+	last_index->mtime == st.st_mtime && last_index->size == st.st_size)
+	return last_index;
+
+    seq_index_destroy(last_index);
+    last_index = NULL;
+
+    if (NULL == (idx = (seq_index *)xcalloc(1, sizeof(seq_index))))
+	return NULL;
+    if (NULL == (idx->file_name = strdup(file_name))) {
+	seq_index_destroy(idx);
+	return NULL;
+    }
+    idx->mtime = st.st_mtime;
+    idx->size = st.st_size;
+
+    if (rescan ||
+	((FASTA != fmt || 0 != seq_index_try(idx, file_name, ".fai", &st)) &&
+	 0 != seq_index_try(idx, file_name, ".sidx", &st))) {
+	if (-1 == seq_index_scan(idx, fp, fmt)) {
+	    seq_index_destroy(idx);
+	    return NULL;
+	}
+	seq_index_save(idx, file_name, fmt);
+    }
+
+    if (NULL == (idx->by_name = (seq_index_entry **)
+		 xmalloc((idx->nentries + 1) * sizeof(seq_index_entry *)))) {
+	seq_index_destroy(idx);
+	return NULL;
+    }
+    for (i = 0; i < idx->nentries; i++)
+	idx->by_name[i] = &idx->entry[i];
+    qsort(idx->by_name, idx->nentries, sizeof(seq_index_entry *),
+	  seq_index_cmp);
+
+    return last_index = idx;
+}
+
+/*
+ * Checks that entry e of idx, in format fmt and open as fp, starts where
+ * the index says: at the ID or LOCUS line naming it for EMBL and GenBank,
+ * and just after the header line naming it for FASTA.
+ * Returns 1 if it does, 0 if not.
+ */
+static int seq_index_check(seq_index *idx, FILE *fp, int fmt,
+			   seq_index_entry *e) {
+    char line[MAX_SEQ_LINE], name[MAX_SEQ_LINE], *cp;
+    off_t start;
+    size_t len;
+
+    if (FASTA != fmt) {
+	if (fseeko(fp, e->offset, SEEK_SET) ||
+	    NULL == fgets(line, sizeof(line), fp))
+	    return 0;
+	if ((EMBL == fmt && strncmp("ID", line, 2)) ||
+	    (GENBANK == fmt && strncmp("LOCUS", line, 5)))
+	    return 0;
+	return 0 == seq_index_name(line, EMBL == fmt ? 5 : 12, name) &&
+	    0 == strcmp(name, e->name);
+    }
+
+    /* read back to the start of the header line ending at e->offset */
+    start = e->offset > MAX_SEQ_LINE - 1 ? e->offset - (MAX_SEQ_LINE - 1) : 0;
+    if (fseeko(fp, start, SEEK_SET))
+	return 0;
+    len = fread(line, 1, e->offset - start, fp);
+    if (len != (size_t)(e->offset - start) || len == 0)
+	return 0;
+    line[len] = 0;
+
+    /* only a header at the end of the file may lack a newline */
+    if (line[len-1] == '\n')
+	line[--len] = 0;
+    else if (e->offset != idx->size)
+	return 0;
+    if (len && line[len-1] == '\r')
+	line[--len] = 0;
+
+    if (NULL != (cp = strrchr(line, '\n')))
+	cp++;
+    else if (start == 0)
+	cp = line;
+    else
+	return 0;
+
+    return '>' == *cp && 0 == seq_index_name(cp, 1, name) &&
+	0 == strcmp(name, e->name);
+}
+
+/*
+ * Reads the sequence of an indexed FASTA entry.
+ * Returns 0 for success,
+ *         1 if the sequence was not where the index said,
+ *        -1 for failure.
+ */
+static int get_fasta_indexed_seq(char **seq, int *seq_len, FILE *fp,
+				 seq_index_entry *e) {
+    char line[MAX_SEQ_LINE];
+    int buf_size = 0;
+    size_t nbytes, n, i, j;
+    char *buf;
+    int c;
+
+    *seq_len = 0;
+    if (fseeko(fp, e->offset, SEEK_SET))
+	return -1;
+
+    if (!e->line_bases) {
+	while (fgets(line, sizeof(line), fp) != NULL && '>' != line[0])
+	    write_sequence(line, seq, seq_len, &buf_size);
+	return 0;
+    }
+
+    /* read the lines straight into place and squeeze out the line ends */
+    nbytes = (size_t)seq_index_span(e);
+    if (NULL == (buf = (char *)xrealloc(*seq, nbytes + 1)))
+	return -1;
+    *seq = buf;
+
+    if (nbytes != (n = fread(buf, 1, nbytes, fp)))
+	return 1;
+    for (i = j = 0; i < n; i++) {
+	if (isalpha((int)buf[i]) || (int)buf[i] == '-')
+	    buf[j++] = buf[i];
+	else if ('>' == buf[i])
+	    return 1; /* the entry has shrunk */
+    }
+    buf[j] = 0;
+    if (j != (size_t)e->length)
+	return 1;
+
+    /* only blank lines may follow, up to the next entry */
+    while (EOF != (c = getc(fp)) && isspace(c))
+	;
+    if (EOF != c && '>' != c)
+	return 1; /* the entry has grown */
+
+    *seq_len = j;
+
+    return 0;
+}
+
+/*
+ * Uses the index of an EMBL, GenBank or FASTA file to find entry_name.
+ * EMBL and GenBank files are left positioned at the start of the entry
+ * for their format readers. FASTA entries are read into seq and, if
+ * identifier is not NULL, their name into *identifier.
+ *
+ * Returns 1 if the entry has been read,
+ *         0 if fp is ready for the format reader,
+ *        -1 for failure.
+ */
+static int find_seq_entry(char *file_name, FILE *fp, int fmt,
+			  char *entry_name, char **seq, int *seq_len,
+			  char **identifier) {
+    seq_index *idx;
+    seq_index_entry *e;
+    int rescan;
+
+    if (EMBL != fmt && GENBANK != fmt && FASTA != fmt)
+	return 0;
+
+    /* an entry the file disagrees with means the index is stale */
+    for (rescan = 0; ; rescan++) {
+	if (NULL == (idx = seq_index_get(file_name, fp, fmt, rescan)) ||
+	    NULL == (e = seq_index_find(idx, entry_name)))
+	    return fseeko(fp, 0, SEEK_SET) ? -1 : 0;
+
+	if (seq_index_check(idx, fp, fmt, e))
+	    break;
+
+	if (rescan) {
+	    seq_index_destroy(last_index);
+	    last_index = NULL;
+	    return fseeko(fp, 0, SEEK_SET) ? -1 : 0;
+	}
+    }
+
+    if (FASTA != fmt)
+	return fseeko(fp, e->offset, SEEK_SET) ? -1 : 0;
+
+    switch (get_fasta_indexed_seq(seq, seq_len, fp, e)) {
+    case -1:
+	return -1;
+
+    case 1:
+	/* a stale index; forget it and read the file from the start */
+	seq_index_destroy(last_index);
+	last_index = NULL;
+	*seq_len = 0;
+	return fseeko(fp, 0, SEEK_SET) ? -1 : 0;
+    }
+
+    if (identifier) {
+	if (NULL == (*identifier = (char *)xmalloc(MAX_SEQ_LINE)))
+	    return -1;
+	strcpy(*identifier, entry_name);
+    }
+    return 1;
+}
+
 /* modified for reading feature tables */
 int get_seq ( char **seq, int max_len, int *seq_len, char *file_name, char *entry_name_in)
 
@@ -976,7 +1610,7 @@ int get_seq ( char **seq, int max_len, int *seq_len, char *file_name, char *entr
 
     char entry_name[256];
     FILE *file_ptr;
-    int fmt;
+    int fmt, found = 0;
 
     entry_name[0] = '\0';
     if ( entry_name_in && entry_name_in[0] ) {
@@ -992,7 +1626,18 @@ int get_seq ( char **seq, int max_len, int *seq_len, char *file_name, char *entr
 
 	    if (fseeko ( file_ptr, 0, SEEK_SET ) ) return 4;
 
-	    if ( STADEN == fmt ) {
+	    /* go straight to the entry if there is one */
+	    if ( *entry_name &&
+		 -1 == (found = find_seq_entry ( file_name, file_ptr, fmt,
+						 entry_name, seq, seq_len,
+						 NULL )) ) {
+		fclose ( file_ptr );
+		return 4;
+	    }
+
+	    if ( found )
+		; /* already read */
+	    else if ( STADEN == fmt ) {
 		(void) get_staden_format_seq (seq, max_len, seq_len, file_ptr );
 		/* for this catchall, default format we had better check what weve
 		   got looks like a dna or protein sequence! */
@@ -1082,6 +1727,24 @@ int get_seq_ft (Featcds **key_index,  char **seq, int max_len, int *seq_len, cha
 
 
 
+    /* Go straight to the entry if there is one */
+    if( *entry_name )
+    {
+	switch( find_seq_entry(file_name, file_ptr, fmt, entry_name,
+			       seq, seq_len, identifier) )
+	{
+	    case -1:
+		fclose( file_ptr );
+		return 4;
+
+	    case 1:
+		fclose( file_ptr );
+		return 0;
+	}
+    }
+
+
+
     /* Read file */
     switch( fmt )
     {
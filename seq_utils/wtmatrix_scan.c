@@ -0,0 +1,295 @@
+/*
+ * Weight matrix scanning.
+ *
+ * The matrix is expanded into a table indexed directly by sequence
+ * character so that scoring a column is a single lookup. Positions that
+ * survive to the end of the matrix are rescored left to right so that
+ * the reported scores, and hence which positions pass the cutoff, are
+ * exactly those of a plain sum over the columns in order.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "xalloc.h"
+#include "dna_utils.h"
+#include "wtmatrix_scan.h"
+
+/* Number of columns scored between dropping positions from a block */
+#define WTM_STEP 4
+
+wtm_scanner *wtm_scanner_create(double *matrix, int length, int depth,
+				double min, int strands) {
+    wtm_scanner *s;
+    int i, c;
+
+    /* Every character's code must index a row, as in a plain scan */
+    if (length <= 0 || depth < char_set_size)
+	return NULL;
+
+    if (NULL == (s = (wtm_scanner *)xcalloc(1, sizeof(wtm_scanner))))
+	return NULL;
+
+    s->length = length;
+    s->min = min;
+    s->strands = strands;
+    s->tab = (double *)xmalloc(length * 256 * sizeof(double));
+    s->rc_tab = (double *)xmalloc(length * 256 * sizeof(double));
+    s->otab = (double *)xmalloc(length * 256 * sizeof(double));
+    s->rc_otab = (double *)xmalloc(length * 256 * sizeof(double));
+    s->order = (int *)xmalloc(length * sizeof(int));
+    s->rc_order = (int *)xmalloc(length * sizeof(int));
+    s->need = (double *)xmalloc(length * sizeof(double));
+    s->test = (int *)xmalloc(length * sizeof(int));
+    s->score = (double *)xmalloc(WTM_BLOCK * sizeof(double));
+    s->block_pos = (int *)xmalloc(WTM_BLOCK * sizeof(int));
+    if (!s->tab || !s->rc_tab || !s->otab || !s->rc_otab ||
+	!s->order || !s->rc_order || !s->need || !s->test ||
+	!s->score || !s->block_pos) {
+	wtm_scanner_destroy(s);
+	return NULL;
+    }
+
+    for (i = 0; i < length; i++) {
+	for (c = 0; c < 256; c++)
+	    s->tab[i * 256 + c] = matrix[char_lookup[c] * length + i];
+    }
+
+    return s;
+}
+
+void wtm_scanner_destroy(wtm_scanner *s) {
+    if (!s)
+	return;
+
+    if (s->tab)       xfree(s->tab);
+    if (s->rc_tab)    xfree(s->rc_tab);
+    if (s->otab)      xfree(s->otab);
+    if (s->rc_otab)   xfree(s->rc_otab);
+    if (s->order)     xfree(s->order);
+    if (s->rc_order)  xfree(s->rc_order);
+    if (s->need)      xfree(s->need);
+    if (s->test)      xfree(s->test);
+    if (s->score)     xfree(s->score);
+    if (s->block_pos) xfree(s->block_pos);
+    xfree(s);
+}
+
+void wtm_scanner_conserve(wtm_scanner *s, int col, int code) {
+    int c;
+
+    if (col < 0 || col >= s->length)
+	return;
+
+    for (c = 0; c < 256; c++) {
+	if (char_match[c] >= unknown_char || char_match[c] != code)
+	    s->tab[col * 256 + c] = -HUGE_VAL;
+    }
+    s->nconserved++;
+    s->prepared = 0;
+}
+
+/*
+ * Works out the column order, where to drop positions and the reverse
+ * strand tables.
+ * Returns 0 for success, -1 for failure.
+ */
+static int wtm_prepare(wtm_scanner *s) {
+    int L = s->length;
+    double *spread = (double *)xmalloc(L * sizeof(double));
+    double *best = (double *)xmalloc(L * sizeof(double));
+    int i, j, c, n, t;
+    double sum, rest, cutoff;
+
+    if (!spread || !best) {
+	if (spread) xfree(spread);
+	if (best)   xfree(best);
+	return -1;
+    }
+
+    for (i = 0; i < L; i++) {
+	double *col = &s->tab[i * 256];
+
+	best[i] = -HUGE_VAL;
+	for (n = 0, sum = 0, c = 0; c < 256; c++) {
+	    if (col[c] > best[i])
+		best[i] = col[c];
+	    if (char_lookup[c] < unknown_char) {
+		sum += col[c];
+		n++;
+	    }
+	}
+	spread[i] = n ? best[i] - sum / n : 0;
+	s->order[i] = i;
+    }
+
+    /*
+     * Most discriminating columns first, which puts any conserved columns
+     * at the front. There are few columns so sort simply.
+     */
+    for (i = 1; i < L; i++) {
+	t = s->order[i];
+	for (j = i; j > 0 && spread[s->order[j-1]] < spread[t]; j--)
+	    s->order[j] = s->order[j-1];
+	s->order[j] = t;
+    }
+
+    /*
+     * A position is dropped once its score so far plus the best possible
+     * score of the remaining columns falls below the cutoff, which is
+     * lowered slightly to allow for rounding. Dropping costs about as
+     * much as scoring a column, so is done after each conserved column
+     * and then every WTM_STEP columns.
+     */
+    for (rest = 0, i = 0; i < L; i++)
+	rest += fabs(best[i]);
+    cutoff = s->min - 1e-9 * (1 + fabs(s->min) + rest);
+    for (rest = 0, i = L - 1; i >= 0; i--) {
+	s->need[i] = cutoff - rest;
+	rest += best[s->order[i]];
+	s->test[i] = i < s->nconserved || i == L - 1 ||
+	    (i + 1 - s->nconserved) % WTM_STEP == 0;
+    }
+
+    /* column j of the reverse strand is column L-1-j complemented */
+    for (j = 0; j < L; j++) {
+	for (c = 0; c < 256; c++)
+	    s->rc_tab[j * 256 + c] =
+		s->tab[(L - 1 - j) * 256 + complementary_base[c]];
+	s->rc_order[j] = L - 1 - s->order[j];
+    }
+
+    for (i = 0; i < L; i++) {
+	for (c = 0; c < 256; c++) {
+	    s->otab[i * 256 + c]    = s->tab[s->order[i] * 256 + c];
+	    s->rc_otab[i * 256 + c] = s->rc_tab[s->rc_order[i] * 256 + c];
+	}
+    }
+
+    xfree(spread);
+    xfree(best);
+    s->prepared = 1;
+    return 0;
+}
+
+/*
+ * Scores the nb positions starting at seq on one strand, leaving those
+ * which may reach the cutoff in s->block_pos (as offsets from seq).
+ * Returns the number left.
+ */
+static int wtm_score_block(wtm_scanner *s, double *otab, int *order,
+			   unsigned char *seq, int nb) {
+    double *score = s->score;
+    int *pos = s->block_pos;
+    int i, k, n, m;
+
+    for (i = 0; i < nb; i++) {
+	pos[i] = i;
+	score[i] = 0;
+    }
+
+    for (n = nb, k = 0; k < s->length && n; k++) {
+	double *t = &otab[k * 256];
+	unsigned char *q = seq + order[k];
+
+	for (i = 0; i < n; i++)
+	    score[i] += t[q[pos[i]]];
+
+	if (s->test[k]) {
+	    double need = s->need[k];
+
+	    for (m = i = 0; i < n; i++) {
+		pos[m] = pos[i];
+		score[m] = score[i];
+		m += score[i] >= need;
+	    }
+	    n = m;
+	}
+    }
+
+    return n;
+}
+
+/*
+ * Appends a match to *hits, growing it as needed.
+ * Returns 0 for success, -1 for failure.
+ */
+static int wtm_add_hit(wtm_hit **hits, int *max_hits, int n,
+		       int pos, int strand, double score) {
+    if (n == *max_hits) {
+	int new_max = *max_hits ? *max_hits * 2 : 1000;
+	wtm_hit *h = (wtm_hit *)xrealloc(*hits, new_max * sizeof(wtm_hit));
+	if (!h)
+	    return -1;
+	*hits = h;
+	*max_hits = new_max;
+    }
+
+    (*hits)[n].pos = pos;
+    (*hits)[n].strand = strand;
+    (*hits)[n].score = score;
+    return 0;
+}
+
+int wtm_scan(wtm_scanner *s, char *seq, int start, int end,
+	     wtm_hit **hits, int *max_hits) {
+    unsigned char *useq = (unsigned char *)seq;
+    int L = s->length;
+    int b, nb, last, n = 0, i, k, p, strand, nleft;
+    double *tab;
+    double sc;
+
+    if (!s->prepared && -1 == wtm_prepare(s))
+	return -1;
+
+    last = end - L + 1;
+    for (b = start; b <= last; b += WTM_BLOCK) {
+	int first_hit = n;
+
+	nb = last - b + 1 < WTM_BLOCK ? last - b + 1 : WTM_BLOCK;
+
+	for (strand = WTM_FORWARD; strand <= WTM_REVERSE; strand <<= 1) {
+	    int strand_first = n;
+
+	    if (!(s->strands & strand))
+		continue;
+
+	    if (strand == WTM_FORWARD) {
+		nleft = wtm_score_block(s, s->otab, s->order, &useq[b], nb);
+		tab = s->tab;
+	    } else {
+		nleft = wtm_score_block(s, s->rc_otab, s->rc_order,
+					&useq[b], nb);
+		tab = s->rc_tab;
+	    }
+
+	    /* rescore in column order to get exactly the usual sum */
+	    for (i = 0; i < nleft; i++) {
+		p = b + s->block_pos[i];
+		for (sc = 0, k = 0; k < L; k++)
+		    sc += tab[k * 256 + useq[p + k]];
+		if (sc < s->min)
+		    continue;
+
+		if (-1 == wtm_add_hit(hits, max_hits, n, p, strand, sc))
+		    return -1;
+		n++;
+	    }
+
+	    /* merge the strands back into position order */
+	    if (strand == WTM_REVERSE && strand_first > first_hit) {
+		wtm_hit *h = *hits, tmp;
+		int j;
+
+		for (i = strand_first; i < n; i++) {
+		    tmp = h[i];
+		    for (j = i; j > first_hit && h[j-1].pos > tmp.pos; j--)
+			h[j] = h[j-1];
+		    h[j] = tmp;
+		}
+	    }
+	}
+    }
+
+    return n;
+}
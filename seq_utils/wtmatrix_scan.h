@@ -0,0 +1,77 @@
+#ifndef _WTMATRIX_SCAN_H_
+#define _WTMATRIX_SCAN_H_
+
+/* Strands to scan, for wtm_scanner_create */
+#define WTM_FORWARD 1
+#define WTM_REVERSE 2
+
+/* Number of positions scored together */
+#define WTM_BLOCK 1024
+
+typedef struct {
+    int pos;			/* left end of the match, 0 based */
+    int strand;			/* WTM_FORWARD or WTM_REVERSE */
+    double score;
+} wtm_hit;
+
+/*
+ * A weight matrix prepared for scanning.
+ *
+ * Positions are scored a block at a time, one matrix column at a time
+ * across the whole block, with the columns taken most informative first.
+ * Every few columns the positions which can no longer reach the cutoff,
+ * even scoring the best for all the remaining columns, are dropped from
+ * the block. The inner loops have no data dependent branches, so they
+ * run at close to one table lookup per cycle.
+ */
+typedef struct {
+    int length;			/* number of columns */
+    double min;			/* cutoff score */
+    int strands;		/* WTM_FORWARD and/or WTM_REVERSE */
+    double *tab;		/* length*256 scores indexed by column, char */
+    double *rc_tab;		/* the same for the reverse complement */
+    int *order;			/* columns in the order they are scored */
+    int *rc_order;
+    double *otab;		/* tab and rc_tab rows in scoring order */
+    double *rc_otab;
+    double *need;		/* least score of order[0..i] worth going on */
+    int *test;			/* whether to drop positions after order[i] */
+    int nconserved;		/* number of conserved columns */
+    int prepared;
+    double *score;		/* WTM_BLOCK scores and positions in block */
+    int *block_pos;
+} wtm_scanner;
+
+/*
+ * Creates a scanner for a weight matrix of 'length' columns and 'depth'
+ * rows, stored as matrix[char_lookup[base] * length + column]. Positions
+ * scoring at least 'min' are reported. Requires the character set to
+ * have been set up with set_char_set(), and 'depth' to be at least
+ * char_set_size so that every base has a row.
+ *
+ * Returns the scanner, or NULL on failure.
+ */
+wtm_scanner *wtm_scanner_create(double *matrix, int length, int depth,
+				double min, int strands);
+
+void wtm_scanner_destroy(wtm_scanner *s);
+
+/*
+ * Only reports matches with a symbol matching 'code' (as given by
+ * char_match) at column 'col'.
+ */
+void wtm_scanner_conserve(wtm_scanner *s, int col, int code);
+
+/*
+ * Scores every position of seq from start to end inclusive (0 based) at
+ * which the matrix fits, on each of the scanner's strands. Matches are
+ * stored in *hits, which is grown with xrealloc as needed and *max_hits
+ * updated; both may be reused between calls and the caller should xfree
+ * *hits when done.
+ *
+ * Returns the number of matches, in order of position, or -1 for failure.
+ */
+int wtm_scan(wtm_scanner *s, char *seq, int start, int end,
+	     wtm_hit **hits, int *max_hits);
+
+#endif
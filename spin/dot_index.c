@@ -0,0 +1,167 @@
+#include <stdlib.h>
+
+#include "xalloc.h"
+#include "dot_index.h"
+
+/* The grid is at most this many tiles in each direction */
+#define DOT_INDEX_TILES 256
+
+/* Largest pixel grid used for thinning the matches */
+#define DOT_INDEX_MAX_PIXELS (4096 * 4096)
+
+dot_index *dot_index_create(pt_score *p_array, int n_pts, int lines)
+{
+    dot_index *di;
+    int i, t, tx, ty, x1, y1;
+
+    if (n_pts <= 0)
+	return NULL;
+
+    if (NULL == (di = (dot_index *)xmalloc(sizeof(dot_index))))
+	return NULL;
+
+    di->x0 = x1 = p_array[0].x;
+    di->y0 = y1 = p_array[0].y;
+    di->max_len = 0;
+    for (i = 1; i < n_pts; i++) {
+	if (p_array[i].x < di->x0) di->x0 = p_array[i].x;
+	if (p_array[i].x > x1)     x1     = p_array[i].x;
+	if (p_array[i].y < di->y0) di->y0 = p_array[i].y;
+	if (p_array[i].y > y1)     y1     = p_array[i].y;
+    }
+    if (lines) {
+	for (i = 0; i < n_pts; i++)
+	    if (p_array[i].score > di->max_len)
+		di->max_len = p_array[i].score;
+    }
+
+    for (di->shift = 0;
+	 ((x1 - di->x0) >> di->shift) >= DOT_INDEX_TILES ||
+	 ((y1 - di->y0) >> di->shift) >= DOT_INDEX_TILES;
+	 di->shift++)
+	;
+    di->nx = ((x1 - di->x0) >> di->shift) + 1;
+    di->ny = ((y1 - di->y0) >> di->shift) + 1;
+
+    di->first = (int *)xcalloc(di->nx * di->ny + 1, sizeof(int));
+    di->idx = (int *)xmalloc(n_pts * sizeof(int));
+    if (!di->first || !di->idx) {
+	dot_index_destroy(di);
+	return NULL;
+    }
+
+    /* counting sort of the matches by tile */
+    for (i = 0; i < n_pts; i++) {
+	tx = (p_array[i].x - di->x0) >> di->shift;
+	ty = (p_array[i].y - di->y0) >> di->shift;
+	di->first[ty * di->nx + tx + 1]++;
+    }
+    for (t = 0; t < di->nx * di->ny; t++)
+	di->first[t+1] += di->first[t];
+    for (i = 0; i < n_pts; i++) {
+	tx = (p_array[i].x - di->x0) >> di->shift;
+	ty = (p_array[i].y - di->y0) >> di->shift;
+	di->idx[di->first[ty * di->nx + tx]++] = i;
+    }
+    for (t = di->nx * di->ny; t > 0; t--)
+	di->first[t] = di->first[t-1];
+    di->first[0] = 0;
+
+    return di;
+}
+
+void dot_index_destroy(dot_index *di)
+{
+    if (!di)
+	return;
+
+    if (di->first)
+	xfree(di->first);
+    if (di->idx)
+	xfree(di->idx);
+    xfree(di);
+}
+
+int dot_index_query(dot_index *di, pt_score *p_array,
+		    int x0, int y0, int x1, int y1,
+		    double px_x, double px_y, int **hits)
+{
+    int tx, ty, tx0, ty0, tx1, ty1;
+    int lx0, ly0, len;
+    int i, j, n, max_hits;
+    int pw = 0, ph = 0, px, py;
+    int *best = NULL;
+    pt_score *p;
+
+    *hits = NULL;
+
+    /* lines starting before the region may still cross it */
+    lx0 = di->max_len ? x0 - di->max_len + 1 : x0;
+    ly0 = di->max_len ? y0 - di->max_len + 1 : y0;
+
+    tx0 = (lx0 - di->x0) >> di->shift;
+    ty0 = (ly0 - di->y0) >> di->shift;
+    tx1 = (x1 - di->x0) >> di->shift;
+    ty1 = (y1 - di->y0) >> di->shift;
+    if (x1 < di->x0 || y1 < di->y0 || tx0 >= di->nx || ty0 >= di->ny)
+	return 0;
+    if (lx0 < di->x0) tx0 = 0;
+    if (ly0 < di->y0) ty0 = 0;
+    if (tx1 >= di->nx) tx1 = di->nx - 1;
+    if (ty1 >= di->ny) ty1 = di->ny - 1;
+
+    for (max_hits = 0, ty = ty0; ty <= ty1; ty++)
+	max_hits += di->first[ty * di->nx + tx1 + 1] -
+	    di->first[ty * di->nx + tx0];
+    if (max_hits == 0)
+	return 0;
+    if (NULL == (*hits = (int *)xmalloc(max_hits * sizeof(int))))
+	return -1;
+
+    /* thin out the matches when there is more than one base per pixel */
+    if ((px_x > 0 && px_x < 1) || (px_y > 0 && px_y < 1)) {
+	if (px_x <= 0 || px_x > 1) px_x = 1;
+	if (px_y <= 0 || px_y > 1) px_y = 1;
+	pw = (int)((x1 - x0 + 1) * px_x) + 1;
+	ph = (int)((y1 - y0 + 1) * px_y) + 1;
+	if ((double)pw * ph <= DOT_INDEX_MAX_PIXELS &&
+	    NULL != (best = (int *)xmalloc(pw * ph * sizeof(int)))) {
+	    for (j = 0; j < pw * ph; j++)
+		best[j] = -1;
+	}
+    }
+
+    n = 0;
+    for (ty = ty0; ty <= ty1; ty++) {
+	for (tx = tx0; tx <= tx1; tx++) {
+	    int t = ty * di->nx + tx;
+
+	    for (i = di->first[t]; i < di->first[t+1]; i++) {
+		p = &p_array[di->idx[i]];
+		len = di->max_len ? p->score - 1 : 0;
+
+		if (p->x > x1 || p->y > y1 ||
+		    p->x + len < x0 || p->y + len < y0)
+		    continue;
+
+		if (best && p->x >= x0 && p->y >= y0) {
+		    px = (int)((p->x - x0) * px_x);
+		    py = (int)((p->y - y0) * px_y);
+		    j = best[py * pw + px];
+		    if (j != -1) {
+			if (len && p->score > p_array[(*hits)[j]].score)
+			    (*hits)[j] = di->idx[i];
+			continue;
+		    }
+		    best[py * pw + px] = n;
+		}
+		(*hits)[n++] = di->idx[i];
+	    }
+	}
+    }
+
+    if (best)
+	xfree(best);
+
+    return n;
+}
@@ -0,0 +1,43 @@
+#ifndef _DOT_INDEX_H_
+#define _DOT_INDEX_H_
+
+#include "seq_results.h"
+
+/*
+ * A tiled index of the matches of a dot plot. The matches are bucketed by
+ * their start position into a grid of square tiles so that a redraw only
+ * visits the tiles in view, and dense regions are thinned to about one
+ * match per screen pixel.
+ */
+typedef struct dot_index_ {
+    int x0, y0;		/* position of the first tile */
+    int shift;		/* tiles are (1 << shift) bases square */
+    int nx, ny;		/* number of tiles in each direction */
+    int *first;		/* nx*ny+1 offsets into idx, one per tile */
+    int *idx;		/* p_array indices ordered by tile */
+    int max_len;	/* longest line drawn, 0 when plotting points */
+} dot_index;
+
+/*
+ * Builds the index of p_array[0..n_pts-1]. When lines is set the matches
+ * are drawn as diagonal lines of 'score' bases, otherwise as points.
+ * Returns NULL on failure or when there are no points.
+ */
+dot_index *dot_index_create(pt_score *p_array, int n_pts, int lines);
+
+void dot_index_destroy(dot_index *di);
+
+/*
+ * Finds the matches which may be visible in the region x0..x1, y0..y1
+ * (sequence coordinates), drawn at px_x by px_y pixels per base. Where
+ * there are several bases per pixel only one match is kept for each pixel
+ * (the longest, for lines).
+ *
+ * Returns the number of matches and sets *hits to an xmalloced array of
+ * their p_array indices, or returns -1 on failure.
+ */
+int dot_index_query(dot_index *di, pt_score *p_array,
+		    int x0, int y0, int x1, int y1,
+		    double px_x, double px_y, int **hits);
+
+#endif
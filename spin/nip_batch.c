@@ -0,0 +1,566 @@
+/*
+ * nip_batch: runs a set of the nip sequence searches over every entry of
+ * one or more sequence files without the graphical interface, writing the
+ * results as tab separated text.
+ *
+ * Long sequences are processed a region at a time. Each region is
+ * searched with an overlap on both sides so that matches spanning the
+ * region boundaries are found, and a match is only reported by the region
+ * containing its start (or cut position, for restriction enzymes). This
+ * only matches a search of the whole entry when the overlap covers the
+ * longest feature searched for, so smaller overlaps are rejected. The
+ * one exception is FindMatches() dropping any recognition sequence with
+ * more than MAXMATCHES sites, which is applied to each region in turn.
+ *
+ * Each entry is still loaded whole, and the splice and weight matrix
+ * searches size their results by the entry length. The tRNA, restriction
+ * enzyme and gene search results only cover one region at a time.
+ *
+ * The gene searches (codon preference and author test) give a score for
+ * every codon position in each of the three frames, as the plots do.
+ *
+ * Output columns are: entry, search, position, frame or name, score and
+ * matching sequence.
+ */
+
+#include <staden_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "misc.h"
+#include "getfile.h"
+#include "xalloc.h"
+#include "dna_utils.h"
+#include "genetic_code.h"
+#include "sequence_formats.h"
+#include "renz_utils.h"
+#include "splice_search.h"
+#include "trna_search.h"
+#include "codon_content.h"
+#include "text_output.h"
+
+#define DEFAULT_REGION  1000000
+#define DEFAULT_OVERLAP 1000
+#define MAX_MATRICES    100
+#define DEFAULT_WINDOW  67
+#define DEFAULT_ERROR   0.1
+#define MAX_TRNA_LENGTH 92	/* max_trna_length in trna_search() */
+
+typedef struct {
+    int splice;			/* search for splice junctions */
+    char *ied_file;		/* donor weight matrix */
+    char *eia_file;		/* acceptor weight matrix */
+    int trna;			/* search for tRNAs */
+    char *wts[MAX_MATRICES];	/* weight matrices to search for */
+    int nwts;
+    R_Enz *r_enzyme;		/* restriction enzymes to search for */
+    int num_enzymes;
+    char *codon_pref;		/* codon table for codon preference */
+    double cp_table[4][4][4];
+    char *author;		/* codon table for the author test */
+    double error;		/* author test percentage error */
+    int window;			/* codon preference window, in codons */
+    int region;			/* size of region searched at once */
+    int overlap;		/* extra bases searched either side */
+} batch_opts;
+
+/*
+ * Where the results are written; stdout unless -o is given. Messages,
+ * such as the codon tables listed by the gene searches, go to stderr.
+ */
+static FILE *out;
+
+/*
+ * Prints the weight matrix matches of r whose first base is in the core
+ * region core_start..core_end (1 based).
+ */
+static void print_wt_matches(char *entry, char *search, char *frame,
+			     char *seq, WtmatrixRes *r,
+			     int core_start, int core_end) {
+    int i, left;
+    Wtmatch *m;
+
+    if (!r)
+	return;
+
+    for (i = 0; i < r->number_of_res; i++) {
+	m = r->match[i];
+	left = m->seq - seq + 1;
+	if (left < core_start || left > core_end)
+	    continue;
+
+	fprintf(out, "%s\t%s\t%d\t%s\t%g\t%.*s\n", entry, search,
+		m->pos + 1, frame, m->score, r->length, m->seq);
+    }
+}
+
+static void batch_splice(batch_opts *opts, char *entry, char *seq,
+			 int seq_len, int start, int end,
+			 int core_start, int core_end) {
+    SpliceResults s;
+
+    memset(&s, 0, sizeof(s));
+    if (0 != splice_search(seq, seq_len, start, end,
+			   opts->ied_file, opts->eia_file, &s))
+	return;
+
+    print_wt_matches(entry, "donor",    "1", seq, s.ied_f1,
+		     core_start, core_end);
+    print_wt_matches(entry, "donor",    "2", seq, s.ied_f2,
+		     core_start, core_end);
+    print_wt_matches(entry, "donor",    "3", seq, s.ied_f3,
+		     core_start, core_end);
+    print_wt_matches(entry, "acceptor", "1", seq, s.eia_f1,
+		     core_start, core_end);
+    print_wt_matches(entry, "acceptor", "2", seq, s.eia_f2,
+		     core_start, core_end);
+    print_wt_matches(entry, "acceptor", "3", seq, s.eia_f3,
+		     core_start, core_end);
+
+    free_splice_results2(&s);
+}
+
+static void batch_wtmatrix(batch_opts *opts, char *entry, char *seq,
+			   int seq_len, int start, int end,
+			   int core_start, int core_end) {
+    WtmatrixRes *r;
+    char fn[FILENAME_MAX+1];
+    int i;
+
+    for (i = 0; i < opts->nwts; i++) {
+	if (1 != expandpath(opts->wts[i], fn))
+	    continue;
+
+	r = NULL;
+	if (0 != weight_search(seq, seq_len, start, end, fn, &r) || !r)
+	    continue;
+
+	print_wt_matches(entry, "wtmatrix", opts->wts[i], seq, r,
+			 core_start, core_end);
+	free_WtmatrixRes(r);
+    }
+}
+
+static void batch_trna(char *entry, char *seq, int seq_len,
+		       int start, int end, int core_start, int core_end) {
+    TrnaRes **results;
+    TrnaSpec *t = NULL;
+    int nmatch = 0, max_score = 0;
+    int i;
+
+    if (NULL == (results = (TrnaRes **)xmalloc(MAX_TRNA * sizeof(TrnaRes *))))
+	return;
+
+    trna_search(seq, seq_len, start, end, &results, &nmatch, &max_score, &t);
+
+    for (i = 0; i < nmatch; i++) {
+	TrnaRes *r = results[i];
+
+	if (r->aa_left + 1 < core_start || r->aa_left + 1 > core_end)
+	    continue;
+	if (r->total_cb_score < t->min_total_cb_score)
+	    continue;
+
+	fprintf(out, "%s\ttrna\t%d\t%d\t%d\t%.*s\n", entry,
+		r->aa_left + 1, r->aa_right, r->total_bp_score,
+		r->aa_right - r->aa_left, &seq[r->aa_left]);
+    }
+
+    free_trna_results(results, nmatch);
+    if (t)
+	xfree(t);
+}
+
+static void batch_renz(batch_opts *opts, char *entry, char *seq,
+		       int start, int end, int core_start, int core_end) {
+    R_Match *match;
+    int total_matches = 0;
+    int i, pos;
+
+    if (NULL == (match = (R_Match *)xcalloc(MAXMATCHES, sizeof(R_Match))))
+	return;
+
+    /* the region is searched as a linear sequence in its own right */
+    if (1 == FindMatches(opts->r_enzyme, opts->num_enzymes,
+			 &seq[start-1], end - start + 1, 0,
+			 &match, &total_matches)) {
+	for (i = 0; i < total_matches; i++) {
+	    R_Enz *r = &opts->r_enzyme[match[i].enz_name];
+
+	    pos = start - 1 + match[i].cut_pos;
+	    if (pos < core_start || pos > core_end)
+		continue;
+
+	    fprintf(out, "%s\trenz\t%d\t%s\t-\t%s\n", entry, pos, r->name,
+		    r->seq[match[i].enz_seq]);
+	}
+    }
+
+    xfree(match);
+}
+
+/*
+ * Runs a codon preference or author test, reporting the scores of the
+ * codon positions in the core region.
+ */
+static void batch_gene(char *entry, char *search, char *seq, int seq_len,
+		       double table[4][4][4], int window, int author,
+		       int core_start, int core_end) {
+    CodRes *r;
+    double *frame[3];
+    int start, end, i, f, pos, res;
+
+    /*
+     * Each score only depends on the window around its codon, which may
+     * run outside the range searched, but the last codons of each frame
+     * are special cased, so search a little past the core. Codons are kept
+     * in step with a search of the whole sequence, and the range must hold
+     * a window in the third frame, which starts two bases in.
+     */
+    start = core_start - (core_start - 1) % 3;
+    end   = MIN(seq_len, core_end + 6);
+    if (end - start + 1 < window + 2) {
+	end    = MIN(seq_len, start + window + 1);
+	start  = MAX(1, end - window - 1);
+	start -= (start - 1) % 3;
+	if (end - start + 1 < window + 2)
+	    return;
+    }
+
+    if (NULL == (r = init_CodRes(1 + (end - start + 1) / 3)))
+	return;
+    r->window_length = window;
+    r->user_start = start;
+    r->user_end = end;
+
+    res = author
+	? do_author_test(seq, seq_len, table, r)
+	: do_codon_pref(seq, seq_len, table, r);
+    if (res) {
+	free_CodRes(r);
+	return;
+    }
+
+    frame[0] = r->frame1;
+    frame[1] = r->frame2;
+    frame[2] = r->frame3;
+    for (i = 0; i < r->num_results; i++) {
+	for (f = 0; f < 3; f++) {
+	    pos = start + 3 * i + f;
+	    if (pos < core_start || pos > core_end)
+		continue;
+
+	    fprintf(out, "%s\t%s\t%d\t%d\t%g\t-\n", entry, search,
+		    pos, f + 1, frame[f][i]);
+	}
+    }
+
+    free_CodRes(r);
+}
+
+/*
+ * Runs all of the selected searches over one sequence, a region at a time.
+ */
+static void batch_seq(batch_opts *opts, char *entry, char *seq, int seq_len) {
+    int core_start, core_end, start, end;
+    double at_table[4][4][4];
+    int at_window = 0;
+
+    /* The author test weights depend on the composition of the whole entry */
+    if (opts->author &&
+	init_author_test(opts->author, seq, seq_len, at_table,
+			 opts->error, &at_window)) {
+	fprintf(stderr, "Author test failed for entry '%s'\n", entry);
+	at_window = 0;
+    }
+
+    for (core_start = 1; core_start <= seq_len; core_start += opts->region) {
+	core_end = MIN(seq_len, core_start + opts->region - 1);
+	start    = MAX(1, core_start - opts->overlap);
+	end      = MIN(seq_len, core_end + opts->overlap);
+
+	if (opts->splice)
+	    batch_splice(opts, entry, seq, seq_len, start, end,
+			 core_start, core_end);
+	if (opts->nwts)
+	    batch_wtmatrix(opts, entry, seq, seq_len, start, end,
+			   core_start, core_end);
+	if (opts->trna)
+	    batch_trna(entry, seq, seq_len, start, end,
+		       core_start, core_end);
+	if (opts->num_enzymes)
+	    batch_renz(opts, entry, seq, start, end, core_start, core_end);
+	if (opts->codon_pref)
+	    batch_gene(entry, "codonpref", seq, seq_len, opts->cp_table,
+		       opts->window * 3, 0, core_start, core_end);
+	if (at_window)
+	    batch_gene(entry, "author", seq, seq_len, at_table,
+		       at_window, 1, core_start, core_end);
+
+	fflush(out);
+    }
+}
+
+/*
+ * Processes every entry in a sequence file.
+ * Returns 0 for success, -1 for failure.
+ */
+static int batch_file(batch_opts *opts, char *file) {
+    char **ids = NULL;
+    int nids = 0;
+    int i;
+
+    if (0 != get_identifiers(file, &ids, &nids)) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
+    }
+
+    /* files without entry names hold a single sequence */
+    for (i = 0; i < (nids ? nids : 1); i++) {
+	char *seq = NULL;
+	int seq_len = 0;
+	char *entry = nids ? ids[i] : file;
+
+	if (0 != get_seq(&seq, 100000, &seq_len, file, nids ? ids[i] : NULL) ||
+	    seq_len == 0 || !seq) {
+	    fprintf(stderr, "Failed to read entry '%s' from '%s'\n",
+		    entry, file);
+	    if (seq)
+		xfree(seq);
+	    continue;
+	}
+
+	batch_seq(opts, entry, seq, seq_len);
+	xfree(seq);
+    }
+
+    for (i = 0; i < nids; i++)
+	xfree(ids[i]);
+    if (ids)
+	xfree(ids);
+
+    return 0;
+}
+
+/*
+ * Reads every enzyme from an enzyme file.
+ * Returns 0 for success, -1 for failure.
+ */
+static int batch_read_enzymes(batch_opts *opts, char *file) {
+    char **names = NULL;
+    char *inlist, *cp;
+    int i, n = 0;
+
+    if (opts->r_enzyme)
+	return -1;
+
+    if (1 != r_enz_file_names(file, &names, &n) || n == 0)
+	return -1;
+
+    /* select every enzyme in the file */
+    if (NULL == (inlist = (char *)xmalloc(n * 12 + 1)))
+	return -1;
+    for (cp = inlist, i = 0; i < n; i++)
+	cp += sprintf(cp, "%d ", i);
+
+    for (i = 0; i < n; i++)
+	xfree(names[i]);
+    xfree(names);
+
+    i = open_renz_file(file, inlist, n, &opts->r_enzyme, &opts->num_enzymes);
+    xfree(inlist);
+
+    return i == 1 ? 0 : -1;
+}
+
+/*
+ * Returns the length of the weight matrix in file, or -1 if it can't be
+ * read. Only the header is read; weight_search() reads the rest.
+ */
+static int batch_wts_length(char *file) {
+    char fn[FILENAME_MAX+1];
+    FILE *fp;
+    int len;
+
+    if (1 != expandpath(file, fn) || NULL == (fp = fopen(fn, "r")))
+	return -1;
+
+    /* a title line, then the length, mark position, minimum and maximum */
+    if (1 != fscanf(fp, "%*[^\n]\n%d", &len))
+	len = -1;
+
+    fclose(fp);
+    return len;
+}
+
+/*
+ * Returns the smallest overlap for which searching a region at a time
+ * finds the same features as searching the whole entry, or -1 if a
+ * weight matrix can't be read.
+ */
+static int batch_min_overlap(batch_opts *opts) {
+    int min = 0, len, i, j;
+
+    /* matches are reported by their first base */
+    if (opts->splice) {
+	if (-1 == (len = batch_wts_length(opts->ied_file)))
+	    return -1;
+	min = MAX(min, len - 1);
+	if (-1 == (len = batch_wts_length(opts->eia_file)))
+	    return -1;
+	min = MAX(min, len - 1);
+    }
+    for (i = 0; i < opts->nwts; i++) {
+	if (-1 == (len = batch_wts_length(opts->wts[i])))
+	    return -1;
+	min = MAX(min, len - 1);
+    }
+    if (opts->trna)
+	min = MAX(min, MAX_TRNA_LENGTH - 1);
+
+    /* enzymes are reported by their cut, which may be outside the site */
+    for (i = 0; i < opts->num_enzymes; i++) {
+	R_Enz *r = &opts->r_enzyme[i];
+
+	for (j = 0; j < r->num_seq; j++) {
+	    len = strlen(r->seq[j]);
+	    min = MAX(min, r->cut_site[j]);
+	    min = MAX(min, len - 1 - r->cut_site[j]);
+	}
+    }
+
+    return min;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+	    "Usage: nip_batch [options] filename ...\n"
+	    "    -splice         splice junctions (ied.wts and eia.wts)\n"
+	    "    -ied file       donor weight matrix\n"
+	    "    -eia file       acceptor weight matrix\n"
+	    "    -wts file       weight matrix search (may be repeated)\n"
+	    "    -trna           tRNA search\n"
+	    "    -renz file      all restriction enzymes in file\n"
+	    "    -codonpref file codon preference using codon table file\n"
+	    "    -window codons  codon preference window length (%d)\n"
+	    "    -author file    author test using codon table file\n"
+	    "    -error percent  author test percentage error (%g)\n"
+	    "    -region bases   bases searched at a time (%d)\n"
+	    "    -overlap bases  extra bases searched either side (%d)\n"
+	    "    -o file         write the results to file (stdout)\n"
+	    "\n"
+	    "The overlap must cover the longest feature searched for, and\n"
+	    "smaller overlaps are rejected. Messages, such as the codon tables\n"
+	    "listed by the codon preference and author tests, go to stderr.\n",
+	    DEFAULT_WINDOW, DEFAULT_ERROR, DEFAULT_REGION, DEFAULT_OVERLAP);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    batch_opts opts;
+    char cp_fn[FILENAME_MAX+1], at_fn[FILENAME_MAX+1];
+    char *out_fn = NULL;
+    int min_overlap, ret = 0;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.ied_file = "$STADTABL/ied.wts";
+    opts.eia_file = "$STADTABL/eia.wts";
+    opts.region   = DEFAULT_REGION;
+    opts.overlap  = DEFAULT_OVERLAP;
+    opts.window   = DEFAULT_WINDOW;
+    opts.error    = DEFAULT_ERROR;
+
+    vmessage_stream(stderr);
+    set_char_set(DNA);
+    set_dna_lookup();   /* general lookup and complementing */
+    set_iubc_lookup();  /* iubc codes for restriction enzymes */
+    init_genetic_code();
+
+    for (argc--, argv++; argc > 0; argc--, argv++) {
+	if (**argv != '-')
+	    break;
+
+	if (strcmp(*argv, "-splice") == 0) {
+	    opts.splice = 1;
+	} else if (strcmp(*argv, "-trna") == 0) {
+	    opts.trna = 1;
+	} else if (argc < 2) {
+	    usage();
+	} else if (strcmp(*argv, "-ied") == 0) {
+	    opts.ied_file = *++argv; argc--;
+	} else if (strcmp(*argv, "-eia") == 0) {
+	    opts.eia_file = *++argv; argc--;
+	} else if (strcmp(*argv, "-wts") == 0) {
+	    if (opts.nwts == MAX_MATRICES)
+		usage();
+	    opts.wts[opts.nwts++] = *++argv; argc--;
+	} else if (strcmp(*argv, "-renz") == 0) {
+	    if (-1 == batch_read_enzymes(&opts, *++argv)) {
+		fprintf(stderr, "Failed to read enzyme file '%s'\n", *argv);
+		return 1;
+	    }
+	    argc--;
+	} else if (strcmp(*argv, "-codonpref") == 0) {
+	    /* init_codon_pref() treats a missing table as no table at all */
+	    if (1 != expandpath(*++argv, cp_fn) || access(cp_fn, R_OK))
+		usage();
+	    opts.codon_pref = cp_fn; argc--;
+	} else if (strcmp(*argv, "-window") == 0) {
+	    opts.window = atoi(*++argv); argc--;
+	} else if (strcmp(*argv, "-author") == 0) {
+	    if (1 != expandpath(*++argv, at_fn))
+		usage();
+	    opts.author = at_fn; argc--;
+	} else if (strcmp(*argv, "-error") == 0) {
+	    opts.error = atof(*++argv); argc--;
+	} else if (strcmp(*argv, "-region") == 0) {
+	    opts.region = atoi(*++argv); argc--;
+	} else if (strcmp(*argv, "-overlap") == 0) {
+	    opts.overlap = atoi(*++argv); argc--;
+	} else if (strcmp(*argv, "-o") == 0) {
+	    out_fn = *++argv; argc--;
+	} else {
+	    usage();
+	}
+    }
+
+    if (argc == 0 || opts.region <= 0 || opts.overlap < 0 ||
+	opts.window <= 0 || opts.window % 2 == 0 || opts.error <= 0 ||
+	!(opts.splice || opts.trna || opts.nwts || opts.num_enzymes ||
+	  opts.codon_pref || opts.author))
+	usage();
+
+    if (-1 == (min_overlap = batch_min_overlap(&opts))) {
+	fprintf(stderr, "Failed to read weight matrix\n");
+	return 1;
+    }
+    if (opts.overlap < min_overlap) {
+	fprintf(stderr, "The overlap must be at least %d bases for these "
+		"searches\n", min_overlap);
+	return 1;
+    }
+
+    if (!out_fn) {
+	out = stdout;
+    } else if (NULL == (out = fopen(out_fn, "w"))) {
+	perror(out_fn);
+	return 1;
+    }
+
+    if (opts.codon_pref &&
+	init_codon_pref(opts.codon_pref, opts.cp_table, 0)) {
+	fprintf(stderr, "Failed to read codon table '%s'\n", opts.codon_pref);
+	return 1;
+    }
+
+    for (; argc > 0; argc--, argv++)
+	ret |= batch_file(&opts, *argv);
+
+    if (fclose(out))
+	ret = 1;
+
+    return ret ? 1 : 0;
+}
@@ -29,7 +29,6 @@ void trna_search_shutdown(Tcl_Interp *interp,
     out_raster *output = result->output;
     in_trna_search *input = result->input;
     TrnaRes **results = result->text_data;
-    int i;
     char *tmp;
     seq_reg_key_name info;
     static char buf[80];
@@ -66,10 +65,7 @@ void trna_search_shutdown(Tcl_Interp *interp,
 				  " {", info.line, "}", NULL))
 	    verror(ERR_WARN, "trna search", "shutdown %s \n", Tcl_GetStringResult(interp));
     }
-    for (i = 0; i < MAX_TRNA; i++) {
-	xfree(results[i]);
-    }
-    xfree(results);
+    free_trna_results(results, data->ap_array[0].n_pts);
     xfree(data->ap_array[0].p_array);
     xfree(data->ap_array);
     xfree(result->data);
@@ -348,10 +344,7 @@ int init_nip_trna_search_create(Tcl_Interp *interp,
     if (nmatch == 0) {
 	verror(ERR_WARN, "trna search", "no matches found");
 	
-	for (i = 0; i < MAX_TRNA; i++) {
-	    xfree(results[i]);
-	}
-	xfree(results);
+	free_trna_results(results, nmatch);
 	xfree(t);
 	xfree(input->params);
 	xfree(input);
@@ -5,6 +5,7 @@
 #include "seq_raster.h"
 #include "tkRaster.h"
 #include "text_output.h"
+#include "dot_index.h"
 
 /*
 static int b_compare(const void *p1,
@@ -668,6 +669,53 @@ void stick_plot_func(void *obj, seq_reg_plot *plot)
     }
 }
 
+/*
+ * Finds the matches of a dot plot which may be visible in the raster,
+ * thinned to about one per pixel, building the tile index of the matches
+ * on first use. offset is added to the match positions when plotting and
+ * lines is set when the matches are drawn as lines of 'score' bases.
+ * Returns the number of matches, with their p_array indices in *hits.
+ */
+static int dot_plot_visible(Tk_Raster *raster,
+			    d_plot *data,
+			    int offset,
+			    int lines,
+			    int **hits)
+{
+    double wx0, wy0, wx1, wy1;
+    double vx0, vy0, vx1, vy1;
+    double px_x = 0, px_y = 0;
+    int width, height;
+
+    *hits = NULL;
+    if (!data->index &&
+	!(data->index = dot_index_create(data->p_array, data->n_pts, lines)))
+	return 0;
+
+    RasterGetWorldScroll(raster, &wx0, &wy0, &wx1, &wy1);
+    GetRasterCoords(raster, &vx0, &vy0, &vx1, &vy1);
+    RasterWinSize(raster, &width, &height);
+
+    if (vx1 > vx0 && vy1 > vy0) {
+	px_x = width / (vx1 - vx0);
+	px_y = height / (vy1 - vy0);
+    } else {
+	vx0 = wx0; vy0 = wy0;
+	vx1 = wx1; vy1 = wy1;
+    }
+
+    /*
+     * y is plotted upside down; see rasterY(). The region is not shifted
+     * right by offset as points past the end are plotted at the edge.
+     */
+    return dot_index_query(data->index, data->p_array,
+			   (int)vx0 - offset - 1,
+			   (int)(wy1 - vy1 + wy0) - offset - 1,
+			   (int)vx1 + 1,
+			   (int)(wy1 - vy0 + wy0) + 1,
+			   px_x, px_y, hits);
+}
+
 /* 
  * draws a single dot at the midpt of a line 
  * used in similar spans plot
@@ -677,12 +725,13 @@ void dot_plot_middot_func(void *obj, seq_reg_plot *plot)
     seq_result *result = (seq_result *) obj;
     out_raster *output = result->output;
     d_plot *data = result->data;
-    int num_pts = data->n_pts;
+    int num_pts;
     Tk_Raster *raster;
     Tcl_CmdInfo info;
     double x0, y0, x1, y1;
     int mid_pt;
-    int i;
+    int i, k;
+    int *hits;
     double coords[2]; 
   
     if (output->hidden) {
@@ -694,9 +743,12 @@ void dot_plot_middot_func(void *obj, seq_reg_plot *plot)
 
     RasterGetWorldScroll(raster, &x0, &y0, &x1, &y1);
 
+    mid_pt = (int) (data->win_len / 2);
+    num_pts = dot_plot_visible(raster, data, mid_pt, 0, &hits);
+
     /* ensure pts off the edge are plotted at the edge */
-    for (i = 0; i < num_pts; i++) {
-	mid_pt = (int) (data->win_len / 2);
+    for (k = 0; k < num_pts; k++) {
+	i = hits[k];
 
 	if ((data->p_array[i].x + mid_pt) > x1) {
 	    coords[0] = x1;
@@ -720,6 +772,8 @@ void dot_plot_middot_func(void *obj, seq_reg_plot *plot)
 	RasterDrawPoints(raster, coords, 1);
 
     }
+    if (hits)
+	xfree(hits);
 }
 
 /* 
@@ -730,8 +784,9 @@ void dot_plot_dot_func(void *obj, seq_reg_plot *plot)
     seq_result *result = (seq_result *) obj;
     out_raster *output = result->output;
     d_plot *data = result->data;
-    int num_pts = data->n_pts;
-    int i,j;
+    int num_pts;
+    int i,j,k;
+    int *hits;
     Tk_Raster *raster;
     Tcl_CmdInfo info;
     double wx0, wy0, wx1, wy1;
@@ -746,16 +801,26 @@ void dot_plot_dot_func(void *obj, seq_reg_plot *plot)
     SetDrawEnviron(output->interp, raster, output->env_index);
     RasterGetWorldScroll(raster, &wx0, &wy0, &wx1, &wy1);
 
-    if(!(points = malloc(sizeof(double) * 2 *num_pts))) 
+    /*
+     * Refresh the raster even when there is nothing to draw, so that the
+     * previous contents are not left on screen.
+     */
+    if ((num_pts = dot_plot_visible(raster, data, 0, 0, &hits)) <= 0 ||
+	!(points = malloc(sizeof(double) * 2 *num_pts))) {
+	if (hits)
+	    xfree(hits);
+	tk_RasterRefresh(raster);
 	return;
+    }
   
-    /* draw line from x1, y1 to x1+score-1, y1+score-1 */
-    for (i = 0, j = 0; i < num_pts; i++, j+=2) {
+    for (k = 0, j = 0; k < num_pts; k++, j+=2) {
+	i = hits[k];
 	points[j] = data->p_array[i].x;
 	points[j+1] = rasterY(raster, data->p_array[i].y);
     }
     RasterDrawPoints(raster, points, num_pts);
     free(points);
+    xfree(hits);
     
     tk_RasterRefresh(raster);
 }
@@ -833,8 +898,9 @@ void dot_plot_scoreline_func(void *obj, seq_reg_plot *plot)
     seq_result *result = (seq_result *) obj;
     out_raster *output = result->output;
     d_plot *data = result->data;
-    int num_pts = data->n_pts;
-    int i,j;
+    int num_pts;
+    int i,j,k;
+    int *hits;
     Tk_Raster *raster;
     Tcl_CmdInfo info;
     double wx0, wy0, wx1, wy1;
@@ -849,10 +915,19 @@ void dot_plot_scoreline_func(void *obj, seq_reg_plot *plot)
     SetDrawEnviron(output->interp, raster, output->env_index);
     RasterGetWorldScroll(raster, &wx0, &wy0, &wx1, &wy1);
 
+    /* as in dot_plot_dot_func, refresh even when there is nothing to draw */
+    if ((num_pts = dot_plot_visible(raster, data, 0, 1, &hits)) <= 0) {
+	if (hits)
+	    xfree(hits);
+	tk_RasterRefresh(raster);
+	return;
+    }
+
 /* 29/1/99 johnt - use RasterDrawSegments for performance on WINNT */
 #ifdef USE_DRAW_LINE
     /* draw line from x1, y1 to x1+score-1, y1+score-1 */
-    for (i = 0; i < num_pts; i++) {
+    for (k = 0; k < num_pts; k++) {
+	i = hits[k];
 	RasterDrawLine(raster, data->p_array[i].x, 
 		       rasterY(raster, data->p_array[i].y),
 		       data->p_array[i].x + (data->p_array[i].score - 1), 
@@ -861,7 +936,8 @@ void dot_plot_scoreline_func(void *obj, seq_reg_plot *plot)
     }
 #else
     points = malloc(sizeof(double) * num_pts * 4);
-    for(i = 0, j = 0; i < num_pts; i++){
+    for(k = 0, j = 0; k < num_pts; k++){
+	i = hits[k];
 	points[j++] = data->p_array[i].x;
 	points[j++] = rasterY(raster, data->p_array[i].y);
 	points[j++] = data->p_array[i].x + (data->p_array[i].score - 1);
@@ -871,5 +947,6 @@ void dot_plot_scoreline_func(void *obj, seq_reg_plot *plot)
     RasterDrawSegments(raster, points, num_pts);
     free(points);
 #endif
+    xfree(hits);
     tk_RasterRefresh(raster);
 }
@@ -129,6 +129,7 @@ typedef struct d_plot_ {
     int n_pts;
     d_line dim;
     int win_len;
+    struct dot_index_ *index;	/* built when first plotted; see dot_index.h */
 } d_plot;
 
 /* emboss graph structure */
@@ -93,6 +93,7 @@
 
 #include   <stdio.h>
 #include   <ctype.h>
+#include   <string.h>
 
 #include "sip_sim.h"
 
@@ -101,6 +102,7 @@ int locate( char A[], char B[], long nseq);
 int small_pass(  char A[], char B[], long count, long nseq);
 long addnode(long c, long ci, long cj, long i, long j, long K, long cost);
 int no_cross( void );
+static void free_sim_globals(long M, long K);
 void fatal(char *msg);
 void fatalf(char *msg, char *val);
 /*static FILE *ckopen(char *name, char *mode);*/
@@ -339,6 +341,8 @@ static vertexptr  *LIST;			/* an array for saving k best scores */
 static vertexptr  low = 0;			/* lowest score node in LIST */
 static vertexptr  most = 0;			/* latestly accessed node in LIST */
 static long numnode;			/* the number of nodes in LIST */
+static vertexptr *NODES;		/* LIST[0..numnode-1] hashed on start */
+static unsigned long nodemask;		/* size of NODES - 1 */
 
 static long *CC, *DD;			/* saving matrix scores */
 static long *RR, *SS, *EE, *FF; 	/* saving start-points */
@@ -490,6 +494,11 @@ long SIM(char *A,
 	LIST = ( vertexptr * ) ckalloc( K * sizeof(vertexptr));
 	for ( i = 0; i < K ; i++ )
 	   LIST[i] = ( vertexptr ) ckalloc( (long) sizeof(vertex));
+	for ( nodemask = 1; nodemask < 2 * K; nodemask <<= 1 )
+	  ;
+	NODES = ( vertexptr * ) ckalloc( nodemask * sizeof(vertexptr));
+	memset(NODES, 0, nodemask * sizeof(vertexptr));
+	nodemask--;
 
 #if 0
 	printf("s {\n  \"%s\" 1 %d\n  \"%s\" 1 %d\n}\n", name1, M, name2, N);
@@ -507,14 +516,17 @@ long SIM(char *A,
 	  { if ( numnode == 0 ) {
 	      verror(ERR_WARN, "local alignment", 
 		     "The number of alignments computed is too large");
+	      free_sim_globals(M, K);
 	      return -1;
 	  }
             cur = findmax();	/* Return a pointer to a node with max score*/
             score = cur->SCORE;
 	    
 	    /* if searching for all alignments above a certain score */
-	    if (score_align > -1 && (score/10.0) < score_align)
+	    if (score_align > -1 && (score/10.0) < score_align) {
+		free_sim_globals(M, K);
 		return (K-count-1);
+	    }
 
       	    stari = ++cur->STARI;
             starj = ++cur->STARJ;
@@ -556,9 +568,33 @@ long SIM(char *A,
 		   small_pass(A,B,count,nseq);
               }
 	  }
+	free_sim_globals(M, K);
 	return K;
 }
 
+/* Release the space allocated by SIM */
+static void free_sim_globals(long M, long K)
+{ register long i;
+  pairptr y;
+
+  ckfree((char *)CC); ckfree((char *)DD); ckfree((char *)RR);
+  ckfree((char *)SS); ckfree((char *)EE); ckfree((char *)FF);
+  ckfree((char *)HH); ckfree((char *)WW); ckfree((char *)II);
+  ckfree((char *)JJ); ckfree((char *)XX); ckfree((char *)YY);
+
+  for ( i = 1; i <= M; i++ )
+    for ( z = row[i]; z != 0; z = y )
+      { y = z->NEXT;
+	ckfree((char *)z);
+      }
+  ckfree((char *)row);
+
+  for ( i = 0; i < K; i++ )
+    ckfree((char *)LIST[i]);
+  ckfree((char *)LIST);
+  ckfree((char *)NODES);
+}
+
 /* A big pass to compute K best classes */
 
 int big_pass(A,B,M,N,K,nseq) char A[],B[]; long M,N,K,nseq;
@@ -616,8 +652,8 @@ int big_pass(A,B,M,N,K,nseq) char A[],B[]; long M,N,K,nseq;
 		  di = SS[j];
 		  dj = FF[j];
 		  ORDER(d, di, dj, c, ci, cj)
-		  c = 0;
-		  DIAG(i, j, c, p+va[B[j]])		/* diagonal */
+		  /* diagonal; no pairs are reported yet, so no DIAG test */
+		  c = p+va[B[j]];
 		  if ( c <= 0 )
 		    { c = 0; ci = i; cj = j; }
 		  else
@@ -940,23 +976,64 @@ int small_pass(A,B,count,nseq) char A[], B[]; long count, nseq;
 	return 0;
 }
 
+/* Hash table of the nodes in LIST, keyed on their start point, so that
+   addnode() need not search the whole of LIST for every score above min.
+   Open addressing with linear probing; NODES has at least 2K slots.     */
+
+#define NODE_HASH(ci, cj) \
+  ((((unsigned long)(ci) * 2654435761UL) ^ (unsigned long)(cj)) & nodemask)
+
+static vertexptr node_find(long ci, long cj)
+{ register unsigned long h;
+  register vertexptr n;
+
+  for ( h = NODE_HASH(ci, cj); (n = NODES[h]) != 0; h = (h + 1) & nodemask )
+    if ( n->STARI == ci && n->STARJ == cj )
+      return n;
+  return 0;
+}
+
+static void node_insert(vertexptr n)
+{ register unsigned long h;
+
+  for ( h = NODE_HASH(n->STARI, n->STARJ); NODES[h]; h = (h + 1) & nodemask )
+    ;
+  NODES[h] = n;
+}
+
+static void node_delete(vertexptr n)
+{ register unsigned long h, e, k;
+
+  for ( h = NODE_HASH(n->STARI, n->STARJ); NODES[h] != n;
+	h = (h + 1) & nodemask )
+    ;
+
+  /* Shift back any later members of the probe sequence */
+  for ( e = h, h = (h + 1) & nodemask; NODES[h]; h = (h + 1) & nodemask )
+    { k = NODE_HASH(NODES[h]->STARI, NODES[h]->STARJ);
+      if ( ( h > e && ( k <= e || k > h ) ) ||
+	   ( h < e && ( k <= e && k > h ) ) )
+	{ NODES[e] = NODES[h];
+	  e = h;
+	}
+    }
+  NODES[e] = 0;
+}
+
 /* Add a new node into list.  */
 
 long addnode(c, ci, cj, i, j, K, cost)  long c, ci, cj, i, j, K, cost;
 { short found;				/* 1 if the node is in LIST */
   register long d;
+  vertexptr cur;
 
   found = 0;
   if ( most != 0 && most->STARI == ci && most->STARJ == cj )
     found = 1;
-  else
-     for ( d = 0; d < numnode ; d++ )
-	{ most = LIST[d];
-	  if ( most->STARI == ci && most->STARJ == cj )
-	    { found = 1;
-	      break;
-	    }
-        }
+  else if ( ( cur = node_find(ci, cj) ) != 0 )
+    { most = cur;
+      found = 1;
+    }
   if ( found )
     { if ( most->SCORE < c )
         { most->SCORE = c;
@@ -970,12 +1047,15 @@ long addnode(c, ci, cj, i, j, K, cost)  long c, ci, cj, i, j, K, cost;
     }
   else
     { if ( numnode == K )	/* list full */
-	 most = low;
+	{ most = low;
+	  node_delete(most);
+	}
       else
          most = LIST[numnode++];
       most->SCORE = c;
       most->STARI = ci;
       most->STARJ = cj;
+      node_insert(most);
       most->ENDI = i;
       most->ENDJ = j;
       most->TOP = most->BOT = i;
@@ -1003,6 +1083,7 @@ vertexptr findmax(void)
     if ( LIST[i]->SCORE > LIST[j]->SCORE )
        j = i;
   cur = LIST[j];
+  node_delete(cur);
   if ( j != --numnode )
     { LIST[j] = LIST[numnode];
       LIST[numnode] =  cur;
@@ -291,6 +291,7 @@ int store_align(int seq1_num,
 
     if (NULL == (data = (d_plot *)xmalloc(sizeof(d_plot))))
 	return -1;
+    data->index = NULL;
     
     if (NULL == (data->p_array = (pt_score *)xmalloc(sizeof(pt_score) * 
 						     num_elements)))
@@ -465,6 +465,7 @@ int store_matching_words(int seq1_num,
 
     if (NULL == (data = (d_plot *)xmalloc(sizeof(d_plot))))
 	return -1;
+    data->index = NULL;
     
     if (NULL == (text_data = (text_find_identities *)xmalloc(sizeof(text_find_identities))))
 	return -1;
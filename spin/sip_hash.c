@@ -335,7 +335,11 @@ sip_realloc_matches (int **seq1_match,
 {
     int increment = 1000;
 
-    *max_matches += increment;
+    /* grow by half again so that collecting n matches is O(n) overall */
+    if (*max_matches < 2 * increment)
+	*max_matches += increment;
+    else
+	*max_matches += *max_matches / 2;
 
     if (NULL == (*seq1_match = (int *)xrealloc(*seq1_match, 
 					      *max_matches * sizeof(int)))) {
@@ -443,6 +443,7 @@ int store_quick_scan(int seq1_num,
 
     if (NULL == (data = (d_plot *)xmalloc(sizeof(d_plot))))
 	return -1;
+    data->index = NULL;
 
     if (save_results) {
 	if (NULL == (data->p_array = (pt_score *)xmalloc(sizeof(pt_score) * 
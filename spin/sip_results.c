@@ -15,6 +15,7 @@
 #include "probs.h"
 #include "dna_utils.h"
 #include "readpam.h"
+#include "dot_index.h"
 
 
 static void free_mat_name(mat_name *mat);
@@ -510,6 +511,7 @@ void SipFreeResult(seq_result *result) {
 	out_raster *output = result->output;
 
 	xfree(data->p_array);
+	dot_index_destroy(data->index);
 	xfree(data);
 	free(output->name);
 
@@ -678,6 +678,7 @@ int init_sip_local_align_create(Tcl_Interp *interp,
     num_elements = (seq1_len + seq2_len + 1) * num_align;
     if (NULL == (data = (d_plot *)xmalloc(sizeof(d_plot))))
 	goto error;
+    data->index = NULL;
     
     if (NULL == (data->p_array = (pt_score *)xmalloc(sizeof(pt_score) * 
 						     num_elements)))
@@ -434,6 +434,7 @@ int store_sip_similar_spans(int seq1_num,
 
     if (NULL == (data = (d_plot *)xmalloc(sizeof(d_plot))))
 	return -1;
+    data->index = NULL;
     
     if (NULL == (data->p_array = (pt_score *)xmalloc(sizeof(pt_score) * 
 						     num_elements)))
@@ -13,6 +13,7 @@
 #include "splice_search.h"
 #include "dna_utils.h"
 #include "getfile.h"
+#include "wtmatrix_scan.h"
 
 /* 7/1/99 johnt - need to explicitly import globals from dlls in Visual C++ */
 #ifdef _MSC_VER
@@ -306,64 +307,68 @@ int do_mask_match ( char *seq, int seq_len, int user_start, int user_end, MatchM
     return 0;
 }
 
-int do_wt_search_cs ( char seq[], int seq_length, int user_start, int user_end,
-		  WtmatrixSpec *w, MatchMask *c, WtmatrixRes *r ) {
-
-    int start, end, max_start, left_start, num_res, matrix_pos, seq_pos, match_pos;
-    double score;
+/*
+ * Scans seq from user_start to user_end with weight matrix w, storing the
+ * matches in r. When c is non NULL its 100% conserved symbols must also
+ * match.
+ */
+static int do_wt_scan ( char seq[], int user_start, int user_end,
+			WtmatrixSpec *w, MatchMask *c, WtmatrixRes *r ) {
+
+    wtm_scanner *s;
+    wtm_hit *hits = NULL;
+    int max_hits = 0, num_res, i;
     Wtmatch *m;
 
-    start = user_start - 1;
-    end   = user_end - 1;
-
-    /* loop for all matrix left starts. Note the matrix is stored in a vector length*depth */
-
-    max_start = end - ( w->length - 1 );
-
-    for ( left_start = start, num_res = 0; left_start <= max_start; left_start++ ) {
-
-	/* loop for the matrix length */
-
-	if ( (match_pos = mask_match ( seq, end, left_start, c )) <= max_start ) {
-	    left_start = match_pos;
-	    for ( matrix_pos = 0, seq_pos = left_start, score = 0.0; 
-		 matrix_pos < w->length && seq_pos < user_end; matrix_pos++, seq_pos++ ) {
-
-		score += w->matrix [ char_lookup [ seq [ seq_pos ]] * (w->length) + matrix_pos ];
-	    }
-	    if ( score >= w->min ) {
-
-		if ( ( NULL == ( m = (Wtmatch* ) xmalloc ( sizeof (Wtmatch ) )))) return -3;
-		m->pos = left_start + w->mark_pos;
-		m->score = score;
-		m->seq = &seq[left_start];
-
-		if ( num_res == r->number_of_res ) {
-
-		    if ( (NULL == (r->match = xrealloc ( r->match, sizeof(Wtmatch *) * 
-			 ( r->number_of_res + r->number_of_res/2) )))) return -2;
-
-		    r->number_of_res = r->number_of_res + r->number_of_res/2;
-		}
+    if (NULL == (s = wtm_scanner_create ( w->matrix, w->length, w->depth,
+					  w->min, WTM_FORWARD ))) return -3;
+    if ( c ) {
+	for ( i = 0; i < c->num_elements; i++ )
+	    wtm_scanner_conserve ( s, c->pair[i].offset, c->pair[i].symbol );
+    }
 
-		r->match[num_res++] = m;
-	    }
-	}
-	else {
-	    break;
-	}
+    num_res = wtm_scan ( s, seq, user_start - 1, user_end - 1,
+			 &hits, &max_hits );
+    wtm_scanner_destroy ( s );
+    if ( num_res < 0 ) {
+	if ( hits ) xfree ( hits );
+	return -2;
     }
-    r->number_of_res = num_res;
 
-    /* set array sizes to what was used */
+    /* set array sizes to what is used */
     if ( num_res ) {
-
 	if ( (NULL == (r->match = xrealloc ( r->match, sizeof(Wtmatch *) * 
-					    ( num_res) )))) return -3;
+					    ( num_res) )))) {
+	    xfree ( hits );
+	    return -3;
+	}
+    } else if ( r->match ) {
+	xfree ( r->match );
+	r->match = NULL;
+    }
+    r->number_of_res = 0;
+
+    for ( i = 0; i < num_res; i++ ) {
+	if ( ( NULL == ( m = (Wtmatch* ) xmalloc ( sizeof (Wtmatch ) )))) {
+	    xfree ( hits );
+	    return -3;
+	}
+	m->pos = hits[i].pos + w->mark_pos;
+	m->score = hits[i].score;
+	m->seq = &seq[hits[i].pos];
+	r->match[r->number_of_res++] = m;
     }
+
+    if ( hits ) xfree ( hits );
     return 0;
 }
 
+int do_wt_search_cs ( char seq[], int seq_length, int user_start, int user_end,
+		  WtmatrixSpec *w, MatchMask *c, WtmatrixRes *r ) {
+
+    return do_wt_scan ( seq, user_start, user_end, w, c, r );
+}
+
 int do_mask_match_wt ( char *seq, int seq_len, int user_start, int user_end, MatchMask *m ) {
 
     /* find all places where MatchMask matches */
@@ -482,53 +487,7 @@ int get_wt_weights ( int counts[], WtmatrixSpec *w ) {
 int do_wt_search ( char seq[], int seq_length, int user_start, int user_end,
 		  WtmatrixSpec *w, WtmatrixRes *r) {
 
-    int start, end, max_start, left_start, num_res, matrix_pos, seq_pos;
-    double score;
-    Wtmatch *m;
-
-    start = user_start - 1;
-    end   = user_end - 1;
-
-    /* loop for all matrix left starts. Note the matrix is stored in a vector length*depth */
-
-    max_start = end - ( w->length - 1 );
-
-    for ( left_start = start, num_res = 0; left_start <= max_start; left_start++ ) {
-
-	/* loop for the matrix length */
-
-	for ( matrix_pos = 0, seq_pos = left_start, score = 0.0; 
-	      matrix_pos < w->length; matrix_pos++, seq_pos++ ) {
-
-	    score += w->matrix [ char_lookup [ seq [ seq_pos ]] * (w->length) + matrix_pos ];
-	}
-	if ( score >= w->min ) {
-
-	    if ( ( NULL == ( m = (Wtmatch* ) xmalloc ( sizeof (Wtmatch ) )))) return -3;
-	    m->pos = left_start + w->mark_pos;
-	    m->score = score;
-	    m->seq = &seq[left_start];
-
-	    if ( num_res == r->number_of_res ) {
-
-		if ( (NULL == (r->match = xrealloc ( r->match, sizeof(Wtmatch *) * 
-		     ( r->number_of_res + r->number_of_res/2) )))) return -2;
-
-		r->number_of_res = r->number_of_res + r->number_of_res/2;
-	    }
-
-	    r->match[num_res++] = m;
-	}
-    }
-    r->number_of_res = num_res;
-
-    /* set array sizes to what was used */
-    if ( num_res ) {
-
-	if ( (NULL == (r->match = xrealloc ( r->match, sizeof(Wtmatch *) * 
-					    ( num_res) )))) return -3;
-    }
-    return 0;
+    return do_wt_scan ( seq, user_start, user_end, w, NULL, r );
 }
 
 WeightMatrixCounts *read_weight_matrix ( FILE *file_p, int char_set ) {
@@ -33,6 +33,7 @@ typedef struct splice_res_ {
 } splice_res;
 
 void free_WtmatrixRes ( WtmatrixRes *r );
+void free_splice_results2 ( SpliceResults *s );
 int splice_search (char seq[], int seq_length, int user_start, int user_end,
 		   char *filename_ied, char *filename_eia,
 		   SpliceResults *splice_result);
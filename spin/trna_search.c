@@ -606,9 +606,11 @@ void trna_draw ( TrnaRes *r ) {
     }
 }
 
+#define TRNA_INC 100
+
 int realloc_trna(TrnaRes ***r, int *max_trna)
 {
-    int trna_inc = 100;
+    int trna_inc = TRNA_INC;
     int prev = *max_trna;
     int i;
 
@@ -910,3 +912,18 @@ int trna_search ( char seq[], int seq_length, int user_start, int user_end,
     /* free */
     return ret;
 }
+
+/*
+ * Frees the results array filled in by trna_search(). It holds MAX_TRNA
+ * entries, plus TRNA_INC more each time nmatch reached the end.
+ */
+void free_trna_results(TrnaRes **results, int nmatch)
+{
+    int max_trna, i;
+
+    for (max_trna = MAX_TRNA; max_trna <= nmatch; max_trna += TRNA_INC)
+	;
+    for (i = 0; i < max_trna; i++)
+	xfree(results[i]);
+    xfree(results);
+}
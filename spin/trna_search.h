@@ -49,6 +49,8 @@ int trna_search ( char seq[], int seq_length, int user_start, int user_end,
 		  TrnaRes ***results, int *nmatch, int *max_total_bp_score, 
 		  TrnaSpec **t);
 
+void free_trna_results(TrnaRes **results, int nmatch);
+
 void draw_trna ( TrnaRes *r );
 
 #endif
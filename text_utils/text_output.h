@@ -52,4 +52,11 @@ void log_file(const char *fn, const char *message);
  */ 
 int log_vmessage(int log);
 
+/*
+ * Sets the stream that vmessage() and the function headers are written to
+ * when there is no output window. NULL means stdout.
+ * Returns the previous setting.
+ */
+FILE *vmessage_stream(FILE *fp);
+
 #endif
@@ -9,6 +9,7 @@
 #include "text_output.h"
 
 static int header_outputted = 0;
+static FILE *message_fp = NULL; /* NULL for stdout */
 
 void start_message(void) {}
 void end_message(const char *parent) {}
@@ -37,7 +38,7 @@ void vmessage(const char *fmt, ...) {
     va_list args;
 
     va_start(args, fmt);
-    vfprintf(stdout, fmt, args);
+    vfprintf(message_fp ? message_fp : stdout, fmt, args);
 }
 
 /*
@@ -45,11 +46,12 @@ void vmessage(const char *fmt, ...) {
  */
 __PRINTF_FORMAT__(1,2)
 void vfuncheader(const char *fmt, ...) {
+    FILE *fp = message_fp ? message_fp : stdout;
     va_list args;
 
     va_start(args, fmt);
-    vfprintf(stdout, fmt, args);
-    fprintf(stdout, "\n");
+    vfprintf(fp, fmt, args);
+    fprintf(fp, "\n");
     header_outputted = 1;
 }
 
@@ -73,9 +75,11 @@ void vfuncgroup(int group, const char *fmt, ...) {
 
 
     if (header_outputted || group != group_num) {
+	FILE *fp = message_fp ? message_fp : stdout;
+
 	va_start(args, fmt);
-	vfprintf(stdout, fmt, args);
-	fprintf(stdout, "\n");
+	vfprintf(fp, fmt, args);
+	fprintf(fp, "\n");
 
 	header_outputted = 0;
 	group_num = group;
@@ -89,3 +93,9 @@ void log_file(const char *fn, const char *message) {}
 int log_vmessage(int log) {
     return 0;
 }
+
+FILE *vmessage_stream(FILE *fp) {
+    FILE *prev = message_fp;
+    message_fp = fp;
+    return prev;
+}
@@ -0,0 +1,97 @@
+#include <limits.h>
+
+#include "xalloc.h"
+#include "decimate.h"
+
+int decimate_lines(XPoint *pt, int npts) {
+    int i, j, k, lo, hi, n = 0;
+    int idx[4];
+    XPoint keep[4];
+
+    for (i = 0; i < npts; i = j) {
+	lo = hi = i;
+	for (j = i + 1; j < npts && pt[j].x == pt[i].x; j++) {
+	    if (pt[j].y < pt[lo].y) lo = j;
+	    if (pt[j].y > pt[hi].y) hi = j;
+	}
+
+	/* keep the points in their original order */
+	idx[0] = i;
+	idx[1] = lo < hi ? lo : hi;
+	idx[2] = lo < hi ? hi : lo;
+	idx[3] = j - 1;
+	for (k = 0; k < 4; k++)
+	    keep[k] = pt[idx[k]];
+
+	/* never writes past pt[j-1], so the copy can be done in place */
+	for (k = 0; k < 4; k++) {
+	    if (k && idx[k] == idx[k-1])
+		continue;
+	    if (n && pt[n-1].x == keep[k].x && pt[n-1].y == keep[k].y)
+		continue;
+	    pt[n++] = keep[k];
+	}
+    }
+
+    return n;
+}
+
+int decimate_points(XPoint *pt, int npts, int height) {
+    int *seen;
+    int i, n, y;
+
+    if (npts < 2 || height < 1)
+	return npts;
+
+    /* column in which each row was last drawn */
+    if (NULL == (seen = (int *)xmalloc(height * sizeof(int))))
+	return npts;
+    for (y = 0; y < height; y++)
+	seen[y] = INT_MIN;
+
+    for (n = i = 0; i < npts; i++) {
+	y = pt[i].y;
+	if (y >= 0 && y < height) {
+	    if (seen[y] == pt[i].x)
+		continue;
+	    seen[y] = pt[i].x;
+	}
+	pt[n++] = pt[i];
+    }
+
+    xfree(seen);
+    return n;
+}
+
+int decimate_segments(XSegment *seg, int nsegs) {
+    int i, n = 0;
+    int lo, hi, plo, phi;
+    XSegment s, *p;
+
+    for (i = 0; i < nsegs; i++) {
+	s = seg[i];
+
+	if (n) {
+	    p = &seg[n-1];
+
+	    if (s.x1 == s.x2 && p->x1 == p->x2 && s.x1 == p->x1) {
+		lo  = s.y1 < s.y2 ? s.y1 : s.y2;
+		hi  = s.y1 < s.y2 ? s.y2 : s.y1;
+		plo = p->y1 < p->y2 ? p->y1 : p->y2;
+		phi = p->y1 < p->y2 ? p->y2 : p->y1;
+		if (lo <= phi && hi >= plo) {
+		    p->y1 = lo < plo ? lo : plo;
+		    p->y2 = hi > phi ? hi : phi;
+		    continue;
+		}
+	    } else if (s.x1 == p->x1 && s.y1 == p->y1 &&
+		       s.x2 == p->x2 && s.y2 == p->y2) {
+		continue;
+	    }
+	}
+
+	seg[n++] = s;
+    }
+
+    return n;
+}
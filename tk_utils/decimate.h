@@ -0,0 +1,32 @@
+#ifndef _DECIMATE_H_
+#define _DECIMATE_H_
+
+#include <tk.h>
+
+/*
+ * Reduces the data sent to the X server when there are many more points
+ * than pixels. Each function works in place on coordinates that have
+ * already been converted to pixels, only removing what would not change
+ * the pixels drawn, and returns the new number of elements.
+ */
+
+/*
+ * Replaces each run of successive points of a polyline in the same pixel
+ * column by its first, lowest, highest and last points, so a line
+ * through any number of points draws at most four per column.
+ */
+int decimate_lines(XPoint *pt, int npts);
+
+/*
+ * Removes points falling on a pixel already drawn in the same column.
+ * Only rows 0 to height-1 are checked; points outside them are kept.
+ */
+int decimate_points(XPoint *pt, int npts, int height);
+
+/*
+ * Merges successive vertical segments in the same pixel column whose
+ * extents overlap, and removes repeated segments.
+ */
+int decimate_segments(XSegment *seg, int nsegs);
+
+#endif
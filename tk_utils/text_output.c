@@ -56,6 +56,7 @@ static int win_init = 0;
 static int stdout_scroll = 1, stderr_scroll = 1;
 static int header_outputted = 0;
 static FILE *stdout_fp = NULL, *stderr_fp = NULL;
+static FILE *message_fp = NULL; /* NULL for stdout; see vmessage_stream() */
 static Tcl_Interp *_interp = NULL;
 static int noisy = 0;
 
@@ -176,12 +177,25 @@ int log_vmessage(int log) {
     return prev;
 }
 
+/*
+ * Sets the stream that vmessage() and the function headers are written to
+ * when there is no output window. NULL means stdout.
+ * Returns the previous setting.
+ */
+FILE *vmessage_stream(FILE *fp) {
+    FILE *prev = message_fp;
+    message_fp = fp;
+    return prev;
+}
+
 static void tout_update_stream(int fd, const char *buf, int header,
 			       const char *tag) {
     char * win;
     char tag_list[1024];
 
     if (!win_init) {
+	FILE *fp = fd == 2 ? stderr : message_fp ? message_fp : stdout;
+
 #ifdef _WIN32
 	/* WINNT will not have stdout/err defined unless running in console mode
 	 * so use a message box
@@ -191,8 +205,8 @@ static void tout_update_stream(int fd, const char *buf, int header,
 	    return;
 	}
 #endif
-	fprintf(fd == 1 ? stdout : stderr, "%s", buf);
-	fflush(fd == 1 ? stdout : stderr);
+	fprintf(fp, "%s", buf);
+	fflush(fp);
 	return;
     }
 
@@ -7,6 +7,7 @@
 #include "tkCanvGraph.h"
 #include "tclCanvGraph.h"
 #include "matrix.h"
+#include "decimate.h"
 
 #ifdef __MINGW32__
 extern int		Tk_CanvasTagsParseProc _ANSI_ARGS_((
@@ -22,6 +23,27 @@ extern char *		Tk_CanvasTagsPrintProc _ANSI_ARGS_((
 /* HACK - put somewhere else */
 #define ROUND(x)   ((x) < 0.0 ? ceil((x) - 0.5) : floor((x) + 0.5))
 
+/* Number of points in the smallest bucket of a graph_lod */
+#define LOD_BUCKET 4
+
+/* Points per pixel above which a contiguous line is drawn from its graph_lod */
+#define LOD_PTS_PER_PIXEL 16
+
+/*
+ * A min/max pyramid of a contiguous line, built the first time the line is
+ * drawn zoomed out. Level l divides the points into buckets of
+ * LOD_BUCKET << l points and holds the indices of the lowest and highest
+ * point in each, so a redraw only needs to visit a few buckets per pixel
+ * however many points there are.
+ */
+typedef struct {
+    g_pt *p_array;		/* points summarised */
+    int n_pts;
+    int nlevels;
+    int **lo;			/* [level][bucket] index of the lowest point */
+    int **hi;			/* [level][bucket] index of the highest point */
+} graph_lod;
+
 /*
  * The structure below defines the record for each graph item.
  */
@@ -65,6 +87,9 @@ typedef struct GraphItem  {
     int prev_width;             /* store previous width/height to determine */
     int prev_height;            /* window has resized */
     int vertical;               /* orientation of window */
+    Graph *lod_graph;           /* graph that lod was built from */
+    graph_lod *lod;             /* pyramids of the contiguous lines */
+    int n_lod;
 } GraphItem;
 
 /*
@@ -98,6 +123,7 @@ static void		ScaleGraph _ANSI_ARGS_((Tk_Canvas canvas,
 			    double scaleX, double scaleY));
 static void		TranslateGraph _ANSI_ARGS_((Tk_Canvas canvas,
 			    Tk_Item *itemPtr, double deltaX, double deltaY));
+static void		graph_lod_free _ANSI_ARGS_((GraphItem *graphPtr));
 
 int pixel_to_canvas(Tcl_Interp *interp,
 		    Tk_Window tkwin,
@@ -578,6 +604,9 @@ CreateGraph(Tcl_Interp *interp,
     graphPtr->prev_width = 0;
     graphPtr->prev_height = 0;
     graphPtr->vertical = 0;
+    graphPtr->lod_graph = NULL;
+    graphPtr->lod = NULL;
+    graphPtr->n_lod = 0;
 
     make_identity_matrix(graphPtr->M);
     /*
@@ -751,6 +780,7 @@ ConfigureGraph(Tcl_Interp *interp,
 	Tcl_Obj *obj = (Tcl_Obj *)argv[i];
 	if (obj->typePtr && (strcmp(obj->typePtr->name, "graph") == 0)) {
 		graphPtr->graph = Tcl_GetGraphFromObj(obj);
+		graph_lod_free(graphPtr);
 	}
     }
 
@@ -884,6 +914,8 @@ DeleteGraph(Tk_Canvas canvas,
     if (graphPtr->paintGC != None) {
 	Tk_FreeGC(display, graphPtr->paintGC);
     }
+
+    graph_lod_free(graphPtr);
 }
 
 /*
@@ -1350,6 +1382,139 @@ double pixely_to_world(double py,
 
 }
 
+/*
+ * Builds the min/max pyramid of the n_pts points of p_array.
+ */
+static void graph_lod_build(graph_lod *lod,
+			    g_pt *p_array,
+			    int n_pts)
+{
+    int l, b, i, end, nb, prev_nb;
+    int *lo, *hi;
+
+    lod->p_array = p_array;
+    lod->n_pts = n_pts;
+
+    for (lod->nlevels = 1, nb = (n_pts + LOD_BUCKET - 1) / LOD_BUCKET;
+	 nb > 1; nb = (nb + 1) / 2)
+	lod->nlevels++;
+
+    lod->lo = (int **)ckalloc(lod->nlevels * sizeof(int *));
+    lod->hi = (int **)ckalloc(lod->nlevels * sizeof(int *));
+
+    /* the first level from the points themselves */
+    nb = (n_pts + LOD_BUCKET - 1) / LOD_BUCKET;
+    lo = lod->lo[0] = (int *)ckalloc(nb * sizeof(int));
+    hi = lod->hi[0] = (int *)ckalloc(nb * sizeof(int));
+    for (b = 0; b < nb; b++) {
+	lo[b] = hi[b] = b * LOD_BUCKET;
+	end = (b + 1) * LOD_BUCKET < n_pts ? (b + 1) * LOD_BUCKET : n_pts;
+	for (i = b * LOD_BUCKET + 1; i < end; i++) {
+	    if (p_array[i].y < p_array[lo[b]].y) lo[b] = i;
+	    if (p_array[i].y > p_array[hi[b]].y) hi[b] = i;
+	}
+    }
+
+    /* and each further level from pairs of buckets of the one before */
+    for (l = 1; l < lod->nlevels; l++) {
+	int *plo = lod->lo[l-1], *phi = lod->hi[l-1];
+
+	prev_nb = nb;
+	nb = (nb + 1) / 2;
+	lo = lod->lo[l] = (int *)ckalloc(nb * sizeof(int));
+	hi = lod->hi[l] = (int *)ckalloc(nb * sizeof(int));
+	for (b = 0; b < nb; b++) {
+	    lo[b] = plo[2*b];
+	    hi[b] = phi[2*b];
+	    if (2*b + 1 < prev_nb) {
+		if (p_array[plo[2*b+1]].y < p_array[lo[b]].y)
+		    lo[b] = plo[2*b+1];
+		if (p_array[phi[2*b+1]].y > p_array[hi[b]].y)
+		    hi[b] = phi[2*b+1];
+	    }
+	}
+    }
+}
+
+/*
+ * Releases the pyramids of a graph item, which must be done whenever its
+ * graph changes.
+ */
+static void graph_lod_free(GraphItem *graphPtr)
+{
+    int i, l;
+
+    for (i = 0; i < graphPtr->n_lod; i++) {
+	for (l = 0; l < graphPtr->lod[i].nlevels; l++) {
+	    ckfree((char *)graphPtr->lod[i].lo[l]);
+	    ckfree((char *)graphPtr->lod[i].hi[l]);
+	}
+	ckfree((char *)graphPtr->lod[i].lo);
+	ckfree((char *)graphPtr->lod[i].hi);
+    }
+    if (graphPtr->lod)
+	ckfree((char *)graphPtr->lod);
+
+    graphPtr->lod = NULL;
+    graphPtr->n_lod = 0;
+    graphPtr->lod_graph = NULL;
+}
+
+/*
+ * Returns the pyramid for the points of p, building it if needed.
+ */
+static graph_lod *graph_lod_find(GraphItem *graphPtr,
+				 parray *p)
+{
+    int i;
+
+    if (graphPtr->lod_graph != graphPtr->graph) {
+	graph_lod_free(graphPtr);
+	graphPtr->lod_graph = graphPtr->graph;
+    }
+
+    for (i = 0; i < graphPtr->n_lod; i++) {
+	if (graphPtr->lod[i].p_array == p->p_array &&
+	    graphPtr->lod[i].n_pts == p->n_pts)
+	    return &graphPtr->lod[i];
+    }
+
+    graphPtr->lod = (graph_lod *)ckrealloc((char *)graphPtr->lod,
+					   (graphPtr->n_lod + 1) *
+					   sizeof(graph_lod));
+    graph_lod_build(&graphPtr->lod[graphPtr->n_lod], p->p_array, p->n_pts);
+
+    return &graphPtr->lod[graphPtr->n_lod++];
+}
+
+/*
+ * Converts a point of a contiguous line to pixels in the item's pixmap.
+ */
+static void graph_pt_to_xpoint(GraphItem *graphPtr,
+			       g_pt p,
+			       XPoint *pPtr)
+{
+    g_pt pt;
+
+    canvas_array_pt(graphPtr, p, &pt);
+
+    /* FIXME need to check if need x0 offset in invertx/inverty
+       for graphs that do not start at the origin */
+    if (graphPtr->invertx) {
+	pPtr->x = graphPtr->max_x - (pt.x + graphPtr->x0) + graphPtr->min_x;
+    } else {
+	pPtr->x = pt.x - graphPtr->x0;
+    }
+
+    if (graphPtr->inverty) {
+	pPtr->y = graphPtr->max_y - (pt.y + graphPtr->y0) + graphPtr->min_y;
+    } else {
+	pPtr->y = pt.y - graphPtr->y0;
+    }
+
+    pPtr->y += graphPtr->an_y;
+}
+
 /*
  * plot contiguous array of lines ie XDrawLines
  */
@@ -1368,9 +1533,9 @@ void Graph_Plot_Func(Tk_Canvas canvas,
     XPoint *pPtr;
     double wx0, wx1;
     int free = 0;
-    g_pt pt;
-    int height;
-    Tk_Window tkwin = Tk_CanvasTkwin(canvas);
+    int npix, npoints;
+    int l = 0, size = 0, b, b0 = 0, b1 = -1, lo, hi;
+    graph_lod *lod = NULL;
 
     if (p.n_pts == 0)
 	return;
@@ -1390,83 +1555,93 @@ void Graph_Plot_Func(Tk_Canvas canvas,
 	wx0 = pixelx_to_world(x0, graphPtr);
 	wx1 = pixelx_to_world(x1, graphPtr);
     }
-    if (p.n_pts <= MAX_STATIC_POINTS) {
-	pointPtr = staticPoints;
-    } else {
-	pointPtr = (XPoint *) ckalloc((unsigned) (p.n_pts *
-						  sizeof(XPoint)));
-	free++;
-    }
-
-    height = Tk_Height(tkwin);
 
     if (p.n_pts == 1) {
 #ifdef TODO
 	/* RasterDrawPoints(raster, coords, 1); */
 #endif
-    } else {
-	/*
-	 * it isn't necessarily the case that I will have as many points as
-	 * sequence bases so need to check if each base is within my range
-	 */
-	find_start_end_pt(p.p_array, p.n_pts, wx0, wx1, &first, &last);
+	return;
+    }
 
-#ifdef DEBUG
-	printf("first %d %f last %d %f\n", first, p.p_array[first].x,
-	       last, p.p_array[last-1].x);
-	printf("sx0 %d sy0 %d header.x1 %d header.x2 %d\n",
-	       graphPtr->x0, graphPtr->y0,
-	       graphPtr->header.x1, graphPtr->header.x2);
-#endif
+    /*
+     * it isn't necessarily the case that I will have as many points as
+     * sequence bases so need to check if each base is within my range
+     */
+    find_start_end_pt(p.p_array, p.n_pts, wx0, wx1, &first, &last);
 
 #ifdef DEBUG
-	printf("max_x %f min_x %f x0 %d max_y %f min_y %f y0 %d\n",
-	       graphPtr->max_x, graphPtr->min_x, graphPtr->x0,
-	       graphPtr->max_y, graphPtr->min_y, graphPtr->y0);
+    printf("first %d %f last %d %f\n", first, p.p_array[first].x,
+	   last, p.p_array[last-1].x);
+    printf("sx0 %d sy0 %d header.x1 %d header.x2 %d\n",
+	   graphPtr->x0, graphPtr->y0,
+	   graphPtr->header.x1, graphPtr->header.x2);
 #endif
-	for (i = first, pPtr = pointPtr; i < last;  i++, pPtr++) {
-
-	    canvas_array_pt(graphPtr, p.p_array[i], &pt);
-
-	    /* FIXME need to check if need x0 offset in invertx/inverty
-	      for graphs that do not start at the origin */
-	    if (graphPtr->invertx) {
-		pPtr->x = graphPtr->max_x - (pt.x + graphPtr->x0) + graphPtr->min_x;
-	    } else {
-		pPtr->x = pt.x - graphPtr->x0;
-	    }
-
-	    if (graphPtr->inverty) {
 
+    /*
+     * When zoomed out use the largest buckets of the pyramid holding at
+     * most half a pixel's worth of points, so that only a few points per
+     * pixel are converted however long the line is.
+     */
+    npix = abs(x1 - x0) + 1;
+    if (last - first > LOD_PTS_PER_PIXEL * npix) {
+	lod = graph_lod_find(graphPtr, &p);
+	for (l = 0, size = LOD_BUCKET;
+	     l + 1 < lod->nlevels && size * 4 <= (last - first) / npix;
+	     l++, size *= 2)
+	    ;
+	b0 = first / size;
+	b1 = (last - 1) / size;
+	npoints = 2 * (b1 - b0 + 1) + 2;
+    } else {
+	npoints = last - first;
+    }
 
-		pPtr->y = graphPtr->max_y - (pt.y + graphPtr->y0) + graphPtr->min_y;
+    if (npoints <= MAX_STATIC_POINTS) {
+	pointPtr = staticPoints;
+    } else {
+	pointPtr = (XPoint *) ckalloc((unsigned) (npoints * sizeof(XPoint)));
+	free++;
+    }
 
-#if 0
-		pPtr->y = height + graphPtr->min_y - (pt.y + graphPtr->y0);
-#endif
-#ifdef DEBUG
-		printf("max_y %f y %f y0 %d min_y %f pPtry %f\n",
-		       graphPtr->max_y, y, graphPtr->y0, graphPtr->min_y, pPtr->y);
-#endif
-	    } else {
-		pPtr->y = pt.y - graphPtr->y0;
+    if (lod) {
+	/* the end points exactly, and the extremes of the buckets between */
+	pPtr = pointPtr;
+	graph_pt_to_xpoint(graphPtr, p.p_array[first], pPtr++);
+	for (b = b0; b <= b1; b++) {
+	    lo = lod->lo[l][b];
+	    hi = lod->hi[l][b];
+	    if (lo > hi) {
+		hi = lo;
+		lo = lod->hi[l][b];
 	    }
-
-	    pPtr->y += graphPtr->an_y;
-
+	    if (lo > first && lo < last - 1)
+		graph_pt_to_xpoint(graphPtr, p.p_array[lo], pPtr++);
+	    if (hi != lo && hi > first && hi < last - 1)
+		graph_pt_to_xpoint(graphPtr, p.p_array[hi], pPtr++);
+	}
+	graph_pt_to_xpoint(graphPtr, p.p_array[last-1], pPtr++);
+	npoints = pPtr - pointPtr;
+    } else {
+	for (i = first, pPtr = pointPtr; i < last;  i++, pPtr++) {
+	    graph_pt_to_xpoint(graphPtr, p.p_array[i], pPtr);
 #ifdef PRINT
 	    printf("%d %f %f %d %d %f\n", i, p.p_array[i].x, p.p_array[i].y,
 		   pPtr->x, pPtr->y, graphPtr->an_y);
 #endif
 	}
+    }
+
+    if (npoints > npix)
+	npoints = decimate_lines(pointPtr, npoints);
+
 #ifdef DEBUG
-	for (i = 0; i < last-first; i++) {
-	    printf("%d %d\n", pointPtr[i].x, pointPtr[i].y);
-	}
-#endif
-	XDrawLines(display, graphPtr->pm, graphPtr->drawGC, pointPtr,
-		   last-first, CoordModeOrigin);
+    for (i = 0; i < npoints; i++) {
+	printf("%d %d\n", pointPtr[i].x, pointPtr[i].y);
     }
+#endif
+    XDrawLines(display, graphPtr->pm, graphPtr->drawGC, pointPtr,
+	       npoints, CoordModeOrigin);
+
     if (free)
 	ckfree((char *)pointPtr);
 }
@@ -1555,7 +1730,8 @@ void Graph_Segment_Func(Tk_Canvas canvas,
 #endif
     }
 
-    len = last-first;
+    /* dense bars collapse to one segment per pixel column */
+    len = decimate_segments(seg, last-first);
 
     /*
      * fix to deal with x servers which can't cope with more than 2^16 lines
@@ -33,6 +33,9 @@
 #define RASTER_DRAW_BORDER 2
 #define RASTER_DRAW_ALL    3
 
+/* Number of single points or lines sent to the X server together */
+#define RASTER_BATCH 512
+
 
 #include <stdio.h>
 #include <memory.h>
@@ -58,6 +61,7 @@
 
 #include "tkRaster.h"
 #include "tkRasterBuiltIn.h"
+#include "decimate.h"
 #include "xalloc.h"
 #include "tcl_utils.h"
 
@@ -177,6 +181,25 @@ typedef struct Raster_t {
 
     ClientData *primitiveData;
 
+    /*
+     *  Single points and lines waiting to be drawn, all with batchGC
+     */
+
+    GC batchGC;
+    int batchWidth;		/* point width, as for RasterDrawPoints */
+    XPoint batchPts[RASTER_BATCH];
+    int nBatchPts;
+    XSegment batchSegs[RASTER_BATCH];
+    int nBatchSegs;
+
+    /*
+     *  While scrolling, the newly exposed part of the pixmap, to which
+     *  drawing in copy mode is restricted
+     */
+
+    int stripActive;
+    int sx0, sy0, sx1, sy1;
+
     /*void (*plot_func)(struct Raster_t *raster, int x0, int y0, int x1, int y1); */
     void (*plot_func)(Tk_Raster *raster, char *raster_win, int job,
 		      int x0, int y0, int x1, int y1);
@@ -235,6 +258,8 @@ static void DestroyDrawEnv _ANSI_ARGS_((Raster*, DrawEnvironment*));
 static void RasterScrollX(Raster *raster, int x, int old);
 static void RasterScrollY(Raster *raster, int y, int old);
 static void RasterClear(Raster *RasterPtr);
+static void RasterFlush(Raster *RasterPtr);
+static void RasterClipStrip(Raster *RasterPtr, int x0, int y0, int x1, int y1);
 
 /*
  * Not implemented (by Tk) configuration options used in this widgets
@@ -466,6 +491,11 @@ RasterCmd(ClientData clientData, Tcl_Interp *interp, int argc, char **argv)
     RasterPtr->px1 = LOW;
     RasterPtr->py1 = LOW;
     RasterPtr->knownarea = 0;
+    RasterPtr->batchGC = None;
+    RasterPtr->batchWidth = 0;
+    RasterPtr->nBatchPts = 0;
+    RasterPtr->nBatchSegs = 0;
+    RasterPtr->stripActive = 0;
     RasterPtr->initialised = 0;
     RasterPtr->wx_start = DBL_MAX/2;
     RasterPtr->wy_start = DBL_MAX/2;
@@ -643,6 +673,7 @@ RasterWidgetCmd(clientData, interp, argc, argv)
 			    argv[0], " clear", (char *) NULL);
 	  goto error;
        }
+       RasterPtr->nBatchPts = RasterPtr->nBatchSegs = 0;
        XFillRectangle (RasterPtr->display, RasterPtr->pm, RasterPtr->copyGC,
 		       0, 0, RasterPtr->width, RasterPtr->height);
        arrangeDisplay (RasterPtr, LOW, LOW, HIGH, HIGH, RASTER_DRAW_PIXMAP);
@@ -1291,6 +1322,8 @@ ResizeRaster(Raster *RasterPtr,
 #ifdef DEBUG
     printf("ResizeRaster\n");
 #endif
+    RasterFlush(RasterPtr);
+
     /* 7/1/99 johnt - changed X Pixmap functions to TK functions for Windows portability */
     newpm = Tk_GetPixmap (RasterPtr->display,
 			   RootWindowOfScreen (Tk_Screen (RasterPtr->tkwin)),
@@ -1584,6 +1617,7 @@ static void DisplayRaster(ClientData clientData)
     Pixmap pm = None;
     Drawable d;
     int result, winwid, winhgt, wid, hgt;
+    int cx0, cy0, cx1, cy1;
     XRectangle clip;
     int mode = RasterPtr->updatePending;
     int scrolling = 0;
@@ -1599,55 +1633,15 @@ static void DisplayRaster(ClientData clientData)
 	return;
     }
 
-#if 0
-    /*
-     * Analyze the Raster's redisplay rectangle. If we're not asked to
-     * redisplay the whole pixmap then do a quick and dirty job.
-     */
-    if (RasterPtr->x0 > 0 || RasterPtr->y0 > 0 ||
-	RasterPtr->x1 <= RasterPtr->width ||
-	RasterPtr->y1 <= RasterPtr->height) {
-
-       winx = RasterPtr->x + RasterPtr->borderWidth + RasterPtr->x0;
-       winy = RasterPtr->y + RasterPtr->borderWidth + RasterPtr->y0;
-
-       if (winx < RasterPtr->borderWidth) {
-	  RasterPtr->x0 += RasterPtr->borderWidth - winx;
-	  winx = RasterPtr->borderWidth;
-       }
-       if (winy < RasterPtr->borderWidth) {
-	  RasterPtr->y0 += RasterPtr->borderWidth - winy;
-	  winy = RasterPtr->borderWidth;
-       }
-       winwid = Tk_Width (tkwin) - 2*RasterPtr->borderWidth;
-       winhgt = Tk_Height (tkwin) - 2*RasterPtr->borderWidth;
-       if (RasterPtr->x1 + RasterPtr->x > winwid) {
-	  RasterPtr->x1 = winwid - RasterPtr->x;
-       }
-       if (RasterPtr->y1 + RasterPtr->y > winhgt) {
-	  RasterPtr->y1 = winhgt - RasterPtr->y;
-       }
-       wid = RasterPtr->x1 - RasterPtr->x0;
-       hgt = RasterPtr->y1 - RasterPtr->y0;
-       if (wid > 0 && hgt > 0) {
-	  XCopyArea (Tk_Display(tkwin), RasterPtr->pm, Tk_WindowId(tkwin),
-		     RasterPtr->copyGC,
-		     RasterPtr->x0, RasterPtr->y0, wid, hgt,
-		     RasterPtr->x0, RasterPtr->y0);
-       }
-       RasterPtr->x0 = HIGH;
-       RasterPtr->y0 = HIGH;
-       RasterPtr->x1 = LOW;
-       RasterPtr->y1 = LOW;
-       return;
-    }
-#endif
+    /* the pixmap must be complete before scrolling or copying it */
+    RasterFlush(RasterPtr);
 
     /*
-     * Create a pixmap for double-buffering, if necessary.
+     * Create a pixmap for double-buffering, if necessary. The raster is
+     * already held in a pixmap so this is only needed for the border.
      */
 
-    if (RasterPtr->doubleBuffer) {
+    if (RasterPtr->doubleBuffer && (mode & RASTER_DRAW_BORDER)) {
 	/* 7/1/99 johnt - changed X Pixmap functions to TK functions for Windows portability */
 	pm = Tk_GetPixmap(Tk_Display(tkwin), Tk_WindowId(tkwin),
 			   Tk_Width(tkwin), Tk_Height(tkwin),
@@ -1698,6 +1692,7 @@ static void DisplayRaster(ClientData clientData)
 				     RasterPtr->wx_start, RasterPtr->wy_start,
 				     RasterPtr->wx_end, RasterPtr->wy_end);
 	    }
+	    RasterFlush(RasterPtr);
 
 	    scrolling = 1;
 	    dx = RasterPtr->new_x - RasterPtr->x;
@@ -1733,6 +1728,8 @@ static void DisplayRaster(ClientData clientData)
 				    RasterPtr->copyGC,
 				    wid - dx < 0 ? 0 : wid - dx, 0,
 				    wid, hgt);
+		    RasterClipStrip(RasterPtr, wid - dx < 0 ? 0 : wid - dx, 0,
+				    wid, hgt);
 		} else if (RasterPtr->new_x <= RasterPtr->x){
 
 		    /* Copying left chunk to right, clear left edge */
@@ -1747,8 +1744,11 @@ static void DisplayRaster(ClientData clientData)
 				    RasterPtr->copyGC,
 				    0, 0,
 				    -dx > wid ? wid : -dx, hgt);
+		    RasterClipStrip(RasterPtr, 0, 0,
+				    -dx > wid ? wid : -dx, hgt);
 		}
 		RasterScrollX(RasterPtr, RasterPtr->new_x, RasterPtr->x);
+		RasterClipStrip(RasterPtr, 0, 0, 0, 0);
 	    }
 	    /* only scroll in y if need to */
 	    if (RasterPtr->new_y != RasterPtr->y) {
@@ -1783,25 +1783,40 @@ static void DisplayRaster(ClientData clientData)
 #endif
 	    }
 	}
+	/* the replotted sliver */
+	RasterFlush(RasterPtr);
+
 	winwid = Tk_Width (tkwin) - 2*RasterPtr->borderWidth;
 	winhgt = Tk_Height (tkwin) - 2*RasterPtr->borderWidth;
-	if (wid > 0 && hgt > 0) {
+	if (scrolling || (mode & RASTER_DRAW_BORDER) || RasterPtr->doclip) {
+	    cx0 = cy0 = 0;
+	    cx1 = winwid;
+	    cy1 = winhgt;
+	} else {
+	    /* only the modified part of the pixmap needs copying */
+	    cx0 = RasterPtr->x0 < 0 ? 0 : RasterPtr->x0;
+	    cy0 = RasterPtr->y0 < 0 ? 0 : RasterPtr->y0;
+	    cx1 = RasterPtr->x1 >= winwid ? winwid : RasterPtr->x1 + 1;
+	    cy1 = RasterPtr->y1 >= winhgt ? winhgt : RasterPtr->y1 + 1;
+	}
+	if (wid > 0 && hgt > 0 && cx1 > cx0 && cy1 > cy0) {
 	    XCopyArea (Tk_Display(tkwin), RasterPtr->pm, d, RasterPtr->copyGC,
-		       0, 0, winwid, winhgt,
-		       RasterPtr->borderWidth, RasterPtr->borderWidth);
+		       cx0, cy0, cx1 - cx0, cy1 - cy0,
+		       RasterPtr->borderWidth + cx0,
+		       RasterPtr->borderWidth + cy0);
 	}
+    }
 
-	/*
-	 * If double-buffered, copy to the screen and release the pixmap.
-	 */
+    /*
+     * If double-buffered, copy to the screen and release the pixmap.
+     */
 
-	if (RasterPtr->doubleBuffer) {
-	    XCopyArea(Tk_Display(tkwin), pm, Tk_WindowId(tkwin),
-		      RasterPtr->copyGC,
-		      0, 0, Tk_Width(tkwin), Tk_Height(tkwin), 0, 0);
-	    /* 7/1/99 johnt - changed X Pixmap functions to TK functions for Windows portability */
-	    Tk_FreePixmap(Tk_Display(tkwin), pm);
-	}
+    if (pm != None) {
+	XCopyArea(Tk_Display(tkwin), pm, Tk_WindowId(tkwin),
+		  RasterPtr->copyGC,
+		  0, 0, Tk_Width(tkwin), Tk_Height(tkwin), 0, 0);
+	/* 7/1/99 johnt - changed X Pixmap functions to TK functions for Windows portability */
+	Tk_FreePixmap(Tk_Display(tkwin), pm);
     }
 
     RasterPtr->x0 = HIGH;
@@ -2597,6 +2612,8 @@ void SetRasterModifiedArea (raster, rx0, ry0, rx1, ry1)
 Drawable GetRasterDrawable (raster)
      Tk_Raster* raster;
 {
+   /* anything drawn from now on must come after the pending primitives */
+   RasterFlush ((Raster*)raster);
    return ((Raster*)raster)->pm;
 }
 
@@ -2619,6 +2636,153 @@ GC GetRasterGC (raster)
 }
 
 
+/*=======================================================================
+ *
+ *  Single points and lines are saved up and sent to the X server in one
+ *  request, which is done when the drawing environment changes, before
+ *  anything else draws on the pixmap and before the pixmap is displayed.
+ */
+
+static void RasterFlush (Raster *RasterPtr)
+{
+   int i, halfwid;
+
+   if (RasterPtr->nBatchPts) {
+      if (RasterPtr->batchWidth >= 2) {
+	 halfwid = RasterPtr->batchWidth/2;
+	 for (i = 0; i < RasterPtr->nBatchPts; i++) {
+	    XFillArc (RasterPtr->display, RasterPtr->pm, RasterPtr->batchGC,
+		      RasterPtr->batchPts[i].x - halfwid,
+		      RasterPtr->batchPts[i].y - halfwid,
+		      RasterPtr->batchWidth, RasterPtr->batchWidth,
+		      0, 360*64);
+	 }
+      } else {
+	 XDrawPoints (RasterPtr->display, RasterPtr->pm, RasterPtr->batchGC,
+		      RasterPtr->batchPts, RasterPtr->nBatchPts,
+		      CoordModeOrigin);
+      }
+      RasterPtr->nBatchPts = 0;
+   }
+
+   if (RasterPtr->nBatchSegs) {
+      XDrawSegments (RasterPtr->display, RasterPtr->pm, RasterPtr->batchGC,
+		     RasterPtr->batchSegs, RasterPtr->nBatchSegs);
+      RasterPtr->nBatchSegs = 0;
+   }
+}
+
+/*
+ * Returns non-zero when something drawn within rx0, ry0, rx1, ry1 (raster
+ * coordinates) would be clipped away entirely while scrolling.
+ */
+static int RasterOutsideStrip (Raster *RasterPtr,
+			       int rx0, int ry0, int rx1, int ry1)
+{
+   int lw;
+
+   if (!RasterPtr->stripActive ||
+       RasterPtr->currentDrawEnv->gcValues.function != GXcopy)
+      return 0;
+
+   lw = RasterPtr->currentDrawEnv->gcValues.line_width + 1;
+   return (rx0 > rx1 ? rx1 : rx0) - lw >= RasterPtr->sx1 ||
+	  (rx0 > rx1 ? rx0 : rx1) + lw <  RasterPtr->sx0 ||
+	  (ry0 > ry1 ? ry1 : ry0) - lw >= RasterPtr->sy1 ||
+	  (ry0 > ry1 ? ry0 : ry1) + lw <  RasterPtr->sy0;
+}
+
+/*
+ * Makes sure the pending primitives can be added to with the current
+ * drawing environment, flushing them if not.
+ */
+static void RasterBatchCheck (Raster *RasterPtr, int full)
+{
+   int width = RasterPtr->currentDrawEnv->gcValues.line_width;
+
+   if (full ||
+       ((RasterPtr->nBatchPts || RasterPtr->nBatchSegs) &&
+	(RasterPtr->batchGC != RasterPtr->drawGC ||
+	 RasterPtr->batchWidth != width))) {
+      RasterFlush (RasterPtr);
+   }
+   RasterPtr->batchGC = RasterPtr->drawGC;
+   RasterPtr->batchWidth = width;
+}
+
+static void RasterBatchPoint (Raster *RasterPtr, int rx, int ry)
+{
+   if (RasterOutsideStrip (RasterPtr, rx, ry, rx, ry))
+      return;
+
+   RasterBatchCheck (RasterPtr, RasterPtr->nBatchPts == RASTER_BATCH);
+   RasterPtr->batchPts[RasterPtr->nBatchPts].x = rx;
+   RasterPtr->batchPts[RasterPtr->nBatchPts].y = ry;
+   RasterPtr->nBatchPts++;
+}
+
+static void RasterBatchLine (Raster *RasterPtr,
+			     int rx1, int ry1, int rx2, int ry2)
+{
+   XSegment *seg;
+
+   if (RasterOutsideStrip (RasterPtr, rx1, ry1, rx2, ry2))
+      return;
+
+   RasterBatchCheck (RasterPtr, RasterPtr->nBatchSegs == RASTER_BATCH);
+   seg = &RasterPtr->batchSegs[RasterPtr->nBatchSegs++];
+   seg->x1 = rx1;
+   seg->y1 = ry1;
+   seg->x2 = rx2;
+   seg->y2 = ry2;
+}
+
+/*
+ * While scrolling, restricts drawing in copy mode to the newly exposed
+ * part of the pixmap, x0 <= x < x1 and y0 <= y < y1, so that replotting
+ * leaves the part that was copied alone. An empty area lifts the
+ * restriction. Drawing in other modes, such as the xor used for cursors,
+ * is not restricted as it is redrawn in full.
+ */
+static void RasterClipStrip (Raster *RasterPtr,
+			     int x0, int y0, int x1, int y1)
+{
+   Tcl_HashSearch search;
+   Tcl_HashEntry* entryPtr;
+   DrawEnvironment* drawEnvPtr;
+   XRectangle clip;
+
+   if (!RasterPtr->stripActive && (x1 <= x0 || y1 <= y0))
+      return;
+
+   RasterFlush (RasterPtr);
+
+   RasterPtr->stripActive = x1 > x0 && y1 > y0;
+   RasterPtr->sx0 = x0;
+   RasterPtr->sy0 = y0;
+   RasterPtr->sx1 = x1;
+   RasterPtr->sy1 = y1;
+   clip.x = x0;
+   clip.y = y0;
+   clip.width = x1 - x0;
+   clip.height = y1 - y0;
+
+   for (entryPtr = Tcl_FirstHashEntry (&RasterPtr->drawEnvTable, &search);
+	entryPtr != NULL;
+	entryPtr = Tcl_NextHashEntry (&search)) {
+      drawEnvPtr = (DrawEnvironment*) Tcl_GetHashValue (entryPtr);
+      if (drawEnvPtr->gcValues.function != GXcopy)
+	 continue;
+
+      if (RasterPtr->stripActive) {
+	 XSetClipRectangles (RasterPtr->display, drawEnvPtr->drawGC, 0, 0,
+			     &clip, 1, Unsorted);
+      } else {
+	 XSetClipMask (RasterPtr->display, drawEnvPtr->drawGC, None);
+      }
+   }
+}
+
 /*=======================================================================
  *
  *  Below are the functions that implement the built-in drawing primitives
@@ -2646,16 +2810,37 @@ void RasterDrawPoints (raster, coord, npts)
 
    if (npts < 1) return;
 
-   for (i = 0, ptptr = pt = (XPoint*) malloc (sizeof (XPoint)*npts);
-	i < n; i+=2, ptptr++) {
+   /* plots often draw one point at a time */
+   if (npts == 1) {
+      WorldToRaster (raster, coord [0], coord [1], &rx, &ry);
+      RasterBatchPoint ((Raster*) raster, rx, ry);
+      SetRasterModifiedArea (raster, rx, ry, rx, ry);
+      return;
+   }
+
+   if (NULL == (ptptr = pt = (XPoint*) malloc (sizeof (XPoint)*npts)))
+      return;
+   for (i = 0; i < n; i+=2) {
       WorldToRaster (raster, coord [i], coord [i+1], &rx, &ry);
       if (rx < minx) minx = rx;
       if (rx > maxx) maxx = rx;
       if (ry < miny) miny = ry;
       if (ry > maxy) maxy = ry;
+      /* far off the raster, and would wrap round in an XPoint */
+      if (rx < SHRT_MIN || rx > SHRT_MAX || ry < SHRT_MIN || ry > SHRT_MAX)
+	 continue;
       ptptr->x = rx;
       ptptr->y = ry;
+      ptptr++;
    }
+   npts = ptptr - pt;
+
+   /*
+    * many points may share a pixel when zoomed out, but drawing them
+    * twice matters for functions such as xor
+    */
+   if (((Raster*) raster)->currentDrawEnv->gcValues.function == GXcopy)
+      npts = decimate_points (pt, npts, ((Raster*) raster)->height);
 
    if (pointwid >= 2) {
       int halfwid = pointwid/2;
@@ -2679,10 +2864,6 @@ void RasterDrawPoint (Tk_Raster *raster,
  *  Draws the point x, y
  */
 {
-   int pointwid = ((Raster*) raster)->currentDrawEnv->gcValues.line_width ;
-   GC gc = GetRasterGC (raster);
-   Drawable d = GetRasterDrawable (raster);
-   Display * dsp = GetRasterDisplay (raster);
    int rx, ry;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
 
@@ -2692,18 +2873,11 @@ void RasterDrawPoint (Tk_Raster *raster,
    if (ry < miny) miny = ry;
    if (ry > maxy) maxy = ry;
 
-   if (pointwid >= 2) {
-      int halfwid = pointwid/2;
-      XFillArc (dsp, d, gc, rx - halfwid, ry - halfwid,
-		pointwid, pointwid, 0, 360*64);
-   } else {
-      XDrawPoint (dsp, d, gc, rx, ry);
-   }
+   RasterBatchPoint ((Raster*) raster, rx, ry);
 
 #ifdef DEBUG
    printf("x %d y %d rx %d ry %d \n", x, y, rx, ry);
 #endif
-   /* XDrawPoint (dsp, d, gc, rx, ry); */
 
    SetRasterModifiedArea (raster, minx, miny, maxx, maxy);
 }
@@ -2737,10 +2911,7 @@ RasterDrawLine (Tk_Raster *raster,
    if (ry2 < miny) miny = ry2;
    if (ry2 > maxy) maxy = ry2;
 
-   XDrawLine (GetRasterDisplay (raster),
-	      GetRasterDrawable (raster),
-	      GetRasterGC (raster),
-	      rx1, ry1, rx2, ry2);
+   RasterBatchLine ((Raster*) raster, rx1, ry1, rx2, ry2);
 
    /* printf("minx %d miny %d maxx %d maxy %d\n", minx, miny, maxx, maxy); */
    SetRasterModifiedArea (raster, minx, miny, maxx, maxy);
@@ -2775,6 +2946,10 @@ void RasterDrawLines (raster, coord, npts)
       ptptr->y = ry;
    }
 
+   /* at most four points per pixel column are needed to draw the line */
+   if (((Raster*) raster)->currentDrawEnv->gcValues.function == GXcopy)
+      npts = decimate_lines (pt, npts);
+
    /*
     * fix to deal with x servers which can't cope with more than 2^16 lines
     */
@@ -3091,6 +3266,8 @@ RasterClear(Raster *RasterPtr)
 			     RASTER_INIT, 0, 0, 0, 0);
     }
 
+    RasterPtr->nBatchPts = RasterPtr->nBatchSegs = 0;
+
     /* set the crosshair flag to be "not visible" */
     Tcl_VarEval(RasterPtr->interp, "unset_raster_xh ",
 		Tk_PathName(RasterPtr->tkwin), NULL);
@@ -3111,7 +3288,7 @@ void
 RasterClearArea(Raster *RasterPtr,
 		int x0,	int y0, int x1, int y1)
 {
-
+    RasterFlush(RasterPtr);
     XFillRectangle (RasterPtr->display, RasterPtr->pm, RasterPtr->copyGC,
 		       x0, y0, x1, y1);
     arrangeDisplay (RasterPtr, LOW, LOW, HIGH, HIGH, RASTER_DRAW_PIXMAP);
@@ -3235,6 +3412,10 @@ RasterScrollY(Raster *raster,
     /*
      * because we display the results "upside down", need to subtract the
      * max y in world coords. Need to add 1 because I plot to max y + 1
+     *
+     * This must stay a full replot: spin draws its vertical cursors with
+     * xor over the whole height, so replotting only the exposed sliver
+     * would erase and redraw them there, leaving them missing.
      */
     if (raster->plot_func) {
 	raster->plot_func(raster, Tk_PathName(raster->tkwin),
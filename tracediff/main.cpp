@@ -96,6 +96,107 @@ void PrintUsage( tracediff_t& td )
 
 
 
+//----------------
+// Batch Handling
+//----------------
+
+// Inputs are gathered and processed in batches of up to BATCHSIZE so the
+// references are shared by every input in the batch, while only a bounded
+// number of traces and experiment files are held open at once.
+const int BATCHSIZE = 32;
+
+struct DiffBatch
+{
+    int             Count;
+    char            Name[BATCHSIZE][BUFSIZE];
+    Exp_info*       ExpFile[BATCHSIZE];
+    mutlib_trace_t  Input[BATCHSIZE];
+    bool            Quiet;
+    bool            OutputDifferenceTrace;
+};
+
+
+
+void FreeBatch( DiffBatch& b )
+{
+    for( int n=0; n<b.Count; n++ )
+    {
+        if( b.ExpFile[n] )      exp_destroy_info( b.ExpFile[n] );
+        if( b.Input[n].Trace )  read_deallocate( b.Input[n].Trace );
+    }
+    b.Count = 0;
+}
+
+
+
+// Called by TraceDiffExecuteBatch() once each input has been processed
+void ReportInput( tracediff_t* td, int n, void* data )
+{
+    char       pBuffer[BUFSIZE];
+    DiffBatch& b = *static_cast<DiffBatch*>(data);
+
+
+
+    // Tell user what we've done
+    if( !b.Quiet )
+    {
+        std::fprintf( stdout, "Processing: %s\n", b.Name[n] );
+        std::fflush( stdout );
+    }
+    if( TraceDiffGetResultCode(td) )
+    {
+        std::fprintf( stderr, "%s", TraceDiffGetResultString(td) );
+        std::fflush( stderr );
+        return;
+    }
+
+
+
+    // Output Difference Trace
+    if( b.OutputDifferenceTrace )
+    {
+        Read* pDiff = TraceDiffGetDifference( td, 0, 0 );
+        std::strcpy( pBuffer, b.Name[n] );
+        ReplaceExtension( pBuffer, "_diff.ztr" );
+        int retval = write_reading( pBuffer, pDiff, TT_ZTR );
+        if( retval < 0 )
+        {
+            std::fprintf( stderr, "Unable to write out difference trace %s.\n", pBuffer );
+            std::fflush( stderr );
+        }
+    }
+
+
+
+    // Output results
+    int nTags = TraceDiffGetTagCount( td );
+    for( int i=0; i<nTags; i++ )
+    {
+        // Write mutation tags to experiment file
+        mutlib_tag_t* pTag = TraceDiffGetTag( td, i );
+        assert(pTag != NULL);
+        char c = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
+        std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, c, *pTag->Position,
+                      *pTag->Position, pTag->Comment );
+        exp_put_str(b.ExpFile[n], EFLT_TG, pBuffer, std::strlen(pBuffer) );
+        if( !b.Quiet )
+        {
+            std::fprintf( stdout, "%s %5d %s\n", pTag->Type, *pTag->Position, pTag->Comment );
+            std::fflush( stdout );
+        }
+    }
+}
+
+
+
+void RunBatch( tracediff_t& td, DiffBatch& b )
+{
+    TraceDiffExecuteBatch( &td, TRACEDIFF_ALGORITHM_DEFAULT, b.Input, b.Count, ReportInput, &b );
+    FreeBatch( b );
+}
+
+
+
 //-----------
 // Tracediff
 //-----------
@@ -126,7 +227,9 @@ int main( int argc, char* argv[] )
     double          nPeakWidthMaximum      = -1.0;
     double          nNoiseWindowLength     = -1.0;
     double          nNoiseThreshold        = -1.0;
+    DiffBatch       Batch;
     TraceDiffInit( &td );
+    Batch.Count = 0;
 
 
 
@@ -309,7 +412,9 @@ int main( int argc, char* argv[] )
 
 
 
-        // File processing loop
+        // File processing loop, inputs are processed a batch at a time
+        Batch.Quiet                 = bQuiet;
+        Batch.OutputDifferenceTrace = bOutputDifferenceTrace;
         for( n=0; n<FileList.Length(); n++ )
         {
             // Cleanup from previous iteration
@@ -327,15 +432,6 @@ int main( int argc, char* argv[] )
 
 
 
-            // Tell user what we're doing
-            if( !bQuiet )
-            {
-                std::fprintf( stdout, "Processing: %s\n", p );
-                std::fflush( stdout );
-            }
-
-
-
             // Open experiment file
             pExpFile = exp_read_info( p );
             if( !pExpFile )
@@ -442,56 +538,21 @@ int main( int argc, char* argv[] )
 
 
 
-            // Initialise the algorithm
-            TraceDiffSetInput( &td, pInputTrace, nStrand, nInputClipL, nInputClipR );
-
-
-
-            // Execute the algorithm
-            TraceDiffExecute( &td, TRACEDIFF_ALGORITHM_DEFAULT );
-            if( TraceDiffGetResultCode(&td) )
-            {
-                std::fprintf( stderr, "%s", TraceDiffGetResultString(&td) );
-                std::fflush( stderr );
-                continue;
-            }
-
-
-
-            // Output Difference Trace
-            if( bOutputDifferenceTrace )
-            {
-                Read* pDiff = TraceDiffGetDifference( &td, 0, 0 );
-                std::strcpy( pBuffer, p );
-                ReplaceExtension( pBuffer, "_diff.ztr" );
-                int retval = write_reading( pBuffer, pDiff, TT_ZTR );
-                if( retval < 0 )
-                {
-                    std::fprintf( stderr, "Unable to write out difference trace %s.\n", pBuffer );
-                    std::fflush( stderr );
-                }
-            }
-
-
-
-            // Output results
-            int nTags = TraceDiffGetTagCount( &td );
-            for( int i=0; i<nTags; i++ )
-            {
-                // Write mutation tags to experiment file
-                mutlib_tag_t* pTag = TraceDiffGetTag( &td, i );
-                assert(pTag != NULL);
-                char c = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
-                std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, c, *pTag->Position,
-                              *pTag->Position, pTag->Comment );
-                exp_put_str(pExpFile, EFLT_TG, pBuffer, std::strlen(pBuffer) );
-                if( !bQuiet )
-                {
-                    std::fprintf( stdout, "%s %5d %s\n", pTag->Type, *pTag->Position, pTag->Comment );
-                    std::fflush( stdout );
-                }
-            }
+            // Queue the input, the batch now owns the experiment file and trace
+            int k = Batch.Count++;
+            std::strncpy( Batch.Name[k], p, BUFSIZE-1 );
+            Batch.Name[k][BUFSIZE-1] = 0;
+            Batch.ExpFile[k]      = pExpFile;
+            Batch.Input[k].Trace  = pInputTrace;
+            Batch.Input[k].Strand = nStrand;
+            Batch.Input[k].ClipL  = nInputClipL;
+            Batch.Input[k].ClipR  = nInputClipR;
+            pExpFile    = 0;
+            pInputTrace = 0;
+            if( Batch.Count == BATCHSIZE )
+                RunBatch( td, Batch );
         }
+        RunBatch( td, Batch );
     }
     catch( std::bad_alloc& )
     {
@@ -515,6 +576,7 @@ int main( int argc, char* argv[] )
     if(pInputTrace)  read_deallocate(pInputTrace);
     if(pRefTrace[0]) read_deallocate(pRefTrace[0]);
     if(pRefTrace[1]) read_deallocate(pRefTrace[1]);
+    FreeBatch( Batch );
     TraceDiffDestroy( &td );
     return 0;
 }
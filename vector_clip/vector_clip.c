@@ -31,6 +31,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "misc.h" 
 #include "dna_utils.h"
@@ -420,6 +422,296 @@ void store_hash (
     }
 }
 
+/************************************************************/
+
+/*
+ * Vector indices.
+ *
+ * Hashing a vector (hash_seq/hash_seq8 followed by store_hash) used to be
+ * redone every time the vector file changed between consecutive readings,
+ * so a plate containing interleaved vectors rehashed on almost every
+ * reading. We now keep one index per vector file and word encoding for the
+ * whole run. With -x the indices are also saved to (and reloaded from) a
+ * file so that subsequent runs against the same vector library start with
+ * them already built. Saved entries are ignored if the vector file has been
+ * modified since.
+ */
+
+#define VI_HASH  1	/* hash_seq() words of word_length */
+#define VI_HASH8 2	/* hash_seq8() 8-mers */
+#define VI_MAGIC 0x56434958 /* "VCIX" */
+
+typedef struct vector_index_ {
+    char   *file_name;
+    long    mtime;
+    int     type;		/* VI_HASH or VI_HASH8 */
+    int     word_length;
+    int     size_hash;
+    int     length;
+    char   *seq;
+    int    *hash_values;	/* as left by store_hash */
+    int    *last_word;
+    int    *word_count;
+} Vector_index;
+
+typedef struct vector_indices_ {
+    Vector_index *index;
+    int           number;
+    int           allocated;
+    int           modified;
+} Vector_indices;
+
+static long vector_file_mtime ( char *file_name ) {
+    struct stat st;
+
+    if ( stat ( file_name, &st ) ) return -1;
+    return (long) st.st_mtime;
+}
+
+static void free_vector_index ( Vector_index *vx ) {
+    if ( vx->file_name )   xfree ( vx->file_name );
+    if ( vx->seq )         xfree ( vx->seq );
+    if ( vx->hash_values ) xfree ( vx->hash_values );
+    if ( vx->last_word )   xfree ( vx->last_word );
+    if ( vx->word_count )  xfree ( vx->word_count );
+}
+
+void free_vector_indices ( Vector_indices *vi ) {
+    int i;
+
+    for ( i = 0; i < vi->number; i++ ) free_vector_index ( &vi->index[i] );
+    if ( vi->index ) xfree ( vi->index );
+    vi->index = NULL;
+    vi->number = vi->allocated = 0;
+}
+
+static Vector_index *new_vector_index ( Vector_indices *vi ) {
+    Vector_index *vx;
+
+    if ( vi->number == vi->allocated ) {
+	int n = vi->allocated ? vi->allocated * 2 : 16;
+	if ( NULL == (vx = (Vector_index *) xrealloc ( vi->index,
+					      sizeof(Vector_index) * n )))
+	    return NULL;
+	vi->index = vx;
+	vi->allocated = n;
+    }
+    vx = &vi->index[vi->number++];
+    memset ( vx, 0, sizeof(*vx) );
+    return vx;
+}
+
+/*
+ * Returns the index for vector file_name, building it if necessary.
+ * vector_seq (max_vector long) is used as a scratch buffer for reading the
+ * vector. On failure NULL is returned and *err is set to the vep_error
+ * number to report.
+ */
+Vector_index *get_vector_index ( Vector_indices *vi, char *file_name,
+				 int type, int word_length, int size_hash,
+				 char *vector_seq, int max_vector, int *err ) {
+    Vector_index *vx;
+    FILE *vf;
+    int i, vector_length, ret;
+
+    for ( i = 0; i < vi->number; i++ ) {
+	vx = &vi->index[i];
+	if ( vx->type == type && vx->word_length == word_length &&
+	     vx->size_hash == size_hash && 0 == strcmp ( vx->file_name, file_name ))
+	    return vx;
+    }
+
+    vf = fopen ( file_name, "r" );
+    if ( vf == NULL ) {
+	*err = 7;
+	return NULL;
+    }
+    ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf );
+    fclose ( vf );
+    if ( ret ) {
+	*err = 9;
+	return NULL;
+    }
+
+    *err = 11;
+    if ( NULL == (vx = new_vector_index ( vi ))) return NULL;
+    vx->mtime = vector_file_mtime ( file_name );
+    vx->type = type;
+    vx->word_length = word_length;
+    vx->size_hash = size_hash;
+    vx->length = vector_length;
+    if ( NULL == (vx->file_name = (char *) xmalloc ( strlen(file_name) + 1 )) ||
+	 NULL == (vx->seq = (char *) xmalloc ( vector_length + 1 )) ||
+	 NULL == (vx->hash_values = (int *) xmalloc ( sizeof(int) * (vector_length + 1) )) ||
+	 NULL == (vx->last_word = (int *) xmalloc ( sizeof(int) * size_hash )) ||
+	 NULL == (vx->word_count = (int *) xmalloc ( sizeof(int) * size_hash ))) {
+	free_vector_index ( vx );
+	vi->number--;
+	return NULL;
+    }
+    strcpy ( vx->file_name, file_name );
+    memcpy ( vx->seq, vector_seq, vector_length );
+    vx->seq[vector_length] = '\0';
+
+    if ( type == VI_HASH8 )
+	ret = hash_seq8 ( vx->seq, vx->hash_values, vector_length );
+    else
+	ret = hash_seq ( word_length, vx->seq, vx->hash_values, vector_length );
+    if ( ret != 0 ) {
+	free_vector_index ( vx );
+	vi->number--;
+	return NULL;
+    }
+
+    (void) store_hash ( vx->hash_values, vector_length, vx->last_word,
+		        vx->word_count, word_length, size_hash );
+
+    vi->modified = 1;
+    return vx;
+}
+
+/*
+ * Checks that the word chains of a loaded index stay inside the vector:
+ * every last_word[] and every link followed through hash_values[] must be
+ * the start of a word in the sequence, and each chain must run strictly
+ * backwards so that do_hash can never read outside (or loop within) it.
+ * Returns 0 if the index is usable, -1 otherwise.
+ */
+static int check_vector_index ( Vector_index *vx ) {
+    int n, k, pos, next, words, total;
+
+    if ( vx->type != VI_HASH && vx->type != VI_HASH8 ) return -1;
+    if ( vx->word_length <= 0 ) return -1;
+
+    words = vx->length - vx->word_length + 1;
+    total = 0;
+    for ( n = 0; n < vx->size_hash; n++ ) {
+	if ( vx->word_count[n] < 0 ) return -1;
+	if ( vx->word_count[n] == 0 ) continue;
+	total += vx->word_count[n];
+	if ( total > words ) return -1;
+	pos = vx->last_word[n];
+	if ( pos < 0 || pos >= words ) return -1;
+	for ( k = 1; k < vx->word_count[n]; k++ ) {
+	    next = vx->hash_values[pos];
+	    if ( next < 0 || next >= pos ) return -1;
+	    pos = next;
+	}
+    }
+    return 0;
+}
+
+/*
+ * Loads previously saved vector indices. A missing file is not an error.
+ * Entries for vectors longer than max_vector are dropped: the search
+ * arrays set up by init_hash/init_hash8 are only max_vector long, so such
+ * a vector must be reread (and rejected) exactly as if it had no index.
+ * Returns 0 for success, -1 for a corrupt or unreadable file.
+ */
+int read_vector_indices ( char *fn, Vector_indices *vi, int max_vector ) {
+    FILE *fp;
+    Vector_index *vx;
+    int magic, hdr[5];
+    long mtime;
+
+    if ( NULL == (fp = fopen ( fn, "rb" ))) return 0;
+
+    if ( 1 != fread ( &magic, sizeof(int), 1, fp ) || magic != VI_MAGIC ) {
+	fclose ( fp );
+	return -1;
+    }
+
+    /* name_len, type, word_length, size_hash, length */
+    while ( 5 == fread ( hdr, sizeof(int), 5, fp )) {
+	if ( hdr[0] <= 0 || hdr[0] > FILENAME_MAX || hdr[3] <= 0 || hdr[4] < 0 )
+	    break;
+	if ( NULL == (vx = new_vector_index ( vi ))) break;
+	vx->type = hdr[1];
+	vx->word_length = hdr[2];
+	vx->size_hash = hdr[3];
+	vx->length = hdr[4];
+	if ( NULL == (vx->file_name = (char *) xmalloc ( hdr[0] + 1 )) ||
+	     NULL == (vx->seq = (char *) xmalloc ( vx->length + 1 )) ||
+	     NULL == (vx->hash_values = (int *) xmalloc ( sizeof(int) * (vx->length + 1) )) ||
+	     NULL == (vx->last_word = (int *) xmalloc ( sizeof(int) * vx->size_hash )) ||
+	     NULL == (vx->word_count = (int *) xmalloc ( sizeof(int) * vx->size_hash )) ||
+	     hdr[0] != fread ( vx->file_name, 1, hdr[0], fp ) ||
+	     1 != fread ( &mtime, sizeof(long), 1, fp ) ||
+	     vx->length != fread ( vx->seq, 1, vx->length, fp ) ||
+	     vx->length != fread ( vx->hash_values, sizeof(int), vx->length, fp ) ||
+	     vx->size_hash != fread ( vx->last_word, sizeof(int), vx->size_hash, fp ) ||
+	     vx->size_hash != fread ( vx->word_count, sizeof(int), vx->size_hash, fp )) {
+	    free_vector_index ( vx );
+	    vi->number--;
+	    fclose ( fp );
+	    return -1;
+	}
+	vx->file_name[hdr[0]] = '\0';
+	vx->seq[vx->length] = '\0';
+	vx->mtime = mtime;
+
+	if ( check_vector_index ( vx )) {
+	    free_vector_index ( vx );
+	    vi->number--;
+	    fclose ( fp );
+	    return -1;
+	}
+
+	/* stale: the vector has changed (or gone) since it was indexed,
+	   or is too long for this run's search arrays */
+	if ( vx->length > max_vector ||
+	     mtime != vector_file_mtime ( vx->file_name )) {
+	    free_vector_index ( vx );
+	    vi->number--;
+	    vi->modified = 1;
+	}
+    }
+
+    fclose ( fp );
+    return 0;
+}
+
+/*
+ * Saves the vector indices if any have been added since they were loaded.
+ * Returns 0 for success, -1 for failure.
+ */
+int write_vector_indices ( char *fn, Vector_indices *vi ) {
+    FILE *fp;
+    Vector_index *vx;
+    int i, magic = VI_MAGIC, hdr[5];
+
+    if ( !vi->modified ) return 0;
+
+    if ( NULL == (fp = fopen ( fn, "wb" ))) return -1;
+
+    if ( 1 != fwrite ( &magic, sizeof(int), 1, fp )) {
+	fclose ( fp );
+	return -1;
+    }
+    for ( i = 0; i < vi->number; i++ ) {
+	vx = &vi->index[i];
+	hdr[0] = strlen ( vx->file_name );
+	hdr[1] = vx->type;
+	hdr[2] = vx->word_length;
+	hdr[3] = vx->size_hash;
+	hdr[4] = vx->length;
+	if ( 5 != fwrite ( hdr, sizeof(int), 5, fp ) ||
+	     hdr[0] != fwrite ( vx->file_name, 1, hdr[0], fp ) ||
+	     1 != fwrite ( &vx->mtime, sizeof(long), 1, fp ) ||
+	     vx->length != fwrite ( vx->seq, 1, vx->length, fp ) ||
+	     vx->length != fwrite ( vx->hash_values, sizeof(int), vx->length, fp ) ||
+	     vx->size_hash != fwrite ( vx->last_word, sizeof(int), vx->size_hash, fp ) ||
+	     vx->size_hash != fwrite ( vx->word_count, sizeof(int), vx->size_hash, fp )) {
+	    fclose ( fp );
+	    return -1;
+	}
+    }
+
+    if ( fclose ( fp )) return -1;
+    vi->modified = 0;
+    return 0;
+}
+
 /***************************************************************************/
 
 /*
@@ -2114,7 +2406,7 @@ int do_it_tr ( char *vector_seq, int max_vector,
 int do_it_cv ( char *vector_seq, int max_vector,
 	       FILE *fp_i, FILE *fp_p, FILE *fp_f,
 	       int word_length, int num_diags, double diag_score, double max_prob,
-	       int tmode) {
+	       int tmode, Vector_indices *vi) {
 
     char file_name[FILENAME_MAX+1],*cp, *seq;
 
@@ -2129,8 +2421,7 @@ int do_it_cv ( char *vector_seq, int max_vector,
     int vector_length = 0, x, y, ret, eret;
     DI *hist;
     char vector_file_name[FILENAME_MAX+1], *vfn;
-    char prev_vector_file_name[FILENAME_MAX+1];
-    FILE *vf;
+    Vector_index *vx;
     int sl, sr; /* sequencing vector left and right */
     double score_3f, score_f, score_3r, score_r;
     int lg, rg, xf=0, xr=0, cl=0, cr=0;
@@ -2149,8 +2440,6 @@ int do_it_cv ( char *vector_seq, int max_vector,
 			    expected_scores )) return -1;
     }
 
-    prev_vector_file_name[0] = '\0';
-
     if ( init_hash ( word_length, max_vector, MAX_READ,
 	     &hash_values1, &last_word, &word_count,
 		     &hash_values2, &diag, &hist, &size_hash, &line ))
@@ -2221,39 +2510,19 @@ int do_it_cv ( char *vector_seq, int max_vector,
 		}
 
 
-		/* we only get the vector seq if it is different from
-		   the previous one.
+		/* each vector is only read and hashed once per run
+		   (or not at all if it is in the saved indices).
 		*/
 
-		if ( strcmp ( vector_file_name, prev_vector_file_name )) {
-
-		    vf = fopen(vector_file_name, "r");
-		    if (vf == NULL ) {
-			eret =  vep_error ( fp_f, file_name, 7 );
-			exp_destroy_info ( e );
-			continue;
-		    }
-
-		    ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
-		    fclose(vf);
-		    if ( ret ) {
-			eret =  vep_error ( fp_f, file_name, 9 );
-			exp_destroy_info ( e );
-			continue;
-		    }
-		    strcpy( prev_vector_file_name, vector_file_name );
-
-
-		    if ( hash_seq ( word_length, vector_seq, hash_values1, 
-				   vector_length )  != 0 ) {
-		      eret =  vep_error ( fp_f, file_name, 11 );
-		      exp_destroy_info ( e );
-		      continue;
-		    }
-
-		    (void) store_hash ( hash_values1, vector_length, last_word,
-				       word_count, word_length, size_hash);
+		if ( NULL == (vx = get_vector_index ( vi, vector_file_name,
+						      VI_HASH, word_length,
+						      size_hash, vector_seq,
+						      max_vector, &ret ))) {
+		    eret =  vep_error ( fp_f, file_name, ret );
+		    exp_destroy_info ( e );
+		    continue;
 		}
+		vector_length = vx->length;
 
 		/* we have to search both strands so we call do_hash
 		   with the read in its original sense, then its
@@ -2291,10 +2560,10 @@ int do_it_cv ( char *vector_seq, int max_vector,
 		    continue;
 		}
 		ret = do_hash ( vector_length, rg-lg+1,
-			        hash_values1, last_word,
-			        word_count, hash_values2,
+			        vx->hash_values, vx->last_word,
+			        vx->word_count, hash_values2,
 			        diag, line, size_hash, hist, word_length,
-			        vector_seq, &seq[lg],
+			        vx->seq, &seq[lg],
 			        diag_score, num_diags, expected_scores, max_prob,
 			        CLONING_VECTOR,
 			        &x, &y, &score_3f);
@@ -2313,10 +2582,10 @@ int do_it_cv ( char *vector_seq, int max_vector,
 	        complement_seq ( &seq[lg], rg-lg+1);
 
 		ret = do_hash ( vector_length, rg-lg+1,
-			        hash_values1, last_word,
-			        word_count, hash_values2,
+			        vx->hash_values, vx->last_word,
+			        vx->word_count, hash_values2,
 			        diag, line, size_hash, hist, word_length,
-			        vector_seq, &seq[lg],
+			        vx->seq, &seq[lg],
 			        diag_score, num_diags, expected_scores, max_prob,
 			        CLONING_VECTOR,
 			        &x, &y, &score_3r);
@@ -2692,7 +2961,7 @@ int do_hash_vr (   int seq1_len, int seq2_len,
 int do_it_vr ( char *vector_seq, int max_vector,
 	       FILE *fp_i, FILE *fp_p, FILE *fp_f,
 	       int word_length, int min_match,
-	       int tmode) {
+	       int tmode, Vector_indices *vi) {
 
     char file_name[FILENAME_MAX+1],*cp, *seq;
 
@@ -2705,8 +2974,7 @@ int do_it_vr ( char *vector_seq, int max_vector,
     int *diag;
     int vector_length = 0, x, y, ret, eret;
     char vector_file_name[FILENAME_MAX+1], *vfn;
-    char prev_vector_file_name[FILENAME_MAX+1];
-    FILE *vf;
+    Vector_index *vx;
     int sl, sr; /* sequencing vector left and right */
     int score, score_f, score_r;
     int lg, rg, xf=0, xr=0, yf=0, yr=0;
@@ -2719,7 +2987,6 @@ int do_it_vr ( char *vector_seq, int max_vector,
 
 
     if ( min_match < 8 ) min_match = 8;
-    prev_vector_file_name[0] = '\0';
 
     if ( init_hash8 ( max_vector, MAX_READ,
 		     &hash_values1, &last_word, &word_count,
@@ -2803,38 +3070,19 @@ int do_it_vr ( char *vector_seq, int max_vector,
 		  }
 		}
 
-		/* we only get the vector seq if it is different from
-		   the previous one.
+		/* each vector is only read and hashed once per run
+		   (or not at all if it is in the saved indices).
 		*/
 
-		if ( strcmp ( vector_file_name, prev_vector_file_name )) {
-		    vf = fopen(vector_file_name, "r");
-		    if (vf == NULL ) {
-			eret =  vep_error ( fp_f, file_name, 7 );
-			exp_destroy_info ( e );
-			continue;
-		    }
-
-		    ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
-		    fclose(vf);
-/* 		    printf("vector length %d\n",vector_length); */
-		    if ( ret ) {
-			eret =  vep_error ( fp_f, file_name, 9 );
-			exp_destroy_info ( e );
-			continue;
-		    }
-		    strcpy( prev_vector_file_name, vector_file_name );
-
-		    if ( hash_seq8 ( vector_seq, hash_values1, vector_length )  != 0 ) {
-		      eret =  vep_error ( fp_f, file_name, 11 );
-		      exp_destroy_info ( e );
-		      continue;
-		    }
-
-		    (void) store_hash ( hash_values1, vector_length, last_word, 
-				       word_count,
-			    word_length, size_hash);
-		  }
+		if ( NULL == (vx = get_vector_index ( vi, vector_file_name,
+						      VI_HASH8, word_length,
+						      size_hash, vector_seq,
+						      max_vector, &ret ))) {
+		    eret =  vep_error ( fp_f, file_name, ret );
+		    exp_destroy_info ( e );
+		    continue;
+		}
+		vector_length = vx->length;
 
 		/* we have to search both strands so we call do_hash
 		   with the read in its original sense, then its
@@ -2858,9 +3106,9 @@ int do_it_vr ( char *vector_seq, int max_vector,
 		    continue;
 		}
 		ret = do_hash_vr ( vector_length, rg-lg+1,
-			        hash_values1, last_word,
-			        word_count, hash_values2, diag, 
-			        vector_seq, &seq[lg],
+			        vx->hash_values, vx->last_word,
+			        vx->word_count, hash_values2, diag,
+			        vx->seq, &seq[lg],
 			        min_match, 
 			        &x, &y, &score);
 		if ( ret < 0 ) {
@@ -2881,9 +3129,9 @@ int do_it_vr ( char *vector_seq, int max_vector,
 		    complement_seq ( &seq[lg], rg-lg+1);
 
 		    ret = do_hash_vr ( vector_length, rg-lg+1,
-			        hash_values1, last_word,
-			        word_count, hash_values2, diag,
-			        vector_seq, &seq[lg],
+			        vx->hash_values, vx->last_word,
+			        vx->word_count, hash_values2, diag,
+			        vx->seq, &seq[lg],
 			        min_match,
 			        &x, &y, &score);
 		    if ( ret < 0 ) {
@@ -3393,7 +3641,7 @@ void usage(int word_length, int num_diags, double diag_score, int min_match,
 	    "    [-m default 5' position]         [-t test only]\n"
 	    "    [-M Max vector length (%d)]  [-P max Probability]\n"
 	    "    [-v vector_primer filename]      [-i vector_primer filename]\n"
-	    "    [-V vector_primer length]\n"
+	    "    [-V vector_primer length]        [-x vector index filename]\n"
 
 	    "    [-p passed fofn]                 [-f failed fofn]\n",
 	     word_length, num_diags, diag_score, min_match, cut_score_5, cut_score_3,
@@ -3414,12 +3662,14 @@ int main(int argc, char **argv) {
     double cut_score_3, cut_score_3_d;
     double max_prob, max_prob_d;
     int mode,i,tmode,rmode;
-    char *fofn_p, *fofn_f, *fofn_i, *vf, *vector_seq;
+    char *fofn_p, *fofn_f, *fofn_i, *vf, *vector_seq, *index_fn;
     char expanded_fn[FILENAME_MAX+1];
     FILE *fp_p, *fp_f, *fp_i, *fp_vf;
     Vector_specs *v = NULL;
+    Vector_indices vi;
 
-    fofn_p = fofn_f = fofn_i = vf = NULL;
+    fofn_p = fofn_f = fofn_i = vf = index_fn = NULL;
+    memset ( &vi, 0, sizeof(vi) );
     fp_p = fp_f = fp_i = fp_vf = NULL;
 
     max_vector = MAX_VECTOR_D;
@@ -3445,7 +3695,7 @@ int main(int argc, char **argv) {
     set_dna_lookup();
     set_char_set(1); /* FIXME DNA*/
 
-    while ((c = getopt(argc, argv, "w:n:d:l:L:R:p:f:m:M:P:v:V:i:schrtT")) != -1) {
+    while ((c = getopt(argc, argv, "w:n:d:l:L:R:p:f:m:M:P:v:V:i:x:schrtT")) != -1) {
 	switch (c) {
 	case 'w':
 	    word_length = atoi(optarg);
@@ -3510,6 +3760,9 @@ int main(int argc, char **argv) {
 	case 'f':
 	    fofn_f = optarg;
 	    break;
+	case 'x':
+	    index_fn = optarg;
+	    break;
 	default:
 	    usage(word_length_d, num_diags_d, diag_score_d, min_match_d, (int)cut_score_5_d,(int)cut_score_3_d);
 	}
@@ -3565,6 +3818,13 @@ int main(int argc, char **argv) {
     }
 
 
+    if ( index_fn ) {
+      if ( read_vector_indices ( index_fn, &vi, max_vector ) ) {
+	fprintf(stderr, "Ignoring unreadable vector index file %s\n", index_fn);
+	free_vector_indices ( &vi );
+      }
+    }
+
     if ( ! (vector_seq = (char *) xmalloc ( sizeof(char)*max_vector ))) return -1;
 
     if ( mode == HGMP ) {
@@ -3586,7 +3846,7 @@ int main(int argc, char **argv) {
     else if ( mode == CLONING_VECTOR ) {
 
 	i = do_it_cv ( vector_seq, max_vector, fp_i, fp_p, fp_f, word_length, num_diags, 
-		       diag_score, max_prob, tmode );
+		       diag_score, max_prob, tmode, &vi );
 
     }
 
@@ -3600,10 +3860,13 @@ int main(int argc, char **argv) {
     else if ( mode == VECTOR_REARRANGEMENT ) {
 
 	i = do_it_vr ( vector_seq, max_vector, fp_i, fp_p, fp_f, word_length, min_match,
-		       tmode );
+		       tmode, &vi );
     }
 
     fprintf(stdout,"\n");
+    if ( index_fn && write_vector_indices ( index_fn, &vi ) )
+	fprintf(stderr, "Failed to write vector index file %s\n", index_fn);
+    free_vector_indices ( &vi );
     xfree ( vector_seq );
     return 0;
 }